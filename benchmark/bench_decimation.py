@@ -0,0 +1,31 @@
+import numpy as np
+import fastfilters as ff
+import time
+
+
+class Timer(object):
+	def __enter__(self):
+		self.a = time.time()
+		return self
+
+	def __exit__(self, *args):
+		self.b = time.time()
+		self.delta = self.b - self.a
+
+np.random.seed(0)
+a = np.random.rand(2048, 2048).astype(np.float32)
+
+for sigma in [5, 10, 20, 30]:
+	for order in [0, 1]:
+		with Timer() as tfull:
+			full = ff.gaussianDerivative(a, sigma, order)
+
+		for decimation in [2, 4]:
+			with Timer() as tdec:
+				dec = ff.gaussianDerivative(a, sigma, order, decimation=decimation)
+
+			# errors relative to the input range, which is [0, 1)
+			err = np.abs(dec - full)
+			fact = tfull.delta / tdec.delta
+
+			print("Timing order %d derivative with sigma = %d, decimation = %d: full = %f, decimated = %f --> speedup: %f, error: max = %e, mean = %e" % (order, sigma, decimation, tfull.delta, tdec.delta, fact, err.max(), err.mean()))
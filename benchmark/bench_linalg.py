@@ -0,0 +1,36 @@
+import numpy as np
+import fastfilters as ff
+import time
+
+
+class Timer(object):
+	def __enter__(self):
+		self.a = time.time()
+		return self
+
+	def __exit__(self, *args):
+		self.b = time.time()
+		self.delta = self.b - self.a
+
+np.random.seed(0)
+a = np.random.rand(200,200,200).astype(np.float32)
+
+for sigma in [1,2,3,4,5]:
+	for name, fn, args in [("HOG", ff.hessianOfGaussianEigenvalues, (sigma,)), ("ST", ff.structureTensorEigenvalues, (sigma, 2*sigma))]:
+		full = np.empty(a.shape + (3,), dtype=np.float32)
+		fast = np.empty(a.shape + (3,), dtype=np.float32)
+
+		with Timer() as tfull:
+			fn(a, *args, out=full)
+
+		with Timer() as tfast:
+			fn(a, *args, out=fast, precision="fast")
+
+		# errors relative to the largest eigenvalue magnitude of each voxel
+		scale = np.abs(full).max(axis=-1, keepdims=True)
+		scale[scale == 0] = 1
+		err = np.abs(fast - full) / scale
+
+		fact = tfull.delta / tfast.delta
+
+		print("Timing %s 3D eigenvalues with sigma = %d:  full = %f, fast = %f --> speedup: %f, relative error: max = %e, mean = %e" % (name, sigma, tfull.delta, tfast.delta, fact, err.max(), err.mean()))
@@ -0,0 +1,371 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+// times every entry of the direct convolution jump tables, i.e. every combination of instruction set, pass direction,
+// left and right border treatment, kernel symmetry and kernel length (1 to FF_UNROLL - 1 are unrolled, longer kernels
+// use the runtime length implementation), for a list of image sizes and channel counts. the results are written as
+// JSON to stdout or the file given with --out.
+//
+// usage: fastfilters_bench [--isa plain,avx,avxfma] [--sizes 256x256,1024x1024] [--channels 1,3] [--lens 1,2,...]
+//                          [--min-time seconds] [--out file]
+//
+// gflop_per_s counts 2 * (2 * len + 1) operations per output value, which is the direct form of the convolution and
+// not what the symmetric implementations execute, so it compares kernel lengths rather than measuring the hardware.
+// gb_per_s counts one read and one write of every value.
+
+// clock_gettime
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+typedef bool (*fir_convolve_fn_t)(const float *, size_t, size_t, size_t, size_t, float *, size_t,
+                                  fastfilters_kernel_fir_t, fastfilters_border_treatment_t,
+                                  fastfilters_border_treatment_t, const float *, const float *, size_t);
+
+typedef struct {
+    const char *name;
+    bool (*supported)(void);
+    fir_convolve_fn_t inner;
+    fir_convolve_fn_t outer;
+} bench_isa_t;
+
+static bool isa_plain(void)
+{
+    return true;
+}
+
+static bool isa_avx(void)
+{
+    return fastfilters_cpu_check(FASTFILTERS_CPU_AVX);
+}
+
+static bool isa_avxfma(void)
+{
+    return fastfilters_cpu_check(FASTFILTERS_CPU_FMA);
+}
+
+static const bench_isa_t g_isas[] = {
+    {"plain", &isa_plain, &fastfilters_fir_convolve_fir_inner, &fastfilters_fir_convolve_fir_outer},
+    {"avx", &isa_avx, &fastfilters_fir_convolve_fir_inner_avx, &fastfilters_fir_convolve_fir_outer_avx},
+    {"avxfma", &isa_avxfma, &fastfilters_fir_convolve_fir_inner_avxfma, &fastfilters_fir_convolve_fir_outer_avxfma}};
+
+static const char *g_border_names[] = {"mirror", "optimistic", "ptr"};
+static const fastfilters_border_treatment_t g_borders[] = {FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_OPTIMISTIC,
+                                                           FASTFILTERS_BORDER_PTR};
+
+static const char *g_symmetry_names[] = {"symmetric", "antisymmetric", "asymmetric"};
+
+#define N_ELEMS(a) (sizeof(a) / sizeof((a)[0]))
+#define MAX_LIST 64
+
+typedef struct {
+    size_t values[MAX_LIST];
+    size_t n;
+} bench_list_t;
+
+typedef struct {
+    bench_list_t size_x, size_y;
+    bench_list_t channels;
+    bench_list_t lens;
+    const char *isas;
+    double min_time;
+    FILE *out;
+} bench_config_t;
+
+// parses "a,b,c", or "AxB,CxD" into two lists
+static bool parse_list(const char *arg, bench_list_t *first, bench_list_t *second)
+{
+    const char *p = arg;
+
+    first->n = 0;
+    if (second)
+        second->n = 0;
+
+    while (*p) {
+        char *end;
+
+        if (first->n == MAX_LIST)
+            return false;
+
+        first->values[first->n++] = strtoul(p, &end, 10);
+        if (end == p)
+            return false;
+        p = end;
+
+        if (second) {
+            if (*p++ != 'x')
+                return false;
+            second->values[second->n++] = strtoul(p, &end, 10);
+            if (end == p)
+                return false;
+            p = end;
+        }
+
+        if (*p == ',')
+            ++p;
+        else if (*p)
+            return false;
+    }
+
+    return first->n > 0;
+}
+
+// whether name is an entry of the comma separated list
+static bool list_contains(const char *list, const char *name)
+{
+    const size_t len = strlen(name);
+
+    for (const char *p = list; p; p = strchr(p, ',') ? strchr(p, ',') + 1 : NULL)
+        if (!strncmp(p, name, len) && (p[len] == ',' || p[len] == 0))
+            return true;
+
+    return false;
+}
+
+// coefficients of a kernel with the given symmetry and len coefficients on each side
+static fastfilters_kernel_fir_t bench_kernel(unsigned symmetry, size_t len)
+{
+    const size_t n_coefs = 2 * len + 1;
+    fastfilters_kernel_fir_t kernel;
+    float *coefs = malloc(n_coefs * sizeof(float));
+
+    if (!coefs)
+        return NULL;
+
+    for (size_t k = 0; k <= len; ++k) {
+        const float c = 1.0f / (float)(k + 1);
+
+        switch (symmetry) {
+        case 0:
+            coefs[len + k] = coefs[len - k] = c;
+            break;
+        case 1:
+            coefs[len + k] = c;
+            coefs[len - k] = -c;
+            coefs[len] = 0.0f;
+            break;
+        default:
+            coefs[len + k] = c;
+            coefs[len - k] = 0.5f * c;
+            break;
+        }
+    }
+
+    kernel = fastfilters_kernel_fir_create(coefs, n_coefs);
+    free(coefs);
+    return kernel;
+}
+
+// wall clock seconds, clock() would add up the time of all OpenMP threads
+static double bench_now(void)
+{
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+#endif
+}
+
+// seconds per call of the best of the rounds that each run for at least min_time / 4, negative on failure
+static double bench_time(fir_convolve_fn_t fn, bool outer, const float *in, float *out, size_t n_x, size_t n_y,
+                         size_t n_channels, size_t pad, fastfilters_kernel_fir_t kernel,
+                         fastfilters_border_treatment_t left, fastfilters_border_treatment_t right, double min_time)
+{
+    double best = -1.0;
+    double total = 0.0;
+    size_t n_calls = 1;
+
+    // the input is padded by pad pixels along the filtered axis, which is what the optimistic and ptr borders read
+    const size_t row_len = n_x * n_channels;
+    const size_t in_row = outer ? row_len : (n_x + 2 * pad) * n_channels;
+    const float *inptr = outer ? in + pad * in_row : in + pad * n_channels;
+    const size_t n_pixels = outer ? n_y : n_x;
+    const size_t pixel_stride = outer ? row_len : n_channels;
+    const size_t n_outer = outer ? row_len : n_y;
+    const size_t outer_stride = outer ? 1 : in_row;
+    const size_t border_stride = outer ? row_len : in_row;
+    const float *border_left = inptr - kernel->len * pixel_stride;
+    const float *border_right = inptr + n_pixels * pixel_stride;
+
+    while (total < min_time) {
+        const double start = bench_now();
+
+        for (size_t i = 0; i < n_calls; ++i)
+            if (!fn(inptr, n_pixels, pixel_stride, n_outer, outer_stride, out, row_len, kernel, left, right,
+                    border_left, border_right, border_stride))
+                return -1.0;
+
+        const double t = (bench_now() - start) / n_calls;
+        total += t * n_calls;
+
+        // rounds below the resolution of the clock are repeated with more calls
+        if (t > 0 && (best < 0 || t < best))
+            best = t;
+
+        if (t * n_calls < min_time / 4)
+            n_calls *= 2;
+    }
+
+    return best;
+}
+
+static void bench_run(const bench_config_t *config)
+{
+    char model[64];
+    bool first = true;
+
+    fastfilters_cpu_model(model, sizeof(model));
+    fprintf(config->out, "{\n  \"cpu\": \"%s\",\n  \"unroll\": %d,\n  \"results\": [", model, FF_UNROLL);
+
+    for (size_t s = 0; s < config->size_x.n; ++s) {
+        const size_t n_x = config->size_x.values[s];
+        const size_t n_y = config->size_y.values[s];
+
+        for (size_t c = 0; c < config->channels.n; ++c) {
+            const size_t n_channels = config->channels.values[c];
+            size_t pad = 0;
+
+            for (size_t l = 0; l < config->lens.n; ++l)
+                if (config->lens.values[l] > pad)
+                    pad = config->lens.values[l];
+
+            const size_t n_in = (n_x + 2 * pad) * (n_y + 2 * pad) * n_channels;
+            float *in = fastfilters_memory_align(32, n_in * sizeof(float));
+            float *out = fastfilters_memory_align(32, n_x * n_y * n_channels * sizeof(float));
+
+            if (!in || !out) {
+                fprintf(stderr, "out of memory for %zux%zu\n", n_x, n_y);
+                exit(1);
+            }
+
+            for (size_t i = 0; i < n_in; ++i)
+                in[i] = (float)rand() / (float)RAND_MAX;
+
+            for (size_t isa = 0; isa < N_ELEMS(g_isas); ++isa) {
+                if (!list_contains(config->isas, g_isas[isa].name) || !g_isas[isa].supported())
+                    continue;
+
+                for (unsigned outer = 0; outer <= 1; ++outer)
+                    for (unsigned symmetry = 0; symmetry < N_ELEMS(g_symmetry_names); ++symmetry)
+                        for (size_t l = 0; l < config->lens.n; ++l) {
+                            const size_t len = config->lens.values[l];
+                            const size_t n_values = n_x * n_y * n_channels;
+                            fastfilters_kernel_fir_t kernel = bench_kernel(symmetry, len);
+
+                            if (!kernel || len >= (outer ? n_y : n_x)) {
+                                if (kernel)
+                                    fastfilters_kernel_fir_free(kernel);
+                                continue;
+                            }
+
+                            for (unsigned left = 0; left < N_ELEMS(g_borders); ++left)
+                                for (unsigned right = 0; right < N_ELEMS(g_borders); ++right) {
+                                    const double t = bench_time(outer ? g_isas[isa].outer : g_isas[isa].inner,
+                                                                outer, in, out, n_x, n_y, n_channels, pad, kernel,
+                                                                g_borders[left], g_borders[right], config->min_time);
+
+                                    fprintf(config->out,
+                                            "%s\n    {\"isa\": \"%s\", \"direction\": \"%s\", \"left_border\": "
+                                            "\"%s\", \"right_border\": \"%s\", \"symmetry\": \"%s\", \"len\": %zu, "
+                                            "\"unrolled\": %s, \"n_x\": %zu, \"n_y\": %zu, \"channels\": %zu, ",
+                                            first ? "" : ",", g_isas[isa].name, outer ? "outer" : "inner",
+                                            g_border_names[left], g_border_names[right], g_symmetry_names[symmetry],
+                                            len, len < FF_UNROLL ? "true" : "false", n_x, n_y, n_channels);
+                                    first = false;
+
+                                    if (t < 0)
+                                        fprintf(config->out, "\"failed\": true}");
+                                    else
+                                        fprintf(config->out,
+                                                "\"ns_per_pixel\": %.4f, \"gb_per_s\": %.3f, \"gflop_per_s\": %.3f}",
+                                                1e9 * t / (n_x * n_y), 2.0 * sizeof(float) * n_values / t * 1e-9,
+                                                2.0 * (2 * len + 1) * n_values / t * 1e-9);
+                                    fflush(config->out);
+                                }
+
+                            fastfilters_kernel_fir_free(kernel);
+                        }
+            }
+
+            fastfilters_memory_align_free(in);
+            fastfilters_memory_align_free(out);
+        }
+    }
+
+    fprintf(config->out, "\n  ]\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+    bench_config_t config;
+
+    parse_list("256x256,1024x1024", &config.size_x, &config.size_y);
+    parse_list("1,3", &config.channels, NULL);
+    config.lens.n = 0;
+    for (size_t len = 1; len <= FF_UNROLL; ++len)
+        config.lens.values[config.lens.n++] = len;
+    config.lens.values[config.lens.n++] = 2 * FF_UNROLL;
+    config.isas = "plain,avx,avxfma";
+    config.min_time = 0.02;
+    config.out = stdout;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool ok = value != NULL;
+
+        if (ok && !strcmp(arg, "--isa"))
+            config.isas = value;
+        else if (ok && !strcmp(arg, "--sizes"))
+            ok = parse_list(value, &config.size_x, &config.size_y);
+        else if (ok && !strcmp(arg, "--channels"))
+            ok = parse_list(value, &config.channels, NULL);
+        else if (ok && !strcmp(arg, "--lens"))
+            ok = parse_list(value, &config.lens, NULL);
+        else if (ok && !strcmp(arg, "--min-time"))
+            ok = (config.min_time = atof(value)) > 0;
+        else if (ok && !strcmp(arg, "--out"))
+            ok = (config.out = fopen(value, "w")) != NULL;
+        else
+            ok = false;
+
+        if (!ok) {
+            fprintf(stderr, "usage: %s [--isa plain,avx,avxfma] [--sizes 256x256,1024x1024] [--channels 1,3] "
+                            "[--lens 1,2,...] [--min-time seconds] [--out file]\n",
+                    argv[0]);
+            return 1;
+        }
+        ++i;
+    }
+
+    fastfilters_init();
+    bench_run(&config);
+
+    if (config.out != stdout)
+        fclose(config.out);
+    return 0;
+}
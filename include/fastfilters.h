@@ -57,6 +57,11 @@ typedef struct _fastfilters_kernel_fir_t *fastfilters_kernel_fir_t;
 
 typedef enum { FASTFILTERS_CPU_AVX, FASTFILTERS_CPU_FMA, FASTFILTERS_CPU_AVX2 } fastfilters_cpu_feature_t;
 
+// FASTFILTERS_PRECISION_FAST trades accuracy for speed where an approximate kernel exists (currently the 3d
+// eigenvalues, which then have an absolute error of about 1e-4 times the eigenvalue spread, and the cascaded
+// multi-scale smoothing).
+typedef enum { FASTFILTERS_PRECISION_FULL, FASTFILTERS_PRECISION_FAST } fastfilters_precision_t;
+
 typedef struct _fastfilters_array2d_t {
     float *ptr;
     size_t n_x;
@@ -77,8 +82,36 @@ typedef struct _fastfilters_array3d_t {
     size_t n_channels;
 } fastfilters_array3d_t;
 
+typedef struct _fastfilters_roi2d_t {
+    size_t x_begin;
+    size_t x_end;
+    size_t y_begin;
+    size_t y_end;
+} fastfilters_roi2d_t;
+
+typedef struct _fastfilters_roi3d_t {
+    size_t x_begin;
+    size_t x_end;
+    size_t y_begin;
+    size_t y_end;
+    size_t z_begin;
+    size_t z_end;
+} fastfilters_roi3d_t;
+
 typedef struct _fastfilters_options_t {
     float window_ratio;
+    // physical size of a pixel along x, y and z, sigmas are given in the same unit. entries <= 0 mean 1.
+    double voxel_size[3];
+    // gaussians and their derivatives (fastfilters_fir_gaussian* and fastfilters_fir_derivative*) are evaluated on a
+    // grid decimated by this factor along every axis whose sigma is at least 2 * decimation pixels, 0 and 1 disable
+    // it. the result is interpolated back to full resolution, unless the output has the decimated shape of
+    // (n + decimation - 1) / decimation pixels along every axis (all sigmas must be large enough then). it deviates
+    // from the full resolution filter by less than 1e-3 of the input range.
+    unsigned decimation;
+    // gaussian kernels are truncated at the smallest radius that drops at most this fraction of their absolute mass
+    // instead of at 3 + order / 2 sigmas, see fastfilters_kernel_fir_gaussian_epsilon. 0 keeps the default radius,
+    // a window_ratio takes precedence.
+    double epsilon;
 } fastfilters_options_t;
 
 typedef void *(*fastfilters_alloc_fn_t)(size_t size);
@@ -90,8 +123,151 @@ void DLL_PUBLIC fastfilters_init_ex(fastfilters_alloc_fn_t alloc_fn, fastfilters
 bool DLL_PUBLIC fastfilters_cpu_check(fastfilters_cpu_feature_t feature);
 bool DLL_PUBLIC fastfilters_cpu_enable(fastfilters_cpu_feature_t feature, bool enable);
 
+// thresholds choosing between the implementations of a pass. fastfilters_init loads the values tuned for this cpu
+// from the cache file (FASTFILTERS_TUNE_CACHE, otherwise fastfilters_tune.txt in $XDG_CACHE_HOME, ~/.cache or
+// %LOCALAPPDATA%) and runs fastfilters_autotune if there are none and FASTFILTERS_AUTOTUNE=1 is set.
+typedef struct _fastfilters_tuning_t {
+    // kernels with at least this many coefficients on each side are applied in the frequency domain, along x and
+    // along y and z respectively
+    unsigned fft_min_len_inner;
+    unsigned fft_min_len_outer;
+    // rows (2d) and planes (3d) per strip of the fused gradient magnitude and laplacian, at least 8 times the kernel
+    // radius
+    unsigned reduce_strip_rows;
+    unsigned reduce_strip_planes;
+} fastfilters_tuning_t;
+
+void DLL_PUBLIC fastfilters_tuning_get(fastfilters_tuning_t *tuning);
+// zero fields (or a NULL tuning) select the built-in defaults. not to be called while filters run.
+void DLL_PUBLIC fastfilters_tuning_set(const fastfilters_tuning_t *tuning);
+// times the candidates of every threshold on 1024 x 1024 and 128^3 arrays (about a second), applies the fastest and
+// stores them for this cpu and instruction set in cache_path (NULL for the default cache file). returns false if the
+// benchmarks failed, the cache file could not be written or fastfilters_dispatch_force pinned the path. it replaces
+// the thresholds in use and is not to be called while filters run.
+bool DLL_PUBLIC fastfilters_autotune(const char *cache_path);
+
+// counters of the convolution passes, collected while enabled by fastfilters_stats_enable or FASTFILTERS_STATS=1 at
+// fastfilters_init. disabled they cost a single branch per pass.
+typedef enum {
+    // direct convolution specialised for the kernel length, available for short kernels
+    FASTFILTERS_STATS_UNROLLED,
+    // direct convolution looping over the kernel length at runtime
+    FASTFILTERS_STATS_RUNTIME_LEN,
+    // direct convolution along x of interleaved channels with avx, mostly scalar for short lines
+    FASTFILTERS_STATS_RGB,
+    // overlap-save convolution in the frequency domain
+    FASTFILTERS_STATS_FFT,
+    // several kernels applied along x to each row while it is cached (hessian, fastfilters_fir_convolve3d_multi)
+    FASTFILTERS_STATS_MULTI,
+    FASTFILTERS_STATS_N_VARIANTS
+} fastfilters_stats_variant_t;
+
+typedef struct _fastfilters_stats_pass_t {
+    uint64_t calls;
+    // wall time
+    uint64_t time_ns;
+    // output values, every channel counts
+    uint64_t pixels;
+    // values computed one at a time by the border, alignment and tail loops (all of them without avx)
+    uint64_t scalar_pixels;
+    // memory allocated by the passes, e.g. the ring buffer of the outer passes
+    uint64_t scratch_bytes;
+} fastfilters_stats_pass_t;
+
+typedef struct _fastfilters_stats_t {
+    // passes along x ([0]) and along y and z ([1]) by the implementation that ran them
+    fastfilters_stats_pass_t passes[2][FASTFILTERS_STATS_N_VARIANTS];
+} fastfilters_stats_t;
+
+void DLL_PUBLIC fastfilters_stats_enable(bool enable);
+// sums since fastfilters_init or the last fastfilters_stats_reset over all threads
+void DLL_PUBLIC fastfilters_stats_get(fastfilters_stats_t *stats);
+void DLL_PUBLIC fastfilters_stats_reset(void);
+
+// memory allocated by the library through the allocator of fastfilters_init_ex: the temporaries of the filters, the
+// scratch buffers of the passes, kernels and arrays from fastfilters_array*_alloc. the global counters cover all
+// threads, the thread counters the calling one. memory freed by another thread than the one that allocated it is
+// subtracted from the current bytes of the freeing thread, which can become negative.
+typedef struct _fastfilters_memory_stats_t {
+    // allocated and not freed yet
+    int64_t current_bytes;
+    // maximum of current_bytes since fastfilters_init or the last fastfilters_memory_stats_reset
+    int64_t peak_bytes;
+    uint64_t allocations;
+    uint64_t largest_bytes;
+} fastfilters_memory_stats_t;
+
+// either pointer may be NULL
+void DLL_PUBLIC fastfilters_memory_stats_get(fastfilters_memory_stats_t *global, fastfilters_memory_stats_t *thread);
+// restarts the peaks at the current bytes and clears the other counters, globally and for the calling thread
+// safe to call while filters run on other threads
+void DLL_PUBLIC fastfilters_memory_stats_reset(void);
+
+// writes begin and end events of the filters and of every convolution pass in the chrome trace format
+// (chrome://tracing, ui.perfetto.dev) to path until fastfilters_trace_stop. events carry the thread and the bytes
+// read and written. FASTFILTERS_TRACE=<path> starts a trace at fastfilters_init that is closed at exit. neither is
+// to be called while filters run.
+bool DLL_PUBLIC fastfilters_trace_start(const char *path);
+void DLL_PUBLIC fastfilters_trace_stop(void);
+
+// border treatment of a single convolution pass. the filters mirror at the borders, optimistic reads the pixels
+// beyond the line and ptr reads them from a separate buffer.
+typedef enum {
+    FASTFILTERS_BORDER_MIRROR,
+    FASTFILTERS_BORDER_OPTIMISTIC,
+    FASTFILTERS_BORDER_PTR
+} fastfilters_border_treatment_t;
+
+typedef enum {
+    // best tier the processor supports
+    FASTFILTERS_ISA_AUTO,
+    FASTFILTERS_ISA_PLAIN,
+    FASTFILTERS_ISA_AVX,
+    FASTFILTERS_ISA_AVXFMA
+} fastfilters_isa_t;
+
+typedef enum {
+    // fft for kernels longer than the tuned thresholds, otherwise the direct convolution
+    FASTFILTERS_PATH_AUTO,
+    // direct convolution only
+    FASTFILTERS_PATH_DIRECT,
+    // direct convolution looping over the kernel length at runtime, also for kernels with an unrolled version
+    FASTFILTERS_PATH_RUNTIME_LEN,
+    // fft for every kernel it supports, i.e. except for mirrored lines not longer than the kernel
+    FASTFILTERS_PATH_FFT
+} fastfilters_path_t;
+
+typedef struct _fastfilters_dispatch_t {
+    // tier of the direct convolution or of the fft butterflies
+    fastfilters_isa_t isa;
+    // the entry of fastfilters_stats_t the pass is counted in
+    fastfilters_stats_variant_t variant;
+    // e.g. avxfma_outer_mirror_mirror_symmetric_4 (kernel length 4), avx_inner_ptr_mirror_asymmetric_N (runtime
+    // length) or plain_inner_fft
+    char name[64];
+} fastfilters_dispatch_t;
+
+// pins the convolution passes to an instruction set tier and implementation, e.g. to benchmark every tier on one
+// machine. returns false and changes nothing if the processor (or fastfilters_cpu_enable) does not allow the tier.
+// FASTFILTERS_FORCE_ISA=plain, avx or avxfma pins the tier at fastfilters_init. not to be called while filters run.
+bool DLL_PUBLIC fastfilters_dispatch_force(fastfilters_isa_t isa, fastfilters_path_t path);
+// implementation a pass of kernel along x (outer = false) or along y and z (outer = true) over lines of n_pixels
+// pixels with n_channels interleaved channels runs with the current dispatch, false for unsupported borders
+bool DLL_PUBLIC fastfilters_dispatch_query(const fastfilters_kernel_fir_t kernel,
+                                           fastfilters_border_treatment_t left_border,
+                                           fastfilters_border_treatment_t right_border, bool outer, size_t n_pixels,
+                                           size_t n_channels, fastfilters_dispatch_t *dispatch);
+
 fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian(unsigned int order, double sigma,
                                                                     float window_ratio);
+// truncated at the smallest radius whose dropped coefficients hold at most epsilon (0 < epsilon < 1) of the absolute
+// mass of the kernel, and renormalised. the truncation error is about epsilon times the input range; epsilon = 1e-2
+// gives a radius of about 2.6 sigma for order 0, 3.0 for order 1 and 3.4 for order 2.
+fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian_epsilon(unsigned int order, double sigma,
+                                                                            double epsilon);
+// arbitrary kernel applied as a correlation, out[i] = sum_j coefs[j] * in[i + j - n_coefs / 2]. even lengths are padded
+// with a zero at the end. symmetric and antisymmetric kernels are detected and use the faster code paths.
+fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_create(const float *coefs, size_t n_coefs);
 unsigned int DLL_PUBLIC fastfilters_kernel_fir_get_length(fastfilters_kernel_fir_t kernel);
 void DLL_PUBLIC fastfilters_kernel_fir_free(fastfilters_kernel_fir_t kernel);
 
@@ -103,11 +279,60 @@ bool DLL_PUBLIC fastfilters_fir_convolve3d(const fastfilters_array3d_t *inarray,
                                            const fastfilters_kernel_fir_t kernelz,
                                            const fastfilters_array3d_t *outarray, const fastfilters_options_t *options);
 
+// convolves the pixel-wise product a * b without storing it
+bool DLL_PUBLIC fastfilters_fir_convolve2d_mul(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b,
+                                               const fastfilters_kernel_fir_t kernelx,
+                                               const fastfilters_kernel_fir_t kernely,
+                                               const fastfilters_array2d_t *outarray,
+                                               const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_convolve3d_mul(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b,
+                                               const fastfilters_kernel_fir_t kernelx,
+                                               const fastfilters_kernel_fir_t kernely,
+                                               const fastfilters_kernel_fir_t kernelz,
+                                               const fastfilters_array3d_t *outarray,
+                                               const fastfilters_options_t *options);
+
+// recompute the part of outarray affected by the half-open dirty region of inarray; outarray has to hold the result of
+// a previous convolution with the same kernels. updated (may be NULL) receives the region that was written.
+bool DLL_PUBLIC fastfilters_fir_convolve2d_update(const fastfilters_array2d_t *inarray,
+                                                  const fastfilters_roi2d_t *dirty,
+                                                  const fastfilters_kernel_fir_t kernelx,
+                                                  const fastfilters_kernel_fir_t kernely,
+                                                  const fastfilters_array2d_t *outarray, fastfilters_roi2d_t *updated,
+                                                  const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_convolve3d_update(const fastfilters_array3d_t *inarray,
+                                                  const fastfilters_roi3d_t *dirty,
+                                                  const fastfilters_kernel_fir_t kernelx,
+                                                  const fastfilters_kernel_fir_t kernely,
+                                                  const fastfilters_kernel_fir_t kernelz,
+                                                  const fastfilters_array3d_t *outarray, fastfilters_roi3d_t *updated,
+                                                  const fastfilters_options_t *options);
+
 void DLL_PUBLIC fastfilters_linalg_ev2d(const float *xx, const float *xy, const float *yy, float *ev_small,
                                         float *ev_big, const size_t len);
 void DLL_PUBLIC fastfilters_linalg_ev3d(const float *a00, const float *a01, const float *a02, const float *a11,
                                         const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
                                         const size_t len);
+// the 3d eigenvalues take a precision, fastfilters_linalg_ev3d is fastfilters_linalg_ev3d_ex with
+// FASTFILTERS_PRECISION_FULL. the 2d eigenvalues have a cheap closed form and no fast variant.
+void DLL_PUBLIC fastfilters_linalg_ev3d_ex(const float *a00, const float *a01, const float *a02, const float *a11,
+                                           const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                           const size_t len, fastfilters_precision_t precision);
+
+// same as above, but the eigenvalues of each pixel are stored next to each other (ev[2 * i], ev[2 * i + 1] and
+// ev[3 * i], ev[3 * i + 1], ev[3 * i + 2]) in the order of the planar outputs.
+void DLL_PUBLIC fastfilters_linalg_ev2d_interleaved(const float *xx, const float *xy, const float *yy, float *ev,
+                                                    const size_t len);
+void DLL_PUBLIC fastfilters_linalg_ev3d_interleaved(const float *a00, const float *a01, const float *a02,
+                                                    const float *a11, const float *a12, const float *a22, float *ev,
+                                                    const size_t len, fastfilters_precision_t precision);
+// pixel i is stored at ev[i * ev_stride], e.g. in the columns of a (pixels x features) matrix. ev_stride has to be
+// at least the number of eigenvalues.
+void DLL_PUBLIC fastfilters_linalg_ev2d_strided(const float *xx, const float *xy, const float *yy, float *ev,
+                                                size_t ev_stride, const size_t len);
+void DLL_PUBLIC fastfilters_linalg_ev3d_strided(const float *a00, const float *a01, const float *a02,
+                                                const float *a11, const float *a12, const float *a22, float *ev,
+                                                size_t ev_stride, const size_t len, fastfilters_precision_t precision);
 
 void DLL_PUBLIC fastfilters_combine_add2d(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b,
                                           fastfilters_array2d_t *out);
@@ -124,6 +349,12 @@ void DLL_PUBLIC fastfilters_combine_mul2d(const fastfilters_array2d_t *a, const
 void DLL_PUBLIC fastfilters_combine_mul3d(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b,
                                           fastfilters_array3d_t *out);
 
+// out = a * b + c
+void DLL_PUBLIC fastfilters_combine_muladd2d(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b,
+                                             const fastfilters_array2d_t *c, fastfilters_array2d_t *out);
+void DLL_PUBLIC fastfilters_combine_muladd3d(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b,
+                                             const fastfilters_array3d_t *c, fastfilters_array3d_t *out);
+
 DLL_PUBLIC fastfilters_array2d_t *fastfilters_array2d_alloc(size_t n_x, size_t n_y, size_t channels);
 DLL_PUBLIC void fastfilters_array2d_free(fastfilters_array2d_t *v);
 
@@ -162,6 +393,66 @@ bool DLL_PUBLIC fastfilters_fir_structure_tensor3d(const fastfilters_array3d_t *
                                                    fastfilters_array3d_t *out_yy, fastfilters_array3d_t *out_zz,
                                                    fastfilters_array3d_t *out_xy, fastfilters_array3d_t *out_xz,
                                                    fastfilters_array3d_t *out_yz, const fastfilters_options_t *options);
+
+// anisotropic variants: sigma points to one scale per axis, starting with x
+bool DLL_PUBLIC fastfilters_fir_gaussian2d_aniso(const fastfilters_array2d_t *inarray, unsigned order,
+                                                 const double *sigma, fastfilters_array2d_t *outarray,
+                                                 const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_gaussian3d_aniso(const fastfilters_array3d_t *inarray, unsigned order,
+                                                 const double *sigma, fastfilters_array3d_t *outarray,
+                                                 const fastfilters_options_t *options);
+
+bool DLL_PUBLIC fastfilters_fir_hog2d_aniso(const fastfilters_array2d_t *inarray, const double *sigma,
+                                            fastfilters_array2d_t *out_xx, fastfilters_array2d_t *out_xy,
+                                            fastfilters_array2d_t *out_yy, const fastfilters_options_t *options);
+DLL_PUBLIC bool fastfilters_fir_hog3d_aniso(const fastfilters_array3d_t *inarray, const double *sigma,
+                                            fastfilters_array3d_t *out_xx, fastfilters_array3d_t *out_yy,
+                                            fastfilters_array3d_t *out_zz, fastfilters_array3d_t *out_xy,
+                                            fastfilters_array3d_t *out_xz, fastfilters_array3d_t *out_yz,
+                                            const fastfilters_options_t *options);
+
+bool DLL_PUBLIC fastfilters_fir_gradmag2d_aniso(const fastfilters_array2d_t *inarray, const double *sigma,
+                                                fastfilters_array2d_t *outarray, const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_gradmag3d_aniso(const fastfilters_array3d_t *inarray, const double *sigma,
+                                                fastfilters_array3d_t *outarray, const fastfilters_options_t *options);
+
+bool DLL_PUBLIC fastfilters_fir_laplacian2d_aniso(const fastfilters_array2d_t *inarray, const double *sigma,
+                                                  fastfilters_array2d_t *outarray,
+                                                  const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_laplacian3d_aniso(const fastfilters_array3d_t *inarray, const double *sigma,
+                                                  fastfilters_array3d_t *outarray,
+                                                  const fastfilters_options_t *options);
+
+bool DLL_PUBLIC fastfilters_fir_structure_tensor2d_aniso(const fastfilters_array2d_t *inarray,
+                                                         const double *sigma_outer, const double *sigma_inner,
+                                                         fastfilters_array2d_t *out_xx, fastfilters_array2d_t *out_xy,
+                                                         fastfilters_array2d_t *out_yy,
+                                                         const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_structure_tensor3d_aniso(const fastfilters_array3d_t *inarray,
+                                                         const double *sigma_outer, const double *sigma_inner,
+                                                         fastfilters_array3d_t *out_xx, fastfilters_array3d_t *out_yy,
+                                                         fastfilters_array3d_t *out_zz, fastfilters_array3d_t *out_xy,
+                                                         fastfilters_array3d_t *out_xz, fastfilters_array3d_t *out_yz,
+                                                         const fastfilters_options_t *options);
+
+// smooths the input with every sigma in sigmas into outarrays[i]. with FASTFILTERS_PRECISION_FAST, each scale is
+// computed from the previous one if the sigmas increase, which needs far fewer taps for long series.
+bool DLL_PUBLIC fastfilters_fir_gaussian2d_multiscale(const fastfilters_array2d_t *inarray, const double *sigmas,
+                                                      size_t n_scales, fastfilters_precision_t precision,
+                                                      fastfilters_array2d_t *const *outarrays,
+                                                      const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_gaussian3d_multiscale(const fastfilters_array3d_t *inarray, const double *sigmas,
+                                                      size_t n_scales, fastfilters_precision_t precision,
+                                                      fastfilters_array3d_t *const *outarrays,
+                                                      const fastfilters_options_t *options);
+
+// gaussian derivative with a separate derivative order and sigma for every axis, both starting with x
+bool DLL_PUBLIC fastfilters_fir_derivative2d(const fastfilters_array2d_t *inarray, const unsigned *order,
+                                             const double *sigma, fastfilters_array2d_t *outarray,
+                                             const fastfilters_options_t *options);
+bool DLL_PUBLIC fastfilters_fir_derivative3d(const fastfilters_array3d_t *inarray, const unsigned *order,
+                                             const double *sigma, fastfilters_array3d_t *outarray,
+                                             const fastfilters_options_t *options);
 #ifdef __cplusplus
 }
 #endif
@@ -87,4 +87,28 @@ DLL_PUBLIC void fastfilters_array3d_free(fastfilters_array3d_t *v)
 {
     fastfilters_memory_free(v->ptr);
     fastfilters_memory_free(v);
-}
\ No newline at end of file
+}
+
+void DLL_LOCAL fastfilters_array2d_copy(const fastfilters_array2d_t *from, const fastfilters_array2d_t *to)
+{
+    for (size_t y = 0; y < from->n_y; ++y) {
+        const float *inptr = from->ptr + y * from->stride_y;
+        float *outptr = to->ptr + y * to->stride_y;
+
+        for (size_t x = 0; x < from->n_x; ++x)
+            for (size_t c = 0; c < from->n_channels; ++c)
+                outptr[x * to->stride_x + c] = inptr[x * from->stride_x + c];
+    }
+}
+
+void DLL_LOCAL fastfilters_array3d_copy(const fastfilters_array3d_t *from, const fastfilters_array3d_t *to)
+{
+    for (size_t z = 0; z < from->n_z; ++z) {
+        const fastfilters_array2d_t from_plane = {from->ptr + z * from->stride_z, from->n_x, from->n_y,
+                                                  from->stride_x, from->stride_y, from->n_channels};
+        const fastfilters_array2d_t to_plane = {to->ptr + z * to->stride_z, to->n_x, to->n_y,
+                                                to->stride_x, to->stride_y, to->n_channels};
+
+        fastfilters_array2d_copy(&from_plane, &to_plane);
+    }
+}
@@ -759,8 +759,12 @@ _PS256_CONST(atan2_mpi2, M_PI / 2.0);
 
 #ifdef __FMA__
 #define _avxfun_fmadd(a, b, c) _mm256_fmadd_ps((a), (b), (c))
+#define _avxfun_fmsub(a, b, c) _mm256_fmsub_ps((a), (b), (c))
+#define _avxfun_fnmadd(a, b, c) _mm256_fnmadd_ps((a), (b), (c))
 #else
 #define _avxfun_fmadd(a, b, c) (_mm256_add_ps(_mm256_mul_ps((a), (b)), (c)))
+#define _avxfun_fmsub(a, b, c) (_mm256_sub_ps(_mm256_mul_ps((a), (b)), (c)))
+#define _avxfun_fnmadd(a, b, c) (_mm256_sub_ps((c), _mm256_mul_ps((a), (b))))
 #endif
 
 // https://github.com/hfinkel/sleef-bgq/blob/df6154525243b899b81d25962aa337fc9a94b2ba/purec/sleefdp.c#L442
@@ -877,7 +881,6 @@ static inline __m256 atan2_256_ps(__m256 y, __m256 x)
     return t;
 }
 
-#undef _avxfun_fmadd
 #undef _PS256_GET_CONST
 
 #endif
\ No newline at end of file
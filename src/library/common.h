@@ -54,12 +54,27 @@ extern "C" {
 
 #define ARRAY_LENGTH(x) (sizeof((x)) / sizeof((x)[0]))
 
+#ifdef _MSC_VER
+#define FF_THREAD_LOCAL __declspec(thread)
+#else
+#define FF_THREAD_LOCAL __thread
+#endif
+
 typedef bool (*impl_fn_t)(const float *, const float *, const float *, size_t, size_t, size_t, size_t, float *, size_t,
                           size_t, const fastfilters_kernel_fir_t kernel);
 
+// values match the symmetry parameter of the convolution jump tables
+typedef enum {
+    FASTFILTERS_KERNEL_ANTISYMMETRIC,
+    FASTFILTERS_KERNEL_SYMMETRIC,
+    FASTFILTERS_KERNEL_ASYMMETRIC
+} fastfilters_kernel_symmetry_t;
+
+// coefs[k] is applied to pixel i + k. (anti-)symmetric kernels store len + 1 coefficients, asymmetric ones store
+// the taps for pixel i - k in coefs[len + k] as well.
 struct _fastfilters_kernel_fir_t {
     size_t len;
-    bool is_symmetric;
+    fastfilters_kernel_symmetry_t symmetry;
     float *coefs;
 
     impl_fn_t fn_inner_mirror;
@@ -69,15 +84,15 @@ struct _fastfilters_kernel_fir_t {
     impl_fn_t fn_outer_mirror;
     impl_fn_t fn_outer_ptr;
     impl_fn_t fn_outer_optimistic;
-};
 
-typedef enum {
-    FASTFILTERS_BORDER_MIRROR,
-    FASTFILTERS_BORDER_OPTIMISTIC,
-    FASTFILTERS_BORDER_PTR
-} fastfilters_border_treatment_t;
+    // the functions above are looked up again when these differ from fastfilters_fir_generation
+    unsigned fn_inner_generation;
+    unsigned fn_outer_generation;
+};
 
 void DLL_LOCAL fastfilters_cpu_init(void);
+// processor brand string, "unknown" if the cpu does not report one
+void DLL_LOCAL fastfilters_cpu_model(char *buf, size_t len);
 void DLL_LOCAL fastfilters_linalg_init(void);
 
 void DLL_LOCAL fastfilters_memory_init(fastfilters_alloc_fn_t alloc_fn, fastfilters_free_fn_t free_fn);
@@ -88,8 +103,69 @@ void DLL_LOCAL fastfilters_memory_free(void *ptr);
 void DLL_LOCAL *fastfilters_memory_align(size_t alignment, size_t size);
 void DLL_LOCAL fastfilters_memory_align_free(void *ptr);
 
+// bytes ever allocated by the calling thread
+uint64_t DLL_LOCAL fastfilters_memory_thread_allocated(void);
+
+void DLL_LOCAL fastfilters_stats_init(void);
+bool DLL_LOCAL fastfilters_stats_enabled(void);
+void DLL_LOCAL fastfilters_stats_add(bool outer, fastfilters_stats_variant_t variant,
+                                     const fastfilters_stats_pass_t *pass);
+// monotonic wall clock
+uint64_t DLL_LOCAL fastfilters_time_ns(void);
+
+// events of fastfilters_trace_start, ignored while no trace is written
+void DLL_LOCAL fastfilters_trace_init(void);
+bool DLL_LOCAL fastfilters_trace_enabled(void);
+void DLL_LOCAL fastfilters_trace_begin(const char *category, const char *name, uint64_t bytes);
+void DLL_LOCAL fastfilters_trace_end(const char *category, const char *name);
+
+void DLL_LOCAL fastfilters_array2d_copy(const fastfilters_array2d_t *from, const fastfilters_array2d_t *to);
+void DLL_LOCAL fastfilters_array3d_copy(const fastfilters_array3d_t *from, const fastfilters_array3d_t *to);
+
+void DLL_LOCAL fastfilters_combine_mul_row(const float *a, const float *b, float *out, size_t len);
+
 void DLL_LOCAL fastfilters_fir_init(void);
+// tier (never FASTFILTERS_ISA_AUTO) and path the convolution passes are dispatched to
+fastfilters_isa_t DLL_LOCAL fastfilters_fir_isa(void);
+fastfilters_path_t DLL_LOCAL fastfilters_fir_path(void);
+// changes with every fastfilters_dispatch_force
+unsigned DLL_LOCAL fastfilters_fir_generation(void);
+
+// built-in defaults of fastfilters_tuning_t, see fir_fft.c and fastfilters_fir_convolve3d_reduce
+#define FFT_MIN_KERNEL_LEN 20
+#define REDUCE_STRIP_ROWS 64
+#define REDUCE_STRIP_PLANES 16
 
+void DLL_LOCAL fastfilters_tune_init(void);
+const fastfilters_tuning_t DLL_LOCAL *fastfilters_tuning(void);
+
+bool DLL_LOCAL fastfilters_fir_convolve3d_products(const fastfilters_array3d_t *const *in, const unsigned (*pairs)[2],
+                                                   unsigned n_products, const fastfilters_kernel_fir_t kernelx,
+                                                   const fastfilters_kernel_fir_t kernely,
+                                                   const fastfilters_kernel_fir_t kernelz,
+                                                   const fastfilters_array3d_t *const *out);
+
+bool DLL_LOCAL fastfilters_fir_convolve3d_reduce(const fastfilters_array3d_t *in,
+                                                 const fastfilters_kernel_fir_t (*kernels)[3], bool do_sqrt,
+                                                 const fastfilters_array3d_t *out);
+
+bool DLL_LOCAL fastfilters_fir_convolve3d_multi(const fastfilters_array3d_t *in,
+                                                const fastfilters_kernel_fir_t (*kernels)[3], unsigned n_sets,
+                                                const fastfilters_array3d_t *const *out);
+
+bool DLL_LOCAL fastfilters_fir_derivative_decimated(const fastfilters_array3d_t *in, unsigned n_axes,
+                                                    const unsigned *order, const double *sigma,
+                                                    const fastfilters_array3d_t *out,
+                                                    const fastfilters_options_t *options);
+
+void DLL_LOCAL fastfilters_kernel_fir_scale(fastfilters_kernel_fir_t kernel, double factor);
+
+// gaussian kernel truncated as requested by the window_ratio or epsilon option
+fastfilters_kernel_fir_t DLL_LOCAL fastfilters_kernel_fir_gaussian_opt(unsigned int order, double sigma,
+                                                                       const fastfilters_options_t *options);
+
+// lines with an optimistic or ptr border need at least 2 * len pixels. shorter ones stay within their buffers but are
+// not filtered correctly.
 bool DLL_LOCAL fastfilters_fir_convolve_fir_inner(const float *inptr, size_t n_pixels, size_t pixel_stride,
                                                   size_t n_outer, size_t outer_stride, float *outptr,
                                                   size_t outptr_stride, fastfilters_kernel_fir_t kernel,
@@ -134,6 +210,77 @@ bool DLL_LOCAL fastfilters_fir_convolve_fir_outer_avxfma(const float *inptr, siz
                                                          const float *borderptr_left, const float *borderptr_right,
                                                          size_t border_outer_stride);
 
+// applies every kernel to one row into outptr[k]. line starts len mirrored pixels before the row and ends len pixels
+// after it, len is at least the length of every kernel.
+void DLL_LOCAL fastfilters_fir_convolve_fir_line_multi(const float *line, size_t n_pixels, size_t pixel_stride,
+                                                       size_t len, float *const *outptr,
+                                                       const fastfilters_kernel_fir_t *kernels, unsigned n_kernels);
+void DLL_LOCAL fastfilters_fir_convolve_fir_line_multi_avx(const float *line, size_t n_pixels, size_t pixel_stride,
+                                                           size_t len, float *const *outptr,
+                                                           const fastfilters_kernel_fir_t *kernels,
+                                                           unsigned n_kernels);
+void DLL_LOCAL fastfilters_fir_convolve_fir_line_multi_avxfma(const float *line, size_t n_pixels, size_t pixel_stride,
+                                                              size_t len, float *const *outptr,
+                                                              const fastfilters_kernel_fir_t *kernels,
+                                                              unsigned n_kernels);
+
+// out[i] = sum_k weights[k] * rows[k][i] for i < len, used to resample along an axis
+void DLL_LOCAL fastfilters_fir_weighted_sum(const float *const *rows, const float *weights, unsigned n_rows, float *out,
+                                            size_t len);
+void DLL_LOCAL fastfilters_fir_sum_rows(const float *const *rows, const float *weights, unsigned n_rows, float *out,
+                                        size_t len);
+void DLL_LOCAL fastfilters_fir_sum_rows_avx(const float *const *rows, const float *weights, unsigned n_rows, float *out,
+                                            size_t len);
+void DLL_LOCAL fastfilters_fir_sum_rows_avxfma(const float *const *rows, const float *weights, unsigned n_rows,
+                                               float *out, size_t len);
+
+// twiddle factors and kernel spectrum of the overlap-save convolution in fir_fft.c. the blocks hold FFT_LANES
+// signals in the real and FFT_LANES in the imaginary part, sample k of lane l at re/im[k * FFT_LANES + l].
+#define FFT_LANES 8
+
+typedef struct {
+    size_t n_fft;
+    float *twiddle_re;
+    float *twiddle_im;
+    float *kernel_re;
+    float *kernel_im;
+} fastfilters_fft_plan_t;
+
+// circular convolution of a block of n_fft samples with the kernel of plan, in place
+void DLL_LOCAL fastfilters_fir_fft_block(const fastfilters_fft_plan_t *plan, float *re, float *im);
+void DLL_LOCAL fastfilters_fir_convolve_fft_block(const fastfilters_fft_plan_t *plan, float *re, float *im);
+void DLL_LOCAL fastfilters_fir_convolve_fft_block_avx(const fastfilters_fft_plan_t *plan, float *re, float *im);
+void DLL_LOCAL fastfilters_fir_convolve_fft_block_avxfma(const fastfilters_fft_plan_t *plan, float *re, float *im);
+
+// whether kernel is applied to lines of n_pixels pixels by fastfilters_fir_convolve_fft_inner (outer = false) or
+// fastfilters_fir_convolve_fft_outer, by the tuned thresholds unless fastfilters_dispatch_force pinned the path
+bool DLL_LOCAL fastfilters_fir_fft_preferred(const fastfilters_kernel_fir_t kernel, size_t n_pixels,
+                                             fastfilters_border_treatment_t left_border,
+                                             fastfilters_border_treatment_t right_border, bool outer);
+
+bool DLL_LOCAL fastfilters_fir_convolve_fft_inner(const float *inptr, size_t n_pixels, size_t pixel_stride,
+                                                  size_t n_outer, size_t outer_stride, float *outptr,
+                                                  size_t outptr_stride, fastfilters_kernel_fir_t kernel,
+                                                  fastfilters_border_treatment_t left_border,
+                                                  fastfilters_border_treatment_t right_border,
+                                                  const float *borderptr_left, const float *borderptr_right,
+                                                  size_t border_outer_stride);
+bool DLL_LOCAL fastfilters_fir_convolve_fft_outer(const float *inptr, size_t n_pixels, size_t pixel_stride,
+                                                  size_t n_outer, size_t outer_stride, float *outptr,
+                                                  size_t outptr_stride, fastfilters_kernel_fir_t kernel,
+                                                  fastfilters_border_treatment_t left_border,
+                                                  fastfilters_border_treatment_t right_border,
+                                                  const float *borderptr_left, const float *borderptr_right,
+                                                  size_t border_outer_stride);
+
+// views a 2d array as a 3d array with a single plane
+static inline fastfilters_array3d_t array2d_as_3d(const fastfilters_array2d_t *a)
+{
+    fastfilters_array3d_t res = {a->ptr, a->n_x, a->n_y, 1, a->stride_x, a->stride_y, a->n_y * a->stride_y,
+                                 a->n_channels};
+    return res;
+}
+
 static inline double opt_window_ratio(const fastfilters_options_t *options)
 {
     if (!options)
@@ -141,6 +288,27 @@ static inline double opt_window_ratio(const fastfilters_options_t *options)
     return options->window_ratio;
 }
 
+static inline double opt_epsilon(const fastfilters_options_t *options)
+{
+    if (!options)
+        return 0.0;
+    return options->epsilon;
+}
+
+static inline unsigned opt_decimation(const fastfilters_options_t *options)
+{
+    if (!options)
+        return 1;
+    return options->decimation;
+}
+
+static inline double opt_voxel_size(const fastfilters_options_t *options, unsigned axis)
+{
+    if (!options || options->voxel_size[axis] <= 0.0)
+        return 1.0;
+    return options->voxel_size[axis];
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,6 +22,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 
 #ifdef HAVE_CPUID_H
 #include <cpuid.h>
@@ -55,7 +57,8 @@ static inline int get_cpuid(unsigned int level, cpuid_t *id)
 {
 #if defined(HAVE_CPUID_H) || defined(HAVE_ASM_CPUID)
 
-    if ((unsigned int)__get_cpuid_max(0, NULL) < level)
+    // basic and extended leaves have separate maxima
+    if ((unsigned int)__get_cpuid_max(level & 0x80000000, NULL) < level)
         return 0;
 
     __cpuid_count(level, 0, id->eax, id->ebx, id->ecx, id->edx);
@@ -271,4 +274,34 @@ bool DLL_PUBLIC fastfilters_cpu_check(fastfilters_cpu_feature_t feature)
     default:
         return false;
     }
-}
\ No newline at end of file
+}
+
+void DLL_LOCAL fastfilters_cpu_model(char *buf, size_t len)
+{
+    char brand[49];
+    const char *start = brand;
+    size_t n = 0;
+    cpuid_t id;
+
+    if (get_cpuid(0x80000000, &id) && id.eax >= 0x80000004) {
+        for (unsigned int level = 0x80000002; level <= 0x80000004; ++level) {
+            if (!get_cpuid(level, &id))
+                break;
+            memcpy(brand + n, &id, 16);
+            n += 16;
+        }
+    }
+    brand[n] = 0;
+
+    // the brand string is padded with spaces
+    while (*start == ' ')
+        ++start;
+    n = strlen(start);
+    while (n > 0 && start[n - 1] == ' ')
+        --n;
+
+    if (n == 0)
+        snprintf(buf, len, "unknown");
+    else
+        snprintf(buf, len, "%.*s", (int)n, start);
+}
@@ -29,6 +29,9 @@ void DLL_PUBLIC fastfilters_init_ex(fastfilters_alloc_fn_t alloc_fn, fastfilters
     fastfilters_memory_init(alloc_fn, free_fn);
     fastfilters_linalg_init();
     fastfilters_fir_init();
+    fastfilters_tune_init();
+    fastfilters_stats_init();
+    fastfilters_trace_init();
 }
 
 void DLL_PUBLIC fastfilters_init(void)
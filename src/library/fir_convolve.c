@@ -19,6 +19,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "fastfilters.h"
 #include "common.h"
@@ -27,36 +30,443 @@ typedef bool (*fir_convolve_fn_t)(const float *, size_t, size_t, size_t, size_t,
                                   fastfilters_kernel_fir_t, fastfilters_border_treatment_t,
                                   fastfilters_border_treatment_t, const float *, const float *, size_t);
 
+typedef void (*fir_convolve_multi_fn_t)(const float *, size_t, size_t, size_t, float *const *,
+                                        const fastfilters_kernel_fir_t *, unsigned);
+typedef void (*fir_sum_rows_fn_t)(const float *const *, const float *, unsigned, float *, size_t);
+typedef void (*fir_fft_block_fn_t)(const fastfilters_fft_plan_t *, float *, float *);
+
 static fir_convolve_fn_t g_convolve_inner = NULL;
 static fir_convolve_fn_t g_convolve_outer = NULL;
+static fir_convolve_fn_t g_fir_inner = NULL;
+static fir_convolve_fn_t g_fir_outer = NULL;
+static fir_convolve_multi_fn_t g_convolve_line_multi = NULL;
+static fir_sum_rows_fn_t g_sum_rows = NULL;
+static fir_fft_block_fn_t g_fft_block = NULL;
+
+static fastfilters_isa_t g_isa = FASTFILTERS_ISA_PLAIN;
+static fastfilters_path_t g_path = FASTFILTERS_PATH_AUTO;
+// kernels cache the functions of the jump tables until the dispatch changes
+static unsigned g_generation = 1;
+
+static const char *const g_isa_names[] = {"auto", "plain", "avx", "avxfma"};
+static const char *const g_border_names[] = {"mirror", "optimistic", "ptr"};
+static const char *const g_symmetry_names[] = {"antisymmetric", "symmetric", "asymmetric"};
+static const char *const g_pass_names[2][FASTFILTERS_STATS_N_VARIANTS] = {
+    {"inner unrolled", "inner runtime_len", "inner rgb", "inner fft", "inner multi"},
+    {"outer unrolled", "outer runtime_len", "outer rgb", "outer fft", "outer multi"}};
+
+// values of a pass computed by scalar loops. the avx passes along x follow the loop bounds of
+// fir_convolve_avx_impl.c, the ones along y and z vectorise across the rows, their border rows included.
+static size_t stats_scalar_pixels(fir_convolve_fn_t fn, bool outer, size_t n_pixels, size_t pixel_stride,
+                                  size_t n_outer, fastfilters_kernel_fir_t kernel,
+                                  fastfilters_border_treatment_t left_border,
+                                  fastfilters_border_treatment_t right_border)
+{
+    static const size_t rgb_step[6] = {4, 8, 2, 8, 4, 8};
+    const size_t len = kernel->len;
+    const size_t n_values = n_pixels * n_outer * (outer ? 1 : pixel_stride);
+
+    if (fn == &fastfilters_fir_convolve_fft_inner || fn == &fastfilters_fir_convolve_fft_outer || len == 0)
+        return 0;
+    if (fn == &fastfilters_fir_convolve_fir_inner || fn == &fastfilters_fir_convolve_fir_outer)
+        return n_values;
+    if (outer)
+        return 0;
+    if (n_pixels <= len)
+        return n_values;
+
+    const size_t x_align = ((left_border == FASTFILTERS_BORDER_OPTIMISTIC ? 0 : len) + 7) & ~(size_t)7;
+    const size_t end = right_border == FASTFILTERS_BORDER_OPTIMISTIC ? n_pixels : n_pixels - len;
+    size_t vector = 0;
+
+    if (pixel_stride == 1) {
+        const size_t avx_end = right_border == FASTFILTERS_BORDER_OPTIMISTIC ? end & ~(size_t)7 : end & ~(size_t)31;
+
+        if (avx_end > ((x_align + 31) & ~(size_t)31))
+            vector = avx_end - x_align;
+    } else if (pixel_stride < 8 && (end & ~(size_t)7) > 32) {
+        const size_t avx_end = (end & ~(size_t)7) - (end & ~(size_t)7) % rgb_step[pixel_stride - 2];
+
+        if (avx_end > x_align)
+            vector = avx_end - x_align;
+    }
+
+    return n_values - vector * pixel_stride * n_outer;
+}
+
+// whether a direct pass runs the jump table entry looping over the kernel length
+static bool runtime_len(fir_convolve_fn_t fn, fastfilters_kernel_fir_t kernel)
+{
+    const bool plain = fn == &fastfilters_fir_convolve_fir_inner || fn == &fastfilters_fir_convolve_fir_outer;
+
+    // the portable jump tables have a specialisation for FF_UNROLL as well
+    if (g_path == FASTFILTERS_PATH_RUNTIME_LEN)
+        return true;
+    return kernel->len > FF_UNROLL || (!plain && kernel->len == FF_UNROLL);
+}
+
+static fastfilters_stats_variant_t stats_variant(fir_convolve_fn_t fn, bool outer, size_t pixel_stride,
+                                                 fastfilters_kernel_fir_t kernel)
+{
+    const bool plain = fn == &fastfilters_fir_convolve_fir_inner || fn == &fastfilters_fir_convolve_fir_outer;
+
+    if (fn == &fastfilters_fir_convolve_fft_inner || fn == &fastfilters_fir_convolve_fft_outer)
+        return FASTFILTERS_STATS_FFT;
+    if (!outer && !plain && pixel_stride != 1)
+        return FASTFILTERS_STATS_RGB;
+    if (runtime_len(fn, kernel))
+        return FASTFILTERS_STATS_RUNTIME_LEN;
+    return FASTFILTERS_STATS_UNROLLED;
+}
+
+// runs a pass as an event of the trace and adds it to the statistics
+static bool convolve_profiled(fir_convolve_fn_t fn, bool outer, const float *inptr, size_t n_pixels,
+                              size_t pixel_stride, size_t n_outer, size_t outer_stride, float *outptr,
+                              size_t outptr_stride, fastfilters_kernel_fir_t kernel,
+                              fastfilters_border_treatment_t left_border, fastfilters_border_treatment_t right_border,
+                              const float *borderptr_left, const float *borderptr_right, size_t border_outer_stride)
+{
+    const fastfilters_stats_variant_t variant = stats_variant(fn, outer, pixel_stride, kernel);
+    const size_t n_values = n_pixels * n_outer * (outer ? 1 : pixel_stride);
+    const uint64_t allocated = fastfilters_memory_thread_allocated();
+    const uint64_t start = fastfilters_time_ns();
+
+    fastfilters_trace_begin("pass", g_pass_names[outer][variant], 2 * n_values * sizeof(float));
+    const bool result = fn(inptr, n_pixels, pixel_stride, n_outer, outer_stride, outptr, outptr_stride, kernel,
+                           left_border, right_border, borderptr_left, borderptr_right, border_outer_stride);
+    fastfilters_trace_end("pass", g_pass_names[outer][variant]);
+
+    if (!fastfilters_stats_enabled())
+        return result;
+
+    fastfilters_stats_pass_t pass;
+    pass.calls = 1;
+    pass.time_ns = fastfilters_time_ns() - start;
+    pass.pixels = n_values;
+    pass.scalar_pixels =
+        stats_scalar_pixels(fn, outer, n_pixels, pixel_stride, n_outer, kernel, left_border, right_border);
+    pass.scratch_bytes = fastfilters_memory_thread_allocated() - allocated;
+
+    fastfilters_stats_add(outer, variant, &pass);
+    return result;
+}
+
+// long kernels are applied in the frequency domain, everything else by the direct implementations
+static fir_convolve_fn_t select_fn(fastfilters_kernel_fir_t kernel, size_t n_pixels,
+                                   fastfilters_border_treatment_t left_border,
+                                   fastfilters_border_treatment_t right_border, bool outer)
+{
+    if (fastfilters_fir_fft_preferred(kernel, n_pixels, left_border, right_border, outer))
+        return outer ? &fastfilters_fir_convolve_fft_outer : &fastfilters_fir_convolve_fft_inner;
+    return outer ? g_fir_outer : g_fir_inner;
+}
+
+static bool convolve_inner_select(const float *inptr, size_t n_pixels, size_t pixel_stride, size_t n_outer,
+                                  size_t outer_stride, float *outptr, size_t outptr_stride,
+                                  fastfilters_kernel_fir_t kernel, fastfilters_border_treatment_t left_border,
+                                  fastfilters_border_treatment_t right_border, const float *borderptr_left,
+                                  const float *borderptr_right, size_t border_outer_stride)
+{
+    const fir_convolve_fn_t fn = select_fn(kernel, n_pixels, left_border, right_border, false);
+
+    if (unlikely(fastfilters_stats_enabled() || fastfilters_trace_enabled()))
+        return convolve_profiled(fn, false, inptr, n_pixels, pixel_stride, n_outer, outer_stride, outptr,
+                                 outptr_stride, kernel, left_border, right_border, borderptr_left, borderptr_right,
+                                 border_outer_stride);
+
+    return fn(inptr, n_pixels, pixel_stride, n_outer, outer_stride, outptr, outptr_stride, kernel, left_border,
+              right_border, borderptr_left, borderptr_right, border_outer_stride);
+}
+
+static bool convolve_outer_select(const float *inptr, size_t n_pixels, size_t pixel_stride, size_t n_outer,
+                                  size_t outer_stride, float *outptr, size_t outptr_stride,
+                                  fastfilters_kernel_fir_t kernel, fastfilters_border_treatment_t left_border,
+                                  fastfilters_border_treatment_t right_border, const float *borderptr_left,
+                                  const float *borderptr_right, size_t border_outer_stride)
+{
+    const fir_convolve_fn_t fn = select_fn(kernel, n_pixels, left_border, right_border, true);
+
+    if (unlikely(fastfilters_stats_enabled() || fastfilters_trace_enabled()))
+        return convolve_profiled(fn, true, inptr, n_pixels, pixel_stride, n_outer, outer_stride, outptr,
+                                 outptr_stride, kernel, left_border, right_border, borderptr_left, borderptr_right,
+                                 border_outer_stride);
+
+    return fn(inptr, n_pixels, pixel_stride, n_outer, outer_stride, outptr, outptr_stride, kernel, left_border,
+              right_border, borderptr_left, borderptr_right, border_outer_stride);
+}
+
+static bool isa_supported(fastfilters_isa_t isa)
+{
+    switch (isa) {
+    case FASTFILTERS_ISA_AUTO:
+    case FASTFILTERS_ISA_PLAIN:
+        return true;
+    case FASTFILTERS_ISA_AVX:
+        return fastfilters_cpu_check(FASTFILTERS_CPU_AVX);
+    case FASTFILTERS_ISA_AVXFMA:
+        return fastfilters_cpu_check(FASTFILTERS_CPU_FMA);
+    default:
+        return false;
+    }
+}
+
+static void fir_select(fastfilters_isa_t isa)
+{
+    if (isa == FASTFILTERS_ISA_AUTO) {
+        if (fastfilters_cpu_check(FASTFILTERS_CPU_FMA))
+            isa = FASTFILTERS_ISA_AVXFMA;
+        else if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX))
+            isa = FASTFILTERS_ISA_AVX;
+        else
+            isa = FASTFILTERS_ISA_PLAIN;
+    }
+
+    if (isa == FASTFILTERS_ISA_AVXFMA) {
+        g_fir_outer = &fastfilters_fir_convolve_fir_outer_avxfma;
+        g_fir_inner = &fastfilters_fir_convolve_fir_inner_avxfma;
+        g_convolve_line_multi = &fastfilters_fir_convolve_fir_line_multi_avxfma;
+        g_sum_rows = &fastfilters_fir_sum_rows_avxfma;
+        g_fft_block = &fastfilters_fir_convolve_fft_block_avxfma;
+    } else if (isa == FASTFILTERS_ISA_AVX) {
+        g_fir_outer = &fastfilters_fir_convolve_fir_outer_avx;
+        g_fir_inner = &fastfilters_fir_convolve_fir_inner_avx;
+        g_convolve_line_multi = &fastfilters_fir_convolve_fir_line_multi_avx;
+        g_sum_rows = &fastfilters_fir_sum_rows_avx;
+        g_fft_block = &fastfilters_fir_convolve_fft_block_avx;
+    } else {
+        g_fir_outer = &fastfilters_fir_convolve_fir_outer;
+        g_fir_inner = &fastfilters_fir_convolve_fir_inner;
+        g_convolve_line_multi = &fastfilters_fir_convolve_fir_line_multi;
+        g_sum_rows = &fastfilters_fir_sum_rows;
+        g_fft_block = &fastfilters_fir_convolve_fft_block;
+    }
+
+    g_isa = isa;
+    g_convolve_inner = &convolve_inner_select;
+    g_convolve_outer = &convolve_outer_select;
+}
 
 void fastfilters_fir_init(void)
 {
-    if (fastfilters_cpu_check(FASTFILTERS_CPU_FMA)) {
-        g_convolve_outer = &fastfilters_fir_convolve_fir_outer_avxfma;
-        g_convolve_inner = &fastfilters_fir_convolve_fir_inner_avxfma;
-    } else if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX)) {
-        g_convolve_outer = &fastfilters_fir_convolve_fir_outer_avx;
-        g_convolve_inner = &fastfilters_fir_convolve_fir_inner_avx;
+    const char *force = getenv("FASTFILTERS_FORCE_ISA");
+    fastfilters_isa_t isa = FASTFILTERS_ISA_AUTO;
+
+    // unknown tiers and tiers the cpu lacks are ignored
+    for (unsigned i = 0; force && i < ARRAY_LENGTH(g_isa_names); ++i)
+        if (strcmp(force, g_isa_names[i]) == 0 && isa_supported((fastfilters_isa_t)i))
+            isa = (fastfilters_isa_t)i;
+
+    g_path = FASTFILTERS_PATH_AUTO;
+    fir_select(isa);
+}
+
+fastfilters_isa_t DLL_LOCAL fastfilters_fir_isa(void)
+{
+    return g_isa;
+}
+
+fastfilters_path_t DLL_LOCAL fastfilters_fir_path(void)
+{
+    return g_path;
+}
+
+unsigned DLL_LOCAL fastfilters_fir_generation(void)
+{
+    return g_generation;
+}
+
+bool DLL_PUBLIC fastfilters_dispatch_force(fastfilters_isa_t isa, fastfilters_path_t path)
+{
+    if (!isa_supported(isa) || (unsigned)path > FASTFILTERS_PATH_FFT)
+        return false;
+
+    fir_select(isa);
+    g_path = path;
+    ++g_generation;
+    return true;
+}
+
+bool DLL_PUBLIC fastfilters_dispatch_query(const fastfilters_kernel_fir_t kernel,
+                                           fastfilters_border_treatment_t left_border,
+                                           fastfilters_border_treatment_t right_border, bool outer, size_t n_pixels,
+                                           size_t n_channels, fastfilters_dispatch_t *dispatch)
+{
+    if ((unsigned)left_border >= ARRAY_LENGTH(g_border_names) ||
+        (unsigned)right_border >= ARRAY_LENGTH(g_border_names))
+        return false;
+
+    const fir_convolve_fn_t fn = select_fn(kernel, n_pixels, left_border, right_border, outer);
+    const char *direction = outer ? "outer" : "inner";
+
+    dispatch->isa = g_isa;
+    dispatch->variant = stats_variant(fn, outer, n_channels, kernel);
+
+    if (dispatch->variant == FASTFILTERS_STATS_FFT) {
+        snprintf(dispatch->name, sizeof(dispatch->name), "%s_%s_fft", g_isa_names[g_isa], direction);
+        return true;
+    }
+
+    char len[24] = "N";
+    if (!runtime_len(fn, kernel))
+        snprintf(len, sizeof(len), "%u", (unsigned)kernel->len);
+
+    snprintf(dispatch->name, sizeof(dispatch->name), "%s_%s%s_%s_%s_%s_%s", g_isa_names[g_isa], direction,
+             dispatch->variant == FASTFILTERS_STATS_RGB ? "_rgb" : "", g_border_names[left_border],
+             g_border_names[right_border], g_symmetry_names[kernel->symmetry], len);
+    return true;
+}
+
+void DLL_LOCAL fastfilters_fir_weighted_sum(const float *const *rows, const float *weights, unsigned n_rows, float *out,
+                                            size_t len)
+{
+    g_sum_rows(rows, weights, n_rows, out, len);
+}
+
+void DLL_LOCAL fastfilters_fir_fft_block(const fastfilters_fft_plan_t *plan, float *re, float *im)
+{
+    g_fft_block(plan, re, im);
+}
+
+// packs row y of plane z into line, multiplied by the same row of in2 if given
+static void load_row(const fastfilters_array3d_t *in, const fastfilters_array3d_t *in2, size_t y, size_t z,
+                     float *line)
+{
+    const size_t n_channels = in->n_channels;
+    const float *rowptr = in->ptr + z * in->stride_z + y * in->stride_y;
+
+    if (!in2) {
+        for (size_t x = 0; x < in->n_x; ++x)
+            for (size_t c = 0; c < n_channels; ++c)
+                line[x * n_channels + c] = rowptr[x * in->stride_x + c];
     } else {
-        g_convolve_outer = &fastfilters_fir_convolve_fir_outer;
-        g_convolve_inner = &fastfilters_fir_convolve_fir_inner;
+        const float *rowptr2 = in2->ptr + z * in2->stride_z + y * in2->stride_y;
+
+        if (in->stride_x == n_channels && in2->stride_x == n_channels)
+            fastfilters_combine_mul_row(rowptr, rowptr2, line, in->n_x * n_channels);
+        else
+            for (size_t x = 0; x < in->n_x; ++x)
+                for (size_t c = 0; c < n_channels; ++c)
+                    line[x * n_channels + c] = rowptr[x * in->stride_x + c] * rowptr2[x * in2->stride_x + c];
     }
 }
 
+// the inner pass expects the channels of neighbouring pixels to be adjacent. rows of views that skip pixels
+// (e.g. vol[:, ::2]) are gathered into a packed line first instead of copying the whole array. if in2 is given the
+// line holds the pixel-wise product of both inputs.
+static bool convolve_inner_planes(const fastfilters_array3d_t *in, const fastfilters_array3d_t *in2, float *outptr,
+                                  size_t outptr_stride_y, size_t outptr_stride_z, const fastfilters_kernel_fir_t kernel)
+{
+    bool result = false;
+    float *line = NULL;
+    const size_t n_channels = in->n_channels;
+    const size_t row_len = in->n_x * n_channels;
+
+    if (!in2 && in->stride_x == n_channels) {
+        for (size_t z = 0; z < in->n_z; ++z)
+            if (!g_convolve_inner(in->ptr + z * in->stride_z, in->n_x, n_channels, in->n_y, in->stride_y,
+                                  outptr + z * outptr_stride_z, outptr_stride_y, kernel, FASTFILTERS_BORDER_MIRROR,
+                                  FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+                goto out;
+
+        result = true;
+        goto out;
+    }
+
+    line = fastfilters_memory_align(32, row_len * sizeof(float));
+    if (!line)
+        goto out;
+
+    for (size_t z = 0; z < in->n_z; ++z) {
+        for (size_t y = 0; y < in->n_y; ++y) {
+            load_row(in, in2, y, z, line);
+
+            if (!g_convolve_inner(line, in->n_x, n_channels, 1, row_len,
+                                  outptr + z * outptr_stride_z + y * outptr_stride_y, outptr_stride_y, kernel,
+                                  FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+                goto out;
+        }
+    }
+
+    result = true;
+
+out:
+    if (line)
+        fastfilters_memory_align_free(line);
+    return result;
+}
+
+// the outer passes work in place on a view with packed pixels
+static bool convolve_outer_y(const fastfilters_array3d_t *array, size_t z, const fastfilters_kernel_fir_t kernely)
+{
+    float *planeptr = array->ptr + z * array->stride_z;
+
+    return g_convolve_outer(planeptr, array->n_y, array->stride_y, array->n_x * array->n_channels, 1, planeptr,
+                            array->stride_y, kernely, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL,
+                            0);
+}
+
+static bool convolve_outer_z(const fastfilters_array3d_t *array, const fastfilters_kernel_fir_t kernelz)
+{
+    const size_t row_len = array->n_x * array->n_channels;
+
+    if (array->stride_y == row_len)
+        return g_convolve_outer(array->ptr, array->n_z, array->stride_z, array->n_y * row_len, 1, array->ptr,
+                                array->stride_z, kernelz, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL,
+                                NULL, 0);
+
+    for (size_t y = 0; y < array->n_y; ++y) {
+        float *rowptr = array->ptr + y * array->stride_y;
+
+        if (!g_convolve_outer(rowptr, array->n_z, array->stride_z, row_len, 1, rowptr, array->stride_z, kernelz,
+                              FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+            return false;
+    }
+
+    return true;
+}
+
+static bool convolve3d(const fastfilters_array3d_t *inarray, const fastfilters_array3d_t *inarray2,
+                       const fastfilters_kernel_fir_t kernelx, const fastfilters_kernel_fir_t kernely,
+                       const fastfilters_kernel_fir_t kernelz, const fastfilters_array3d_t *outarray)
+{
+    if (outarray->stride_x != outarray->n_channels) {
+        bool result = false;
+        fastfilters_array3d_t *tmp =
+            fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
+        if (!tmp)
+            return false;
+
+        result = convolve3d(inarray, inarray2, kernelx, kernely, kernelz, tmp);
+        if (result)
+            fastfilters_array3d_copy(tmp, outarray);
+
+        fastfilters_array3d_free(tmp);
+        return result;
+    }
+
+    if (!convolve_inner_planes(inarray, inarray2, outarray->ptr, outarray->stride_y, outarray->stride_z, kernelx))
+        return false;
+
+    for (size_t z = 0; z < inarray->n_z; ++z)
+        if (!convolve_outer_y(outarray, z, kernely))
+            return false;
+
+    // 2d arrays are passed as a single plane
+    if (!kernelz)
+        return true;
+
+    return convolve_outer_z(outarray, kernelz);
+}
+
 bool DLL_PUBLIC fastfilters_fir_convolve2d(const fastfilters_array2d_t *inarray, const fastfilters_kernel_fir_t kernelx,
                                            const fastfilters_kernel_fir_t kernely,
                                            const fastfilters_array2d_t *outarray, const fastfilters_options_t *options)
 {
+    const fastfilters_array3d_t in = array2d_as_3d(inarray);
+    const fastfilters_array3d_t out = array2d_as_3d(outarray);
     (void)options;
-    if (!g_convolve_inner(inarray->ptr, inarray->n_x, inarray->stride_x, inarray->n_y, inarray->stride_y, outarray->ptr,
-                          outarray->stride_y, kernelx, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL,
-                          0))
-        return false;
 
-    return g_convolve_outer(outarray->ptr, inarray->n_y, outarray->stride_y, inarray->n_x * inarray->n_channels,
-                            inarray->stride_x / inarray->n_channels, outarray->ptr, outarray->stride_y, kernely,
-                            FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0);
+    return convolve3d(&in, NULL, kernelx, kernely, NULL, &out);
 }
 
 bool DLL_PUBLIC fastfilters_fir_convolve3d(const fastfilters_array3d_t *inarray, const fastfilters_kernel_fir_t kernelx,
@@ -65,22 +475,591 @@ bool DLL_PUBLIC fastfilters_fir_convolve3d(const fastfilters_array3d_t *inarray,
                                            const fastfilters_array3d_t *outarray, const fastfilters_options_t *options)
 {
     (void)options;
+    return convolve3d(inarray, NULL, kernelx, kernely, kernelz, outarray);
+}
 
-    if (!g_convolve_inner(inarray->ptr, inarray->n_x, inarray->stride_x, inarray->n_y * inarray->n_z, inarray->stride_y,
-                          outarray->ptr, outarray->stride_y, kernelx, FASTFILTERS_BORDER_MIRROR,
-                          FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
-        return false;
+bool DLL_PUBLIC fastfilters_fir_convolve2d_mul(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b,
+                                               const fastfilters_kernel_fir_t kernelx,
+                                               const fastfilters_kernel_fir_t kernely,
+                                               const fastfilters_array2d_t *outarray,
+                                               const fastfilters_options_t *options)
+{
+    const fastfilters_array3d_t in = array2d_as_3d(a);
+    const fastfilters_array3d_t in2 = array2d_as_3d(b);
+    const fastfilters_array3d_t out = array2d_as_3d(outarray);
+    (void)options;
 
-    for (size_t z = 0; z < inarray->n_z; ++z) {
-        float *planeptr_out = outarray->ptr + z * outarray->stride_z;
+    return convolve3d(&in, &in2, kernelx, kernely, NULL, &out);
+}
 
-        if (!g_convolve_outer(planeptr_out, inarray->n_y, outarray->stride_y, inarray->n_x * inarray->n_channels,
-                              inarray->stride_x / inarray->n_channels, planeptr_out, outarray->stride_y, kernely,
+bool DLL_PUBLIC fastfilters_fir_convolve3d_mul(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b,
+                                               const fastfilters_kernel_fir_t kernelx,
+                                               const fastfilters_kernel_fir_t kernely,
+                                               const fastfilters_kernel_fir_t kernelz,
+                                               const fastfilters_array3d_t *outarray,
+                                               const fastfilters_options_t *options)
+{
+    (void)options;
+    return convolve3d(a, b, kernelx, kernely, kernelz, outarray);
+}
+
+// smooths the products in[pairs[k][0]] * in[pairs[k][1]] into out[k]. every plane is filtered along x and y for all
+// products before moving on, so the inputs are read from memory once and the planes are still cached for the y pass.
+bool DLL_LOCAL fastfilters_fir_convolve3d_products(const fastfilters_array3d_t *const *in, const unsigned (*pairs)[2],
+                                                   unsigned n_products, const fastfilters_kernel_fir_t kernelx,
+                                                   const fastfilters_kernel_fir_t kernely,
+                                                   const fastfilters_kernel_fir_t kernelz,
+                                                   const fastfilters_array3d_t *const *out)
+{
+    bool result = false;
+    float *line = NULL;
+    const size_t n_channels = in[0]->n_channels;
+    const size_t row_len = in[0]->n_x * n_channels;
+
+    bool packed = true;
+
+    for (unsigned k = 0; k < n_products; ++k)
+        packed = packed && out[k]->stride_x == n_channels;
+
+    // outputs that skip pixels go through a temporary array per product
+    if (!packed) {
+        for (unsigned k = 0; k < n_products; ++k)
+            if (!convolve3d(in[pairs[k][0]], in[pairs[k][1]], kernelx, kernely, kernelz, out[k]))
+                goto out;
+
+        result = true;
+        goto out;
+    }
+
+    line = fastfilters_memory_align(32, row_len * sizeof(float));
+    if (!line)
+        goto out;
+
+    for (size_t z = 0; z < in[0]->n_z; ++z) {
+        for (size_t y = 0; y < in[0]->n_y; ++y) {
+            for (unsigned k = 0; k < n_products; ++k) {
+                load_row(in[pairs[k][0]], in[pairs[k][1]], y, z, line);
+
+                if (!g_convolve_inner(line, in[0]->n_x, n_channels, 1, row_len,
+                                      out[k]->ptr + z * out[k]->stride_z + y * out[k]->stride_y, out[k]->stride_y,
+                                      kernelx, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
+                    goto out;
+            }
+        }
+
+        for (unsigned k = 0; k < n_products; ++k)
+            if (!convolve_outer_y(out[k], z, kernely))
+                goto out;
+    }
+
+    if (kernelz)
+        for (unsigned k = 0; k < n_products; ++k)
+            if (!convolve_outer_z(out[k], kernelz))
+                goto out;
+
+    result = true;
+
+out:
+    if (line)
+        fastfilters_memory_align_free(line);
+    return result;
+}
+
+// kernel sets of fastfilters_fir_convolve3d_multi, enough for the hessian of a 3d array
+#define MULTI_MAX_SETS 6
+
+// mirrors the len pixels next to both ends of the row at line + len * pixel_stride into the padding around it
+static void mirror_line(float *line, size_t n_pixels, size_t pixel_stride, size_t len)
+{
+    float *row = line + len * pixel_stride;
+
+    for (size_t k = 1; k <= len; ++k) {
+        memcpy(row - k * pixel_stride, row + k * pixel_stride, pixel_stride * sizeof(float));
+        memcpy(row + (n_pixels - 1 + k) * pixel_stride, row + (n_pixels - 1 - k) * pixel_stride,
+               pixel_stride * sizeof(float));
+    }
+}
+
+static void convolve_line_multi_profiled(const float *line, size_t n_pixels, size_t pixel_stride, size_t len,
+                                         float *const *outptr, const fastfilters_kernel_fir_t *kernels,
+                                         unsigned n_kernels)
+{
+    const size_t row_len = n_pixels * pixel_stride;
+    const uint64_t start = fastfilters_time_ns();
+
+    g_convolve_line_multi(line, n_pixels, pixel_stride, len, outptr, kernels, n_kernels);
+
+    // the avx versions leave less than one vector per row to the scalar loop
+    fastfilters_stats_pass_t pass;
+    pass.calls = 1;
+    pass.time_ns = fastfilters_time_ns() - start;
+    pass.pixels = row_len * n_kernels;
+    pass.scalar_pixels = g_convolve_line_multi == &fastfilters_fir_convolve_fir_line_multi
+                             ? pass.pixels
+                             : (row_len - (row_len & ~(size_t)7)) * n_kernels;
+    pass.scratch_bytes = 0;
+
+    fastfilters_stats_add(false, FASTFILTERS_STATS_MULTI, &pass);
+}
+
+// convolves in with the kernel sets kernels[k] = {x, y, z} into out[k] (z is NULL for 2d arrays). every row is copied
+// into a mirrored line once and all x kernels are applied to it while it is cached, so the input is streamed from
+// memory once instead of once per set. sets sharing their x kernel copy the filtered row.
+bool DLL_LOCAL fastfilters_fir_convolve3d_multi(const fastfilters_array3d_t *in,
+                                                const fastfilters_kernel_fir_t (*kernels)[3], unsigned n_sets,
+                                                const fastfilters_array3d_t *const *out)
+{
+    bool result = false;
+    float *line = NULL;
+    fastfilters_array3d_t *tmp[MULTI_MAX_SETS] = {NULL};
+    fastfilters_array3d_t view[MULTI_MAX_SETS];
+    fastfilters_kernel_fir_t kernels_x[MULTI_MAX_SETS];
+    unsigned same_x[MULTI_MAX_SETS];
+    unsigned n_unique = 0;
+    size_t len = 0;
+
+    const size_t n_channels = in->n_channels;
+    const size_t row_len = in->n_x * n_channels;
+
+    for (unsigned k = 0; k < n_sets && k < MULTI_MAX_SETS; ++k)
+        if (kernels[k][0]->len > len)
+            len = kernels[k][0]->len;
+
+    // long x kernels are applied in the frequency domain one set at a time
+    bool fft = false;
+    for (unsigned k = 0; k < n_sets && k < MULTI_MAX_SETS; ++k)
+        fft = fft || fastfilters_fir_fft_preferred(kernels[k][0], in->n_x, FASTFILTERS_BORDER_MIRROR,
+                                                   FASTFILTERS_BORDER_MIRROR, false);
+
+    if (n_sets > MULTI_MAX_SETS || in->n_x <= len || fft) {
+        for (unsigned k = 0; k < n_sets; ++k)
+            if (!convolve3d(in, NULL, kernels[k][0], kernels[k][1], kernels[k][2], out[k]))
+                goto out;
+
+        result = true;
+        goto out;
+    }
+
+    for (unsigned k = 0; k < n_sets; ++k) {
+        same_x[k] = k;
+        for (unsigned j = 0; j < k; ++j)
+            if (kernels[j][0] == kernels[k][0]) {
+                same_x[k] = j;
+                break;
+            }
+
+        if (same_x[k] == k)
+            kernels_x[n_unique++] = kernels[k][0];
+
+        // outputs that skip pixels are filtered in a temporary array
+        view[k] = *out[k];
+        if (out[k]->stride_x != n_channels) {
+            tmp[k] = fastfilters_array3d_alloc(in->n_x, in->n_y, in->n_z, n_channels);
+            if (!tmp[k])
+                goto out;
+            view[k] = *tmp[k];
+        }
+    }
+
+    line = fastfilters_memory_align(32, (in->n_x + 2 * len) * n_channels * sizeof(float));
+    if (!line)
+        goto out;
+
+    for (size_t z = 0; z < in->n_z; ++z) {
+        // rows are traced as one event per plane, each row is read once for all kernels
+        fastfilters_trace_begin("pass", g_pass_names[0][FASTFILTERS_STATS_MULTI],
+                                (1 + n_unique) * in->n_y * row_len * sizeof(float));
+
+        for (size_t y = 0; y < in->n_y; ++y) {
+            float *outptr[MULTI_MAX_SETS];
+            float *rowptr = line + len * n_channels;
+
+            if (in->stride_x == n_channels)
+                memcpy(rowptr, in->ptr + z * in->stride_z + y * in->stride_y, row_len * sizeof(float));
+            else
+                load_row(in, NULL, y, z, rowptr);
+
+            mirror_line(line, in->n_x, n_channels, len);
+
+            n_unique = 0;
+            for (unsigned k = 0; k < n_sets; ++k)
+                if (same_x[k] == k)
+                    outptr[n_unique++] = view[k].ptr + z * view[k].stride_z + y * view[k].stride_y;
+
+            if (unlikely(fastfilters_stats_enabled()))
+                convolve_line_multi_profiled(line, in->n_x, n_channels, len, outptr, kernels_x, n_unique);
+            else
+                g_convolve_line_multi(line, in->n_x, n_channels, len, outptr, kernels_x, n_unique);
+
+            for (unsigned k = 0; k < n_sets; ++k)
+                if (same_x[k] != k)
+                    memcpy(view[k].ptr + z * view[k].stride_z + y * view[k].stride_y,
+                           view[same_x[k]].ptr + z * view[same_x[k]].stride_z + y * view[same_x[k]].stride_y,
+                           row_len * sizeof(float));
+        }
+
+        fastfilters_trace_end("pass", g_pass_names[0][FASTFILTERS_STATS_MULTI]);
+
+        for (unsigned k = 0; k < n_sets; ++k)
+            if (!convolve_outer_y(&view[k], z, kernels[k][1]))
+                goto out;
+    }
+
+    for (unsigned k = 0; k < n_sets; ++k) {
+        if (kernels[k][2] && !convolve_outer_z(&view[k], kernels[k][2]))
+            goto out;
+
+        if (tmp[k])
+            fastfilters_array3d_copy(tmp[k], out[k]);
+    }
+
+    result = true;
+
+out:
+    for (unsigned k = 0; k < MULTI_MAX_SETS; ++k)
+        if (tmp[k])
+            fastfilters_array3d_free(tmp[k]);
+    if (line)
+        fastfilters_memory_align_free(line);
+    return result;
+}
+
+// filters count rows (2d) or planes (3d) starting at first along all axes but the outermost one
+static bool reduce_filter_slices(const fastfilters_array3d_t *in, const fastfilters_kernel_fir_t *kernels, size_t first,
+                                 size_t count, float *outptr)
+{
+    const size_t row_len = in->n_x * in->n_channels;
+    const size_t plane_len = in->n_y * row_len;
+
+    if (!kernels[2])
+        return g_convolve_inner(in->ptr + first * in->stride_y, in->n_x, in->n_channels, count, in->stride_y, outptr,
+                                row_len, kernels[0], FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL,
+                                0);
+
+    for (size_t z = 0; z < count; ++z) {
+        float *planeptr = outptr + z * plane_len;
+
+        if (!g_convolve_inner(in->ptr + (first + z) * in->stride_z, in->n_x, in->n_channels, in->n_y, in->stride_y,
+                              planeptr, row_len, kernels[0], FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR,
+                              NULL, NULL, 0))
+            return false;
+
+        if (!g_convolve_outer(planeptr, in->n_y, row_len, row_len, 1, planeptr, row_len, kernels[1],
                               FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0))
             return false;
     }
 
-    return g_convolve_outer(outarray->ptr, outarray->n_z, outarray->stride_z,
-                            inarray->n_y * inarray->n_x * inarray->n_channels, 1, outarray->ptr, outarray->stride_z,
-                            kernelz, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, NULL, NULL, 0);
-}
\ No newline at end of file
+    return true;
+}
+
+// adds the component c of a strip into the output strip o that holds the previous components
+static void reduce_add(const fastfilters_array3d_t *c, const fastfilters_array3d_t *o, bool first, bool do_sqrt)
+{
+    if (first) {
+        fastfilters_array3d_copy(c, o);
+        return;
+    }
+
+    for (size_t z = 0; z < c->n_z; ++z) {
+        const fastfilters_array2d_t a = {o->ptr + z * o->stride_z, o->n_x, o->n_y, o->stride_x, o->stride_y,
+                                         o->n_channels};
+        const fastfilters_array2d_t b = {c->ptr + z * c->stride_z, c->n_x, c->n_y, c->stride_x, c->stride_y,
+                                         c->n_channels};
+        fastfilters_array2d_t res = a;
+
+        if (do_sqrt)
+            fastfilters_combine_addsqrt2d(&a, &b, &res);
+        else
+            fastfilters_combine_add2d(&a, &b, &res);
+    }
+}
+
+// out = sqrt(sum_k (in * kernels[k])^2) or sum_k in * kernels[k] with one component per axis, i.e. two for 2d
+// arrays (kernels[k][2] == NULL) and three for 3d arrays. the outermost axis is processed in strips: the components
+// of a strip are filtered one after the other into a single window, which holds the strip and its borders, and added
+// into the output strip right away. the only buffer is the window, which is at most the size of the input, and the
+// output strip is still cached when the next component is added. the square root is taken per added component,
+// sqrt(sqrt(a^2 + b^2)^2 + c^2) for 3d arrays.
+// the input needs packed pixels, all kernels need a non-zero length and in and out must not overlap.
+bool DLL_LOCAL fastfilters_fir_convolve3d_reduce(const fastfilters_array3d_t *in,
+                                                 const fastfilters_kernel_fir_t (*kernels)[3], bool do_sqrt,
+                                                 const fastfilters_array3d_t *out)
+{
+    bool result = false;
+    float *window = NULL;
+
+    const bool is3d = kernels[0][2] != NULL;
+    const unsigned n_components = is3d ? 3 : 2;
+    const unsigned axis = is3d ? 2 : 1;
+    const size_t n_channels = in->n_channels;
+    const size_t row_len = in->n_x * n_channels;
+    const size_t slice_len = is3d ? in->n_y * row_len : row_len;
+    const size_t n_slices = is3d ? in->n_z : in->n_y;
+    const size_t out_slice_stride = is3d ? out->stride_z : out->stride_y;
+
+    // the first component is filtered straight into out if its slices are packed like the window's
+    const bool out_packed = out->stride_x == n_channels && (!is3d || out->stride_y == row_len);
+
+    size_t border = 0;
+    for (unsigned k = 0; k < n_components; ++k)
+        if (kernels[k][axis]->len > border)
+            border = kernels[k][axis]->len;
+
+    // the borders of a strip are filtered again for every strip, strips of at least 8 * len slices keep that below a
+    // quarter of the work. this also covers the 2 * len + 1 slices strips bordered by other strips need.
+    size_t strip = is3d ? fastfilters_tuning()->reduce_strip_planes : fastfilters_tuning()->reduce_strip_rows;
+    if (strip < 8 * border + 1)
+        strip = 8 * border + 1;
+
+    // the last strip takes up a remainder of up to 2 * border slices
+    size_t window_slices = strip + 3 * border;
+    if (window_slices > n_slices)
+        window_slices = n_slices;
+
+    window = fastfilters_memory_align(32, window_slices * slice_len * sizeof(float));
+    if (!window)
+        goto out;
+
+    for (size_t s0 = 0, s1; s0 < n_slices; s0 = s1) {
+        // a remainder too short to be a strip of its own is merged into this one
+        s1 = s0 + strip;
+        if (s1 + 2 * border + 1 > n_slices)
+            s1 = n_slices;
+
+        const size_t n = s1 - s0;
+        const size_t top = s0 > 0 ? border : 0;
+        const size_t bottom = s1 < n_slices ? border : 0;
+        const size_t r0 = s0 - top;
+        const size_t r1 = s1 + bottom;
+        float *data = window + top * slice_len;
+
+        fastfilters_array3d_t c = {data, in->n_x, in->n_y, in->n_z, n_channels, row_len, slice_len, n_channels};
+        fastfilters_array3d_t o = *out;
+        o.ptr = out->ptr + s0 * out_slice_stride;
+        if (is3d) {
+            c.n_z = n;
+            o.n_z = n;
+        } else {
+            c.n_y = n;
+            o.n_y = n;
+        }
+
+        for (unsigned k = 0; k < n_components; ++k) {
+            const fastfilters_kernel_fir_t kernel = kernels[k][axis];
+            const bool direct = k == 0 && out_packed;
+
+            if (!reduce_filter_slices(in, kernels[k], r0, r1 - r0, window))
+                goto out;
+
+            // the outer pass runs in place on the window unless it writes the first component into out
+            if (!g_convolve_outer(data, n, slice_len, slice_len, 1, direct ? o.ptr : data,
+                                  direct ? out_slice_stride : slice_len, kernel,
+                                  top ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR,
+                                  bottom ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR,
+                                  top ? data - kernel->len * slice_len : NULL, data + n * slice_len, slice_len))
+                goto out;
+
+            if (!direct)
+                reduce_add(&c, &o, k == 0, do_sqrt);
+        }
+    }
+
+    result = true;
+
+out:
+    if (window)
+        fastfilters_memory_align_free(window);
+    return result;
+}
+
+static void update_extent(size_t begin, size_t end, size_t n, size_t len, size_t *ext_begin, size_t *ext_end)
+{
+    const size_t min_len = 2 * len + 1;
+
+    begin = begin > len ? begin - len : 0;
+    end = end + len < n ? end + len : n;
+
+    // the convolution passes need at least one full kernel length of pixels
+    if (end - begin < min_len) {
+        end = begin + min_len < n ? begin + min_len : n;
+        begin = end > min_len ? end - min_len : 0;
+    }
+
+    // use the real input as border wherever it exists and mirror only at the array boundary
+    if (begin < len)
+        begin = 0;
+    if (end + len > n)
+        end = n;
+
+    *ext_begin = begin;
+    *ext_end = end;
+}
+
+bool DLL_PUBLIC fastfilters_fir_convolve2d_update(const fastfilters_array2d_t *inarray,
+                                                  const fastfilters_roi2d_t *dirty,
+                                                  const fastfilters_kernel_fir_t kernelx,
+                                                  const fastfilters_kernel_fir_t kernely,
+                                                  const fastfilters_array2d_t *outarray, fastfilters_roi2d_t *updated,
+                                                  const fastfilters_options_t *options)
+{
+    bool result = false;
+    float *tmp = NULL;
+    fastfilters_roi2d_t roi = {0, 0, 0, 0};
+
+    const size_t dirty_x_end = dirty->x_end < inarray->n_x ? dirty->x_end : inarray->n_x;
+    const size_t dirty_y_end = dirty->y_end < inarray->n_y ? dirty->y_end : inarray->n_y;
+
+    if (dirty->x_begin >= dirty_x_end || dirty->y_begin >= dirty_y_end) {
+        result = true;
+        goto out;
+    }
+
+    // strided views that skip pixels go through the full convolution
+    if (unlikely(kernelx->len == 0 || kernely->len == 0 || inarray->stride_x != inarray->n_channels ||
+                 outarray->stride_x != outarray->n_channels)) {
+        roi.x_end = inarray->n_x;
+        roi.y_end = inarray->n_y;
+        result = fastfilters_fir_convolve2d(inarray, kernelx, kernely, outarray, options);
+        goto out;
+    }
+
+    update_extent(dirty->x_begin, dirty_x_end, inarray->n_x, kernelx->len, &roi.x_begin, &roi.x_end);
+    update_extent(dirty->y_begin, dirty_y_end, inarray->n_y, kernely->len, &roi.y_begin, &roi.y_end);
+
+    const size_t n_x = roi.x_end - roi.x_begin;
+    const size_t n_y = roi.y_end - roi.y_begin;
+    const size_t border_top = roi.y_begin > 0 ? kernely->len : 0;
+    const size_t border_bottom = roi.y_end < inarray->n_y ? kernely->len : 0;
+    const size_t n_rows = border_top + n_y + border_bottom;
+    const size_t row_stride = n_x * inarray->n_channels;
+
+    const fastfilters_border_treatment_t border_left =
+        roi.x_begin > 0 ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR;
+    const fastfilters_border_treatment_t border_right =
+        roi.x_end < inarray->n_x ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR;
+
+    tmp = fastfilters_memory_align(32, n_rows * row_stride * sizeof(float));
+    if (!tmp)
+        goto out;
+
+    const float *inptr =
+        inarray->ptr + (roi.y_begin - border_top) * inarray->stride_y + roi.x_begin * inarray->stride_x;
+
+    if (!g_convolve_inner(inptr, n_x, inarray->stride_x, n_rows, inarray->stride_y, tmp, row_stride, kernelx,
+                          border_left, border_right, roi.x_begin > 0 ? inptr - kernelx->len * inarray->stride_x : NULL,
+                          inptr + n_x * inarray->stride_x, inarray->stride_y))
+        goto out;
+
+    result = g_convolve_outer(tmp + border_top * row_stride, n_y, row_stride, row_stride, 1,
+                              outarray->ptr + roi.y_begin * outarray->stride_y + roi.x_begin * outarray->stride_x,
+                              outarray->stride_y, kernely,
+                              border_top ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR,
+                              border_bottom ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR, tmp,
+                              tmp + (border_top + n_y) * row_stride, row_stride);
+
+out:
+    if (tmp)
+        fastfilters_memory_align_free(tmp);
+    if (updated)
+        *updated = roi;
+    return result;
+}
+
+bool DLL_PUBLIC fastfilters_fir_convolve3d_update(const fastfilters_array3d_t *inarray,
+                                                  const fastfilters_roi3d_t *dirty,
+                                                  const fastfilters_kernel_fir_t kernelx,
+                                                  const fastfilters_kernel_fir_t kernely,
+                                                  const fastfilters_kernel_fir_t kernelz,
+                                                  const fastfilters_array3d_t *outarray, fastfilters_roi3d_t *updated,
+                                                  const fastfilters_options_t *options)
+{
+    bool result = false;
+    float *tmp = NULL;
+    fastfilters_roi3d_t roi = {0, 0, 0, 0, 0, 0};
+
+    const size_t dirty_x_end = dirty->x_end < inarray->n_x ? dirty->x_end : inarray->n_x;
+    const size_t dirty_y_end = dirty->y_end < inarray->n_y ? dirty->y_end : inarray->n_y;
+    const size_t dirty_z_end = dirty->z_end < inarray->n_z ? dirty->z_end : inarray->n_z;
+
+    if (dirty->x_begin >= dirty_x_end || dirty->y_begin >= dirty_y_end || dirty->z_begin >= dirty_z_end) {
+        result = true;
+        goto out;
+    }
+
+    if (unlikely(kernelx->len == 0 || kernely->len == 0 || kernelz->len == 0 ||
+                 inarray->stride_x != inarray->n_channels || outarray->stride_x != outarray->n_channels)) {
+        roi.x_end = inarray->n_x;
+        roi.y_end = inarray->n_y;
+        roi.z_end = inarray->n_z;
+        result = fastfilters_fir_convolve3d(inarray, kernelx, kernely, kernelz, outarray, options);
+        goto out;
+    }
+
+    update_extent(dirty->x_begin, dirty_x_end, inarray->n_x, kernelx->len, &roi.x_begin, &roi.x_end);
+    update_extent(dirty->y_begin, dirty_y_end, inarray->n_y, kernely->len, &roi.y_begin, &roi.y_end);
+    update_extent(dirty->z_begin, dirty_z_end, inarray->n_z, kernelz->len, &roi.z_begin, &roi.z_end);
+
+    const size_t n_x = roi.x_end - roi.x_begin;
+    const size_t n_y = roi.y_end - roi.y_begin;
+    const size_t n_z = roi.z_end - roi.z_begin;
+    const size_t border_top = roi.y_begin > 0 ? kernely->len : 0;
+    const size_t border_bottom = roi.y_end < inarray->n_y ? kernely->len : 0;
+    const size_t border_front = roi.z_begin > 0 ? kernelz->len : 0;
+    const size_t border_back = roi.z_end < inarray->n_z ? kernelz->len : 0;
+    const size_t n_rows = border_top + n_y + border_bottom;
+    const size_t n_planes = border_front + n_z + border_back;
+    const size_t row_stride = n_x * inarray->n_channels;
+    const size_t plane_stride = n_rows * row_stride;
+
+    const fastfilters_border_treatment_t border_left =
+        roi.x_begin > 0 ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR;
+    const fastfilters_border_treatment_t border_right =
+        roi.x_end < inarray->n_x ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR;
+
+    tmp = fastfilters_memory_align(32, n_planes * plane_stride * sizeof(float));
+    if (!tmp)
+        goto out;
+
+    for (size_t z = 0; z < n_planes; ++z) {
+        const float *inptr = inarray->ptr + (roi.z_begin - border_front + z) * inarray->stride_z +
+                             (roi.y_begin - border_top) * inarray->stride_y + roi.x_begin * inarray->stride_x;
+        float *planeptr = tmp + z * plane_stride;
+
+        if (!g_convolve_inner(inptr, n_x, inarray->stride_x, n_rows, inarray->stride_y, planeptr, row_stride, kernelx,
+                              border_left, border_right,
+                              roi.x_begin > 0 ? inptr - kernelx->len * inarray->stride_x : NULL,
+                              inptr + n_x * inarray->stride_x, inarray->stride_y))
+            goto out;
+
+        if (!g_convolve_outer(planeptr + border_top * row_stride, n_y, row_stride, row_stride, 1,
+                              planeptr + border_top * row_stride, row_stride, kernely,
+                              border_top ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR,
+                              border_bottom ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR, planeptr,
+                              planeptr + (border_top + n_y) * row_stride, row_stride))
+            goto out;
+    }
+
+    float *blockptr = tmp + border_front * plane_stride + border_top * row_stride;
+    if (!g_convolve_outer(blockptr, n_z, plane_stride, n_y * row_stride, 1, blockptr, plane_stride, kernelz,
+                          border_front ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR,
+                          border_back ? FASTFILTERS_BORDER_PTR : FASTFILTERS_BORDER_MIRROR,
+                          tmp + border_top * row_stride, blockptr + n_z * plane_stride, plane_stride))
+        goto out;
+
+    for (size_t z = 0; z < n_z; ++z) {
+        for (size_t y = 0; y < n_y; ++y) {
+            float *outptr = outarray->ptr + (roi.z_begin + z) * outarray->stride_z +
+                            (roi.y_begin + y) * outarray->stride_y + roi.x_begin * outarray->stride_x;
+            memcpy(outptr, blockptr + z * plane_stride + y * row_stride, row_stride * sizeof(float));
+        }
+    }
+
+    result = true;
+
+out:
+    if (tmp)
+        fastfilters_memory_align_free(tmp);
+    if (updated)
+        *updated = roi;
+    return result;
+}
@@ -39,7 +39,7 @@ struct impl_fn_jmptbl_selection {
     impl_fn_t *jmptbl;
     fastfilters_border_treatment_t left_border;
     fastfilters_border_treatment_t right_border;
-    bool is_symmetric;
+    fastfilters_kernel_symmetry_t symmetry;
 };
 
 #define FF_KERNEL_LEN_RUNTIME
@@ -66,7 +66,7 @@ BOOST_PP_LIST_FOR_EACH_PRODUCT(DECL_JMPTBL_CALL, 5,
 #define DEFINE_JMPTBL_STRUCT(outer, x, y, symmetric)                                                                   \
     {                                                                                                                  \
         .jmptbl = BOOST_PP_CAT(g_, fname(outer, x, y, symmetric, param_avxfma, _tbl)), .left_border = ENUM_BORDER(x),  \
-        .right_border = ENUM_BORDER(y), .is_symmetric = BOOST_PP_IF(symmetric, true, false)                            \
+        .right_border = ENUM_BORDER(y), .symmetry = symmetric                                                          \
     }                                                                                                                  \
     ,
 
@@ -100,7 +100,7 @@ static impl_fn_t find_fn(fastfilters_kernel_fir_t kernel, fastfilters_border_tre
             continue;
         if (right_border != jmptbls[i].right_border)
             continue;
-        if (kernel->is_symmetric != jmptbls[i].is_symmetric)
+        if (kernel->symmetry != jmptbls[i].symmetry)
             continue;
         jmptbl = jmptbls[i].jmptbl;
         break;
@@ -109,7 +109,7 @@ static impl_fn_t find_fn(fastfilters_kernel_fir_t kernel, fastfilters_border_tre
     if (jmptbl == NULL)
         return NULL;
 
-    if (kernel->len > FF_UNROLL)
+    if (kernel->len > FF_UNROLL || fastfilters_fir_path() == FASTFILTERS_PATH_RUNTIME_LEN)
         return jmptbl[FF_UNROLL - 1];
     else
         return jmptbl[kernel->len - 1];
@@ -134,20 +134,19 @@ bool APPEND_AVXFMA(fastfilters_fir_convolve_fir_inner)(const float *inptr, size_
         if (inptr == outptr)
             return true;
 
-        if (outer_stride != n_pixels * pixel_stride)
-            return false;
-
-        memcpy(outptr, inptr, outer_stride * n_outer * sizeof(float));
+        for (size_t i = 0; i < n_outer; ++i)
+            memcpy(outptr + i * outptr_stride, inptr + i * outer_stride, n_pixels * pixel_stride * sizeof(float));
         return true;
     }
 
-    if (unlikely(kernel->fn_inner_mirror == NULL)) {
+    if (unlikely(kernel->fn_inner_generation != fastfilters_fir_generation())) {
         kernel->fn_inner_mirror = find_fn(kernel, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, jmptbls_inner,
                                           ARRAY_LENGTH(jmptbls_inner));
         kernel->fn_inner_optimistic = find_fn(kernel, FASTFILTERS_BORDER_OPTIMISTIC, FASTFILTERS_BORDER_OPTIMISTIC,
                                               jmptbls_inner, ARRAY_LENGTH(jmptbls_inner));
         kernel->fn_inner_ptr =
             find_fn(kernel, FASTFILTERS_BORDER_PTR, FASTFILTERS_BORDER_PTR, jmptbls_inner, ARRAY_LENGTH(jmptbls_inner));
+        kernel->fn_inner_generation = fastfilters_fir_generation();
     }
 
     if (likely(left_border == right_border)) {
@@ -196,13 +195,14 @@ bool APPEND_AVXFMA(fastfilters_fir_convolve_fir_outer)(const float *inptr, size_
         return false;
     }
 
-    if (unlikely(kernel->fn_outer_mirror == NULL)) {
+    if (unlikely(kernel->fn_outer_generation != fastfilters_fir_generation())) {
         kernel->fn_outer_mirror = find_fn(kernel, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR, jmptbls_outer,
                                           ARRAY_LENGTH(jmptbls_outer));
         kernel->fn_outer_optimistic = find_fn(kernel, FASTFILTERS_BORDER_OPTIMISTIC, FASTFILTERS_BORDER_OPTIMISTIC,
                                               jmptbls_outer, ARRAY_LENGTH(jmptbls_outer));
         kernel->fn_outer_ptr =
             find_fn(kernel, FASTFILTERS_BORDER_PTR, FASTFILTERS_BORDER_PTR, jmptbls_outer, ARRAY_LENGTH(jmptbls_outer));
+        kernel->fn_outer_generation = fastfilters_fir_generation();
     }
 
     if (likely(left_border == right_border)) {
@@ -229,3 +229,224 @@ bool APPEND_AVXFMA(fastfilters_fir_convolve_fir_outer)(const float *inptr, size_
     return fn(inptr, borderptr_left, borderptr_right, n_pixels, pixel_stride, n_outer, outer_stride, outptr,
               outptr_stride, border_outer_stride, kernel);
 }
+
+// contribution of the pixels k to the right and to the left, kernel_val = coefs[k]
+#define LINE_TAP_SYMMETRIC(k, kernel_val, right, left, acc)                                                            \
+    _mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(right), _mm256_loadu_ps(left)), (kernel_val), (acc))
+#define LINE_TAP_ANTISYMMETRIC(k, kernel_val, right, left, acc)                                                        \
+    _mm256_fmadd_ps(_mm256_sub_ps(_mm256_loadu_ps(right), _mm256_loadu_ps(left)), (kernel_val), (acc))
+#define LINE_TAP_ASYMMETRIC(k, kernel_val, right, left, acc)                                                           \
+    _mm256_fmadd_ps(_mm256_loadu_ps(left), _mm256_broadcast_ss(coefs + len + (k)),                                     \
+                    _mm256_fmadd_ps(_mm256_loadu_ps(right), (kernel_val), (acc)))
+
+// filters row_len floats of row into out. four vectors are filtered at once so their independent accumulations can
+// overlap, the remainder is left to the caller.
+#define LINE_FILTER(TAP)                                                                                               \
+    for (; i < avx_end_unrolled; i += 32) {                                                                            \
+        __m256 acc0 = _mm256_mul_ps(center_val, _mm256_loadu_ps(row + i));                                             \
+        __m256 acc1 = _mm256_mul_ps(center_val, _mm256_loadu_ps(row + i + 8));                                         \
+        __m256 acc2 = _mm256_mul_ps(center_val, _mm256_loadu_ps(row + i + 16));                                        \
+        __m256 acc3 = _mm256_mul_ps(center_val, _mm256_loadu_ps(row + i + 24));                                        \
+                                                                                                                       \
+        for (size_t k = 1; k <= len; ++k) {                                                                            \
+            const __m256 kernel_val = _mm256_broadcast_ss(coefs + k);                                                  \
+            const float *right = row + i + k * pixel_stride;                                                           \
+            const float *left = row + i - k * pixel_stride;                                                            \
+                                                                                                                       \
+            acc0 = TAP(k, kernel_val, right, left, acc0);                                                              \
+            acc1 = TAP(k, kernel_val, right + 8, left + 8, acc1);                                                      \
+            acc2 = TAP(k, kernel_val, right + 16, left + 16, acc2);                                                    \
+            acc3 = TAP(k, kernel_val, right + 24, left + 24, acc3);                                                    \
+        }                                                                                                              \
+                                                                                                                       \
+        _mm256_storeu_ps(out + i, acc0);                                                                               \
+        _mm256_storeu_ps(out + i + 8, acc1);                                                                           \
+        _mm256_storeu_ps(out + i + 16, acc2);                                                                          \
+        _mm256_storeu_ps(out + i + 24, acc3);                                                                          \
+    }                                                                                                                  \
+                                                                                                                       \
+    for (; i < avx_end; i += 8) {                                                                                      \
+        __m256 acc = _mm256_mul_ps(center_val, _mm256_loadu_ps(row + i));                                              \
+                                                                                                                       \
+        for (size_t k = 1; k <= len; ++k)                                                                              \
+            acc = TAP(k, _mm256_broadcast_ss(coefs + k), row + i + k * pixel_stride, row + i - k * pixel_stride, acc); \
+                                                                                                                       \
+        _mm256_storeu_ps(out + i, acc);                                                                                \
+    }
+
+// line holds a row with len mirrored pixels on both sides and stays cached while every kernel sweeps over it
+void APPEND_AVXFMA(fastfilters_fir_convolve_fir_line_multi)(const float *line, size_t n_pixels, size_t pixel_stride,
+                                                           size_t line_len, float *const *outptr,
+                                                           const fastfilters_kernel_fir_t *kernels,
+                                                           unsigned n_kernels)
+{
+    const float *row = line + line_len * pixel_stride;
+    const size_t row_len = n_pixels * pixel_stride;
+    const size_t avx_end_unrolled = row_len & ~31;
+    const size_t avx_end = row_len & ~7;
+
+    for (unsigned j = 0; j < n_kernels; ++j) {
+        const float *coefs = kernels[j]->coefs;
+        const size_t len = kernels[j]->len;
+        const __m256 center_val = _mm256_broadcast_ss(coefs);
+        float *out = outptr[j];
+        size_t i = 0;
+
+        switch (kernels[j]->symmetry) {
+        case FASTFILTERS_KERNEL_SYMMETRIC:
+            LINE_FILTER(LINE_TAP_SYMMETRIC)
+            break;
+        case FASTFILTERS_KERNEL_ANTISYMMETRIC:
+            LINE_FILTER(LINE_TAP_ANTISYMMETRIC)
+            break;
+        default:
+            LINE_FILTER(LINE_TAP_ASYMMETRIC)
+            break;
+        }
+
+        for (; i < row_len; ++i) {
+            float sum = coefs[0] * row[i];
+
+            for (size_t k = 1; k <= len; ++k) {
+                const float right = row[i + k * pixel_stride];
+                const float left = row[i - k * pixel_stride];
+
+                if (kernels[j]->symmetry == FASTFILTERS_KERNEL_SYMMETRIC)
+                    sum += coefs[k] * (right + left);
+                else if (kernels[j]->symmetry == FASTFILTERS_KERNEL_ANTISYMMETRIC)
+                    sum += coefs[k] * (right - left);
+                else
+                    sum += coefs[k] * right + coefs[len + k] * left;
+            }
+
+            out[i] = sum;
+        }
+    }
+}
+
+// four vectors are summed at once like in LINE_FILTER
+void APPEND_AVXFMA(fastfilters_fir_sum_rows)(const float *const *rows, const float *weights, unsigned n_rows,
+                                             float *out, size_t len)
+{
+    const size_t avx_end_unrolled = len & ~31;
+    const size_t avx_end = len & ~7;
+    size_t i = 0;
+
+    for (; i < avx_end_unrolled; i += 32) {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+
+        for (unsigned k = 0; k < n_rows; ++k) {
+            const __m256 w = _mm256_broadcast_ss(weights + k);
+            const float *row = rows[k] + i;
+
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(row), w, acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(row + 8), w, acc1);
+            acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(row + 16), w, acc2);
+            acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(row + 24), w, acc3);
+        }
+
+        _mm256_storeu_ps(out + i, acc0);
+        _mm256_storeu_ps(out + i + 8, acc1);
+        _mm256_storeu_ps(out + i + 16, acc2);
+        _mm256_storeu_ps(out + i + 24, acc3);
+    }
+
+    for (; i < avx_end; i += 8) {
+        __m256 acc = _mm256_setzero_ps();
+
+        for (unsigned k = 0; k < n_rows; ++k)
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(rows[k] + i), _mm256_broadcast_ss(weights + k), acc);
+
+        _mm256_storeu_ps(out + i, acc);
+    }
+
+    for (; i < len; ++i) {
+        float sum = 0.0;
+        for (unsigned k = 0; k < n_rows; ++k)
+            sum += weights[k] * rows[k][i];
+        out[i] = sum;
+    }
+}
+
+#ifndef __FMA__
+#define _mm256_fmsub_ps(a, b, c) (_mm256_sub_ps(_mm256_mul_ps((a), (b)), (c)))
+#endif
+
+// see fastfilters_fir_convolve_fft_block, every lane vector holds one sample of eight signals
+void APPEND_AVXFMA(fastfilters_fir_convolve_fft_block)(const fastfilters_fft_plan_t *plan, float *re, float *im)
+{
+    const size_t n = plan->n_fft;
+
+    for (size_t h = n / 2; h > 1; h /= 2) {
+        for (size_t start = 0; start < n; start += 2 * h) {
+            for (size_t j = 0; j < h; ++j) {
+                const __m256 wr = _mm256_broadcast_ss(plan->twiddle_re + h + j);
+                const __m256 wi = _mm256_broadcast_ss(plan->twiddle_im + h + j);
+                float *ar = re + (start + j) * FFT_LANES;
+                float *ai = im + (start + j) * FFT_LANES;
+                float *br = ar + h * FFT_LANES;
+                float *bi = ai + h * FFT_LANES;
+
+                const __m256 xr = _mm256_load_ps(ar), xi = _mm256_load_ps(ai);
+                const __m256 yr = _mm256_load_ps(br), yi = _mm256_load_ps(bi);
+                const __m256 dr = _mm256_sub_ps(xr, yr), di = _mm256_sub_ps(xi, yi);
+
+                _mm256_store_ps(ar, _mm256_add_ps(xr, yr));
+                _mm256_store_ps(ai, _mm256_add_ps(xi, yi));
+                _mm256_store_ps(br, _mm256_fmsub_ps(dr, wr, _mm256_mul_ps(di, wi)));
+                _mm256_store_ps(bi, _mm256_fmadd_ps(dr, wi, _mm256_mul_ps(di, wr)));
+            }
+        }
+    }
+
+    for (size_t k = 0; k < n; k += 2) {
+        const __m256 hr0 = _mm256_broadcast_ss(plan->kernel_re + k);
+        const __m256 hi0 = _mm256_broadcast_ss(plan->kernel_im + k);
+        const __m256 hr1 = _mm256_broadcast_ss(plan->kernel_re + k + 1);
+        const __m256 hi1 = _mm256_broadcast_ss(plan->kernel_im + k + 1);
+        float *ar = re + k * FFT_LANES;
+        float *ai = im + k * FFT_LANES;
+        float *br = ar + FFT_LANES;
+        float *bi = ai + FFT_LANES;
+
+        const __m256 xr = _mm256_load_ps(ar), xi = _mm256_load_ps(ai);
+        const __m256 yr = _mm256_load_ps(br), yi = _mm256_load_ps(bi);
+        const __m256 sr = _mm256_add_ps(xr, yr), si = _mm256_add_ps(xi, yi);
+        const __m256 dr = _mm256_sub_ps(xr, yr), di = _mm256_sub_ps(xi, yi);
+        const __m256 pr = _mm256_fmsub_ps(sr, hr0, _mm256_mul_ps(si, hi0));
+        const __m256 pi = _mm256_fmadd_ps(sr, hi0, _mm256_mul_ps(si, hr0));
+        const __m256 qr = _mm256_fmsub_ps(dr, hr1, _mm256_mul_ps(di, hi1));
+        const __m256 qi = _mm256_fmadd_ps(dr, hi1, _mm256_mul_ps(di, hr1));
+
+        _mm256_store_ps(ar, _mm256_add_ps(pr, qr));
+        _mm256_store_ps(ai, _mm256_add_ps(pi, qi));
+        _mm256_store_ps(br, _mm256_sub_ps(pr, qr));
+        _mm256_store_ps(bi, _mm256_sub_ps(pi, qi));
+    }
+
+    for (size_t h = 2; h < n; h *= 2) {
+        for (size_t start = 0; start < n; start += 2 * h) {
+            for (size_t j = 0; j < h; ++j) {
+                const __m256 wr = _mm256_broadcast_ss(plan->twiddle_re + h + j);
+                const __m256 wi = _mm256_broadcast_ss(plan->twiddle_im + h + j);
+                float *ar = re + (start + j) * FFT_LANES;
+                float *ai = im + (start + j) * FFT_LANES;
+                float *br = ar + h * FFT_LANES;
+                float *bi = ai + h * FFT_LANES;
+
+                const __m256 xr = _mm256_load_ps(ar), xi = _mm256_load_ps(ai);
+                const __m256 yr = _mm256_load_ps(br), yi = _mm256_load_ps(bi);
+                const __m256 tr = _mm256_fmadd_ps(yr, wr, _mm256_mul_ps(yi, wi));
+                const __m256 ti = _mm256_fmsub_ps(yi, wr, _mm256_mul_ps(yr, wi));
+
+                _mm256_store_ps(ar, _mm256_add_ps(xr, tr));
+                _mm256_store_ps(ai, _mm256_add_ps(xi, ti));
+                _mm256_store_ps(br, _mm256_sub_ps(xr, tr));
+                _mm256_store_ps(bi, _mm256_sub_ps(xi, ti));
+            }
+        }
+    }
+}
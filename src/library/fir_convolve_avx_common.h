@@ -36,7 +36,7 @@
 
 #define fname_outer(outer) BOOST_PP_IF(outer, fir_convolve_outer_impl, fir_convolve_impl)
 #define fname_border(x) BOOST_PP_CAT(border_, x)
-#define fname_symmetric(x) BOOST_PP_IF(x, symmetric, antisymmetric)
+#define fname_symmetric(x) BOOST_PP_TUPLE_ELEM(3, x, (antisymmetric, symmetric, asymmetric))
 #define fname_aligned(x) BOOST_PP_IF(x, aligned, unaligned)
 #define fname_avxfma(x) BOOST_PP_IF(x, avxfma, avx)
 
@@ -52,7 +52,7 @@
 
 #define l_outer (0, (1, BOOST_PP_NIL))
 #define l_border (0, (1, (2, BOOST_PP_NIL)))
-#define l_symmetric (0, (1, BOOST_PP_NIL))
+#define l_symmetric (0, (1, (2, BOOST_PP_NIL)))
 
 #define fname_extern_define_macro(r, prod)                                                                             \
     fname_extern(BOOST_PP_TUPLE_ELEM(5, 0, prod), BOOST_PP_TUPLE_ELEM(5, 1, prod), BOOST_PP_TUPLE_ELEM(5, 2, prod),    \
@@ -64,7 +64,7 @@
 #include "fir_convolve_avx_impl.c"
 #undef FF_BOUNDARY_PTR_RIGHT
 
-#elif !defined(FF_KERNEL_SYMMETRIC) && !defined(FF_KERNEL_ANTISYMMETRIC)
+#elif !defined(FF_KERNEL_SYMMETRIC) && !defined(FF_KERNEL_ANTISYMMETRIC) && !defined(FF_KERNEL_ASYMMETRIC)
 
 #define FF_KERNEL_SYMMETRIC
 #include "fir_convolve_avx_impl.c"
@@ -74,6 +74,10 @@
 #include "fir_convolve_avx_impl.c"
 #undef FF_KERNEL_ANTISYMMETRIC
 
+#define FF_KERNEL_ASYMMETRIC
+#include "fir_convolve_avx_impl.c"
+#undef FF_KERNEL_ASYMMETRIC
+
 #else
 
 #ifdef FF_BOUNDARY_MIRROR_LEFT
@@ -100,6 +104,8 @@
 #define param_symm 1
 #elif defined(FF_KERNEL_ANTISYMMETRIC)
 #define param_symm 0
+#elif defined(FF_KERNEL_ASYMMETRIC)
+#define param_symm 2
 #else
 #error "Unknown symmetry"
 #endif
@@ -111,12 +117,20 @@
 #define FF_KERNEL_LEN_FNAME FF_KERNEL_LEN
 #endif
 
+// contribution of the pixels k to the right and to the left of the current one, kernel_val = coefs[k]
 #ifdef FF_KERNEL_SYMMETRIC
-#define kernel_addsub_ps(a, b) _mm256_add_ps((a), (b))
-#define kernel_addsub_ss(a, b) ((a) + (b))
+#define kernel_fmadd_ps(k, kernel_val, right, left, acc)                                                               \
+    _mm256_fmadd_ps(_mm256_add_ps((right), (left)), (kernel_val), (acc))
+#define kernel_tap_ss(k, right, left) (kernel->coefs[k] * ((right) + (left)))
+#elif defined(FF_KERNEL_ANTISYMMETRIC)
+#define kernel_fmadd_ps(k, kernel_val, right, left, acc)                                                               \
+    _mm256_fmadd_ps(_mm256_sub_ps((right), (left)), (kernel_val), (acc))
+#define kernel_tap_ss(k, right, left) (kernel->coefs[k] * ((right) - (left)))
 #else
-#define kernel_addsub_ps(a, b) _mm256_sub_ps((a), (b))
-#define kernel_addsub_ss(a, b) ((a) - (b))
+#define kernel_fmadd_ps(k, kernel_val, right, left, acc)                                                               \
+    _mm256_fmadd_ps((left), _mm256_broadcast_ss(kernel->coefs + FF_KERNEL_LEN + (k)),                                  \
+                    _mm256_fmadd_ps((right), (kernel_val), (acc)))
+#define kernel_tap_ss(k, right, left) (kernel->coefs[k] * (right) + kernel->coefs[FF_KERNEL_LEN + (k)] * (left))
 #endif
 
 static bool
@@ -165,8 +179,7 @@ static bool
                     else
                         offset_left = x - k;
 
-                    sum += kernel->coefs[k] *
-                           kernel_addsub_ss(cur_input[(x + k) * pixel_stride], cur_input[offset_left * pixel_stride]);
+                    sum += kernel_tap_ss(k, cur_input[(x + k) * pixel_stride], cur_input[offset_left * pixel_stride]);
                 }
 
                 cur_output[x * pixel_stride] = sum;
@@ -177,14 +190,14 @@ static bool
             for (x = 0; x < FF_KERNEL_LEN; ++x) {
                 float sum = kernel->coefs[0] * cur_input[x * pixel_stride];
 
-                for (unsigned int k = 1; k < x; ++k) {
+                for (unsigned int k = 1; k <= FF_KERNEL_LEN; ++k) {
                     float left;
                     if (-(int)k + (int)x < 0)
-                        left = in_border_left[y * borderptr_outer_stride +
+                        left = in_border_left[y * borderptr_outer_stride + c +
                                               (FF_KERNEL_LEN - (int)k + (int)x) * pixel_stride];
                     else
                         left = cur_input[(x - k) * pixel_stride];
-                    sum += kernel->coefs[k] * kernel_addsub_ss(cur_input[(x + k) * pixel_stride], left);
+                    sum += kernel_tap_ss(k, cur_input[(x + k) * pixel_stride], left);
                 }
 
                 cur_output[x * pixel_stride] = sum;
@@ -210,8 +223,8 @@ static bool
                     float sum = kernel->coefs[0] * cur_input[x * pixel_stride];
 
                     for (unsigned int k = 1; k <= FF_KERNEL_LEN; ++k) {
-                        sum += kernel->coefs[k] * kernel_addsub_ss(cur_input[(x + k) * pixel_stride],
-                                                                   *(cur_input + (x - k) * pixel_stride));
+                        sum += kernel_tap_ss(k, cur_input[(x + k) * pixel_stride],
+                                             *(cur_input + x * pixel_stride - k * pixel_stride));
                     }
 
                     cur_output[x * pixel_stride] = sum;
@@ -225,16 +238,15 @@ static bool
             cur_output = outptr + y * outptr_outer_stride;
             for (; x < avx_end_step; x += step) {
                 for (unsigned int subx = 0; subx < tbl_inner[pixel_stride - 2]; ++subx) {
+                    const float *center = cur_input + x * pixel_stride + subx * 8;
                     __m256 kernel_val = _mm256_broadcast_ss(kernel->coefs);
-                    __m256 sum = _mm256_mul_ps(kernel_val, _mm256_loadu_ps(cur_input + x * pixel_stride + subx * 8));
+                    __m256 sum = _mm256_mul_ps(kernel_val, _mm256_loadu_ps(center));
 
                     for (unsigned int k = 1; k <= kernel->len; ++k) {
                         kernel_val = _mm256_broadcast_ss(kernel->coefs + k);
 
-                        __m256 pixels =
-                            kernel_addsub_ps(_mm256_loadu_ps(cur_input + (x + k) * pixel_stride + subx * 8),
-                                             _mm256_loadu_ps(cur_input + (x - k) * pixel_stride + subx * 8));
-                        sum = _mm256_fmadd_ps(pixels, kernel_val, sum);
+                        sum = kernel_fmadd_ps(k, kernel_val, _mm256_loadu_ps(center + k * pixel_stride),
+                                              _mm256_loadu_ps(center - k * pixel_stride), sum);
                     }
 
                     _mm256_storeu_ps(cur_output + x * pixel_stride + subx * 8, sum);
@@ -258,8 +270,8 @@ static bool
                 float sum = cur_input[x * pixel_stride] * kernel->coefs[0];
 
                 for (unsigned int k = 1; k <= FF_KERNEL_LEN; ++k)
-                    sum += kernel->coefs[k] *
-                           kernel_addsub_ss(cur_input[(x + k) * pixel_stride], *(cur_input + ((x - k) * pixel_stride)));
+                    sum += kernel_tap_ss(k, cur_input[(x + k) * pixel_stride],
+                                         *(cur_input + x * pixel_stride - k * pixel_stride));
 
                 cur_output[x * pixel_stride] = sum;
             }
@@ -288,7 +300,7 @@ static bool
                     else
                         right = cur_input[(x + k) * pixel_stride];
 
-                    sum += kernel->coefs[k] * kernel_addsub_ss(right, *(cur_input + ((x - k) * pixel_stride)));
+                    sum += kernel_tap_ss(k, right, *(cur_input + x * pixel_stride - k * pixel_stride));
                 }
 
                 cur_output[x * pixel_stride] = sum;
@@ -354,7 +366,7 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
                 else
                     offset_right = n_pixels - ((k + x) % n_pixels) - 2;
 
-                sum += kernel->coefs[k] * kernel_addsub_ss(cur_input[offset_right], cur_input[offset_left]);
+                sum += kernel_tap_ss(k, cur_input[offset_right], cur_input[offset_left]);
             }
 
             cur_output[x] = sum;
@@ -365,14 +377,14 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
         for (x = 0; x < FF_KERNEL_LEN; ++x) {
             float sum = kernel->coefs[0] * cur_input[x];
 
-            for (unsigned int k = 1; k < x; ++k) {
+            for (unsigned int k = 1; k <= FF_KERNEL_LEN; ++k) {
                 float left;
                 if (-(int)k + (int)x < 0)
                     left = in_border_left[y * borderptr_outer_stride + (FF_KERNEL_LEN - (int)k + (int)x)];
                 else
                     left = cur_input[x - k];
 
-                sum += kernel->coefs[k] * kernel_addsub_ss(cur_input[x + k], left);
+                sum += kernel_tap_ss(k, cur_input[x + k], left);
             }
 
             cur_output[x] = sum;
@@ -387,7 +399,7 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
                 float sum = kernel->coefs[0] * cur_input[x];
 
                 for (unsigned int k = 1; k <= FF_KERNEL_LEN; ++k) {
-                    sum += kernel->coefs[k] * kernel_addsub_ss(cur_input[x + k], *(cur_input + x - k));
+                    sum += kernel_tap_ss(k, cur_input[x + k], *(cur_input + x - k));
                 }
 
                 cur_output[x] = sum;
@@ -401,11 +413,9 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
                 result = _mm256_mul_ps(result, kernel_val);
 
                 for (unsigned j = 1; j <= FF_KERNEL_LEN; ++j) {
-                    __m256 pixels;
-
                     kernel_val = _mm256_broadcast_ss(&kernel->coefs[j]);
-                    pixels = kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j), _mm256_loadu_ps(cur_input + x - j));
-                    result = _mm256_fmadd_ps(pixels, kernel_val, result);
+                    result = kernel_fmadd_ps(j, kernel_val, _mm256_loadu_ps(cur_input + x + j),
+                                             _mm256_loadu_ps(cur_input + x - j), result);
                 }
 
                 _mm256_storeu_ps(cur_output + x, result);
@@ -434,22 +444,15 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
                     // (image[i-j] +
                     // image[i+j]) * kernel[j])
                     // since kernel[-j] = kernel[j] or kernel[-j] = -kernel[j]
-                    __m256 pixels0, pixels1, pixels2, pixels3;
-
-                    pixels0 =
-                        kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j), _mm256_loadu_ps(cur_input + (x - j)));
-                    pixels1 = kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j + 8),
-                                               _mm256_loadu_ps(cur_input + (x - j) + 8));
-                    pixels2 = kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j + 16),
-                                               _mm256_loadu_ps(cur_input + (x - j) + 16));
-                    pixels3 = kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j + 24),
-                                               _mm256_loadu_ps(cur_input + (x - j) + 24));
-
-                    // multiply with kernel value and add to result
-                    result0 = _mm256_fmadd_ps(pixels0, kernel_val, result0);
-                    result1 = _mm256_fmadd_ps(pixels1, kernel_val, result1);
-                    result2 = _mm256_fmadd_ps(pixels2, kernel_val, result2);
-                    result3 = _mm256_fmadd_ps(pixels3, kernel_val, result3);
+                    // asymmetric kernels need a second multiplication for image[i-j] instead
+                    result0 = kernel_fmadd_ps(j, kernel_val, _mm256_loadu_ps(cur_input + x + j),
+                                              _mm256_loadu_ps(cur_input + x - j), result0);
+                    result1 = kernel_fmadd_ps(j, kernel_val, _mm256_loadu_ps(cur_input + x + j + 8),
+                                              _mm256_loadu_ps(cur_input + x - j + 8), result1);
+                    result2 = kernel_fmadd_ps(j, kernel_val, _mm256_loadu_ps(cur_input + x + j + 16),
+                                              _mm256_loadu_ps(cur_input + x - j + 16), result2);
+                    result3 = kernel_fmadd_ps(j, kernel_val, _mm256_loadu_ps(cur_input + x + j + 24),
+                                              _mm256_loadu_ps(cur_input + x - j + 24), result3);
                 }
 
                 _mm256_storeu_ps(cur_output + x, result0);
@@ -467,9 +470,8 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
 
                 for (unsigned j = 1; j <= FF_KERNEL_LEN; ++j) {
                     kernel_val = _mm256_broadcast_ss(&kernel->coefs[j]);
-                    __m256 pixels =
-                        kernel_addsub_ps(_mm256_loadu_ps(cur_input + x + j), _mm256_loadu_ps(cur_input + x - j));
-                    result = _mm256_fmadd_ps(pixels, kernel_val, result);
+                    result = kernel_fmadd_ps(j, kernel_val, _mm256_loadu_ps(cur_input + x + j),
+                                             _mm256_loadu_ps(cur_input + x - j), result);
                 }
 
                 _mm256_storeu_ps(cur_output + x, result);
@@ -486,7 +488,7 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
             float sum = cur_input[x] * kernel->coefs[0];
 
             for (unsigned int k = 1; k <= FF_KERNEL_LEN; ++k) {
-                sum += kernel->coefs[k] * kernel_addsub_ss(cur_input[x + k], *(cur_input + x - k));
+                sum += kernel_tap_ss(k, cur_input[x + k], *(cur_input + x - k));
             }
 
             cur_output[x] = sum;
@@ -509,14 +511,16 @@ bool DLL_LOCAL fname(0, param_boundary_left, param_boundary_right, param_symm, p
                 else
                     right = cur_input[x + k];
 
-                // FIXME: ptr
                 if (unlikely(x < k))
-                    // if (unlikely(((int)x -(int)k) < 0))
+#ifdef FF_BOUNDARY_PTR_LEFT
+                    left = in_border_left[y * borderptr_outer_stride + (FF_KERNEL_LEN - (int)k + (int)x)];
+#else
                     left = *(cur_input + k - x);
+#endif
                 else
                     left = *(cur_input + x - k);
 
-                sum += kernel->coefs[k] * kernel_addsub_ss(right, left);
+                sum += kernel_tap_ss(k, right, left);
             }
 
             cur_output[x] = sum;
@@ -596,8 +600,7 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
                     pixels_right =
                         _mm256_loadu_ps(inptr + (n_pixels - ((i + pixel) % n_pixels) - 2) * pixel_stride + dim);
 
-                pixels = kernel_addsub_ps(pixels_right, pixel_left);
-                result = _mm256_fmadd_ps(pixels, kernel_val, result);
+                result = kernel_fmadd_ps(i, kernel_val, pixels_right, pixel_left, result);
             }
 
             _mm256_store_ps(tmpptr + dim, result);
@@ -629,8 +632,7 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
                     pixels_right = _mm256_maskload_ps(
                         inptr + (n_pixels - ((i + pixel) % n_pixels) - 2) * pixel_stride + dim, mask);
 
-                pixels = kernel_addsub_ps(pixels_right, pixel_left);
-                result = _mm256_fmadd_ps(pixels, kernel_val, result);
+                result = kernel_fmadd_ps(i, kernel_val, pixels_right, pixel_left, result);
             }
 
             _mm256_store_ps(tmpptr + dim, result);
@@ -659,9 +661,8 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
             for (unsigned int i = 1; i <= FF_KERNEL_LEN; ++i) {
                 kernel_val = _mm256_broadcast_ss(kernel->coefs + i);
 
-                pixels = kernel_addsub_ps(_mm256_loadu_ps(inptr + (pixel + i) * pixel_stride + dim),
-                                          _mm256_loadu_ps(inptr + (pixel - i) * pixel_stride + dim));
-                result = _mm256_fmadd_ps(pixels, kernel_val, result);
+                result = kernel_fmadd_ps(i, kernel_val, _mm256_loadu_ps(inptr + (pixel + i) * pixel_stride + dim),
+                                         _mm256_loadu_ps(inptr + (pixel - i) * pixel_stride + dim), result);
             }
 
             _mm256_store_ps(tmpptr + dim, result);
@@ -675,14 +676,19 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
             for (unsigned int i = 1; i <= FF_KERNEL_LEN; ++i) {
                 kernel_val = _mm256_broadcast_ss(kernel->coefs + i);
 
-                pixels = kernel_addsub_ps(_mm256_maskload_ps(inptr + (pixel + i) * pixel_stride + dim, mask),
-                                          _mm256_maskload_ps(inptr + (pixel - i) * pixel_stride + dim, mask));
-                result = _mm256_fmadd_ps(pixels, kernel_val, result);
+                result = kernel_fmadd_ps(i, kernel_val,
+                                         _mm256_maskload_ps(inptr + (pixel + i) * pixel_stride + dim, mask),
+                                         _mm256_maskload_ps(inptr + (pixel - i) * pixel_stride + dim, mask), result);
             }
 
             _mm256_store_ps(tmpptr + dim, result);
         }
 
+#ifdef FF_BOUNDARY_OPTIMISTIC_LEFT
+        if (pixel < FF_KERNEL_LEN)
+            continue;
+#endif
+
         const unsigned writeidx = (pixel + 1) % (FF_KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer_aligned;
         memcpy(outptr + (pixel - FF_KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer * sizeof(float));
@@ -723,15 +729,16 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
                 if (i > pixel) {
 #ifdef FF_BOUNDARY_MIRROR_LEFT
                     pixel_left = _mm256_loadu_ps(inptr + (i - pixel) * pixel_stride + dim);
-#else
+#elif defined(FF_BOUNDARY_PTR_LEFT)
                     pixel_left = _mm256_loadu_ps(in_border_left +
                                                  (FF_KERNEL_LEN + (int)(pixel - i)) * borderptr_outer_stride + dim);
+#else
+                    pixel_left = _mm256_loadu_ps(inptr + dim - (i - pixel) * pixel_stride);
 #endif
                 } else
                     pixel_left = _mm256_loadu_ps(inptr + (pixel - i) * pixel_stride + dim);
 
-                pixels = kernel_addsub_ps(pixel_right, pixel_left);
-                result = _mm256_fmadd_ps(pixels, kernel_val, result);
+                result = kernel_fmadd_ps(i, kernel_val, pixel_right, pixel_left, result);
             }
 
             _mm256_store_ps(tmpptr + dim, result);
@@ -763,20 +770,26 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
                 if (i > pixel) {
 #ifdef FF_BOUNDARY_MIRROR_LEFT
                     pixel_left = _mm256_maskload_ps(inptr + (i - pixel) * pixel_stride + dim, mask);
-#else
+#elif defined(FF_BOUNDARY_PTR_LEFT)
                     pixel_left = _mm256_maskload_ps(
                         in_border_left + (FF_KERNEL_LEN + (int)(pixel - i)) * borderptr_outer_stride + dim, mask);
+#else
+                    pixel_left = _mm256_maskload_ps(inptr + dim - (i - pixel) * pixel_stride, mask);
 #endif
                 } else
                     pixel_left = _mm256_maskload_ps(inptr + (pixel - i) * pixel_stride + dim, mask);
 
-                pixels = kernel_addsub_ps(pixel_right, pixel_left);
-                result = _mm256_fmadd_ps(pixels, kernel_val, result);
+                result = kernel_fmadd_ps(i, kernel_val, pixel_right, pixel_left, result);
             }
 
             _mm256_store_ps(tmpptr + dim, result);
         }
 
+#ifdef FF_BOUNDARY_OPTIMISTIC_LEFT
+        if (pixel < FF_KERNEL_LEN)
+            continue;
+#endif
+
         const unsigned writeidx = (pixel + 1) % (FF_KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer_aligned;
         memcpy(outptr + (pixel - FF_KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer * sizeof(float));
@@ -800,7 +813,7 @@ bool DLL_LOCAL fname(1, param_boundary_left, param_boundary_right, param_symm, p
 #undef param_boundary_left
 #undef param_boundary_right
 #undef FF_KERNEL_LEN_FNAME
-#undef kernel_addsub_ps
-#undef kernel_addsub_ss
+#undef kernel_fmadd_ps
+#undef kernel_tap_ss
 
 #endif
@@ -49,7 +49,7 @@
 #define IMPL_FNAME(z, n, text) &BOOST_PP_CAT(BOOST_PP_CAT(fir_convolve_impl_, text), BOOST_PP_INC(n))
 #define IMPL_OUTER_FNAME(z, n, text) &BOOST_PP_CAT(BOOST_PP_CAT(fir_convolve_outer_impl_, text), BOOST_PP_INC(n))
 
-#define TBLNAME_SYMMETRIC2(x) BOOST_PP_IF(x, symmetric, antisymmetric)
+#define TBLNAME_SYMMETRIC2(x) BOOST_PP_TUPLE_ELEM(3, x, (antisymmetric, symmetric, asymmetric))
 #define TBLNAME_SYMMETRIC(x) BOOST_PP_CAT(TBLNAME_SYMMETRIC2(x), _)
 
 #define TBLNAME_BORDER2(x) BOOST_PP_CAT(border_, x)
@@ -75,8 +75,10 @@
 #define DECL_DEFINE_JMPTBL_INNER(z, n0, n1)                                                                            \
     DEFINE_JMPTBL(0, n0, n1, 0);                                                                                       \
     DEFINE_JMPTBL(0, n0, n1, 1);                                                                                       \
+    DEFINE_JMPTBL(0, n0, n1, 2);                                                                                       \
     DEFINE_JMPTBL(1, n0, n1, 0);                                                                                       \
-    DEFINE_JMPTBL(1, n0, n1, 1);
+    DEFINE_JMPTBL(1, n0, n1, 1);                                                                                       \
+    DEFINE_JMPTBL(1, n0, n1, 2);
 
 #define DECL_DEFINE_JMPTBL_OUTER(z, n, text) BOOST_PP_REPEAT(N_BORDER_TYPES, DECL_DEFINE_JMPTBL_INNER, n)
 BOOST_PP_REPEAT(N_BORDER_TYPES, DECL_DEFINE_JMPTBL_OUTER, ~);
@@ -85,7 +87,7 @@ struct impl_fn_jmptbl_selection {
     impl_fn_t *jmptbl;
     fastfilters_border_treatment_t left_border;
     fastfilters_border_treatment_t right_border;
-    bool is_symmetric;
+    fastfilters_kernel_symmetry_t symmetry;
 };
 
 #define DEFINE_JMPTBL_STRUCT(outer, x, y, symmetric)                                                                   \
@@ -94,17 +96,17 @@ struct impl_fn_jmptbl_selection {
             BOOST_PP_IF(outer, impl_fn_outer_, impl_fn_),                                                              \
             BOOST_PP_CAT(TBLNAME_SYMMETRIC(symmetric), BOOST_PP_CAT(TBLNAME_BORDER(x), TBLNAME_BORDER2(y)))),          \
         .left_border = ENUM_BORDER(x), .right_border = ENUM_BORDER(y),                                                 \
-        .is_symmetric = BOOST_PP_IF(symmetric, true, false)                                                            \
+        .symmetry = symmetric                                                                                          \
     }
 
 #define DECL_DEFINE_JMPTBL_STRUCT_INNER(z, n0, n1)                                                                     \
-    DEFINE_JMPTBL_STRUCT(0, n0, n1, 0), DEFINE_JMPTBL_STRUCT(0, n0, n1, 1),
+    DEFINE_JMPTBL_STRUCT(0, n0, n1, 0), DEFINE_JMPTBL_STRUCT(0, n0, n1, 1), DEFINE_JMPTBL_STRUCT(0, n0, n1, 2),
 
 #define DECL_DEFINE_JMPTBL_STRUCT_OUTER(z, n0, text)                                                                   \
     BOOST_PP_REPEAT(N_BORDER_TYPES, DECL_DEFINE_JMPTBL_STRUCT_INNER, n0)
 
 #define DECL_DEFINE_JMPTBL_STRUCT_INNER2(z, n0, n1)                                                                    \
-    DEFINE_JMPTBL_STRUCT(1, n0, n1, 0), DEFINE_JMPTBL_STRUCT(1, n0, n1, 1),
+    DEFINE_JMPTBL_STRUCT(1, n0, n1, 0), DEFINE_JMPTBL_STRUCT(1, n0, n1, 1), DEFINE_JMPTBL_STRUCT(1, n0, n1, 2),
 
 #define DECL_DEFINE_JMPTBL_STRUCT_OUTER2(z, n0, text)                                                                  \
     BOOST_PP_REPEAT(N_BORDER_TYPES, DECL_DEFINE_JMPTBL_STRUCT_INNER2, n0)
@@ -129,7 +131,7 @@ static impl_fn_t find_fn(fastfilters_kernel_fir_t kernel, fastfilters_border_tre
             continue;
         if (right_border != jmptbls[i].right_border)
             continue;
-        if (kernel->is_symmetric != jmptbls[i].is_symmetric)
+        if (kernel->symmetry != jmptbls[i].symmetry)
             continue;
         jmptbl = jmptbls[i].jmptbl;
         break;
@@ -138,7 +140,7 @@ static impl_fn_t find_fn(fastfilters_kernel_fir_t kernel, fastfilters_border_tre
     if (jmptbl == NULL)
         return NULL;
 
-    if (kernel->len > FF_UNROLL)
+    if (kernel->len > FF_UNROLL || fastfilters_fir_path() == FASTFILTERS_PATH_RUNTIME_LEN)
         return jmptbl[FF_UNROLL];
     else
         return jmptbl[kernel->len - 1];
@@ -159,20 +161,19 @@ bool fastfilters_fir_convolve_fir_inner(const float *inptr, size_t n_pixels, siz
         if (inptr == outptr)
             return true;
 
-        if (outer_stride != n_pixels * pixel_stride)
-            return false;
-
-        memcpy(outptr, inptr, outer_stride * n_outer * sizeof(float));
+        for (size_t i = 0; i < n_outer; ++i)
+            memcpy(outptr + i * outptr_stride, inptr + i * outer_stride, n_pixels * pixel_stride * sizeof(float));
         return true;
     }
 
-    if (unlikely(kernel->fn_inner_mirror == NULL)) {
+    if (unlikely(kernel->fn_inner_generation != fastfilters_fir_generation())) {
         kernel->fn_inner_mirror = find_fn(kernel, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR,
                                           impl_fn_tbls_inner, ARRAY_LENGTH(impl_fn_tbls_inner));
         kernel->fn_inner_optimistic = find_fn(kernel, FASTFILTERS_BORDER_OPTIMISTIC, FASTFILTERS_BORDER_OPTIMISTIC,
                                               impl_fn_tbls_inner, ARRAY_LENGTH(impl_fn_tbls_inner));
         kernel->fn_inner_ptr = find_fn(kernel, FASTFILTERS_BORDER_PTR, FASTFILTERS_BORDER_PTR, impl_fn_tbls_inner,
                                        ARRAY_LENGTH(impl_fn_tbls_inner));
+        kernel->fn_inner_generation = fastfilters_fir_generation();
     }
 
     if (likely(left_border == right_border)) {
@@ -221,13 +222,14 @@ bool fastfilters_fir_convolve_fir_outer(const float *inptr, size_t n_pixels, siz
         return false;
     }
 
-    if (unlikely(kernel->fn_outer_mirror == NULL)) {
+    if (unlikely(kernel->fn_outer_generation != fastfilters_fir_generation())) {
         kernel->fn_outer_mirror = find_fn(kernel, FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_MIRROR,
                                           impl_fn_tbls_outer, ARRAY_LENGTH(impl_fn_tbls_outer));
         kernel->fn_outer_optimistic = find_fn(kernel, FASTFILTERS_BORDER_OPTIMISTIC, FASTFILTERS_BORDER_OPTIMISTIC,
                                               impl_fn_tbls_outer, ARRAY_LENGTH(impl_fn_tbls_outer));
         kernel->fn_outer_ptr = find_fn(kernel, FASTFILTERS_BORDER_PTR, FASTFILTERS_BORDER_PTR, impl_fn_tbls_outer,
                                        ARRAY_LENGTH(impl_fn_tbls_outer));
+        kernel->fn_outer_generation = fastfilters_fir_generation();
     }
 
     if (likely(left_border == right_border)) {
@@ -255,4 +257,141 @@ bool fastfilters_fir_convolve_fir_outer(const float *inptr, size_t n_pixels, siz
 
     return fn(inptr, borderptr_left, borderptr_right, n_pixels, pixel_stride, n_outer, outer_stride, outptr,
               outptr_stride, border_outer_stride, kernel);
-}
\ No newline at end of file
+}
+
+void fastfilters_fir_convolve_fir_line_multi(const float *line, size_t n_pixels, size_t pixel_stride, size_t len,
+                                             float *const *outptr, const fastfilters_kernel_fir_t *kernels,
+                                             unsigned n_kernels)
+{
+    const float *row = line + len * pixel_stride;
+    const size_t row_len = n_pixels * pixel_stride;
+
+    for (unsigned j = 0; j < n_kernels; ++j) {
+        const fastfilters_kernel_fir_t kernel = kernels[j];
+        const float *coefs = kernel->coefs;
+        float *out = outptr[j];
+
+        for (size_t i = 0; i < row_len; ++i) {
+            float sum = coefs[0] * row[i];
+
+            for (size_t k = 1; k <= kernel->len; ++k) {
+                const float right = row[i + k * pixel_stride];
+                const float left = row[i - k * pixel_stride];
+
+                if (kernel->symmetry == FASTFILTERS_KERNEL_SYMMETRIC)
+                    sum += coefs[k] * (right + left);
+                else if (kernel->symmetry == FASTFILTERS_KERNEL_ANTISYMMETRIC)
+                    sum += coefs[k] * (right - left);
+                else
+                    sum += coefs[k] * right + coefs[kernel->len + k] * left;
+            }
+
+            out[i] = sum;
+        }
+    }
+}
+
+// blocks of pixels are summed over all rows at once so that the partial sums can stay in registers
+void fastfilters_fir_sum_rows(const float *const *rows, const float *weights, unsigned n_rows, float *out, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        float sum[16] = {0.0};
+
+        for (unsigned k = 0; k < n_rows; ++k) {
+            const float w = weights[k];
+            const float *row = rows[k] + i;
+
+            for (unsigned j = 0; j < 16; ++j)
+                sum[j] += w * row[j];
+        }
+
+        for (unsigned j = 0; j < 16; ++j)
+            out[i + j] = sum[j];
+    }
+
+    for (; i < len; ++i) {
+        float sum = 0.0;
+        for (unsigned k = 0; k < n_rows; ++k)
+            sum += weights[k] * rows[k][i];
+        out[i] = sum;
+    }
+}
+
+// decimation in frequency down to pairs of samples, multiplication with the kernel spectrum and decimation in time
+// back up. the forward transform leaves the spectrum in bit-reversed order, which is the order the inverse transform
+// expects and the one the kernel spectrum is stored in. the lanes are independent signals.
+void fastfilters_fir_convolve_fft_block(const fastfilters_fft_plan_t *plan, float *re, float *im)
+{
+    const size_t n = plan->n_fft;
+
+    for (size_t h = n / 2; h > 1; h /= 2) {
+        for (size_t start = 0; start < n; start += 2 * h) {
+            for (size_t j = 0; j < h; ++j) {
+                const float wr = plan->twiddle_re[h + j];
+                const float wi = plan->twiddle_im[h + j];
+                float *ar = re + (start + j) * FFT_LANES;
+                float *ai = im + (start + j) * FFT_LANES;
+                float *br = ar + h * FFT_LANES;
+                float *bi = ai + h * FFT_LANES;
+
+                for (unsigned l = 0; l < FFT_LANES; ++l) {
+                    const float dr = ar[l] - br[l];
+                    const float di = ai[l] - bi[l];
+
+                    ar[l] += br[l];
+                    ai[l] += bi[l];
+                    br[l] = dr * wr - di * wi;
+                    bi[l] = dr * wi + di * wr;
+                }
+            }
+        }
+    }
+
+    // last forward stage, multiplication and first inverse stage on neighbouring samples
+    for (size_t k = 0; k < n; k += 2) {
+        const float hr0 = plan->kernel_re[k], hi0 = plan->kernel_im[k];
+        const float hr1 = plan->kernel_re[k + 1], hi1 = plan->kernel_im[k + 1];
+        float *ar = re + k * FFT_LANES;
+        float *ai = im + k * FFT_LANES;
+        float *br = ar + FFT_LANES;
+        float *bi = ai + FFT_LANES;
+
+        for (unsigned l = 0; l < FFT_LANES; ++l) {
+            const float sr = ar[l] + br[l], si = ai[l] + bi[l];
+            const float dr = ar[l] - br[l], di = ai[l] - bi[l];
+            const float pr = sr * hr0 - si * hi0, pi = sr * hi0 + si * hr0;
+            const float qr = dr * hr1 - di * hi1, qi = dr * hi1 + di * hr1;
+
+            ar[l] = pr + qr;
+            ai[l] = pi + qi;
+            br[l] = pr - qr;
+            bi[l] = pi - qi;
+        }
+    }
+
+    for (size_t h = 2; h < n; h *= 2) {
+        for (size_t start = 0; start < n; start += 2 * h) {
+            for (size_t j = 0; j < h; ++j) {
+                const float wr = plan->twiddle_re[h + j];
+                const float wi = plan->twiddle_im[h + j];
+                float *ar = re + (start + j) * FFT_LANES;
+                float *ai = im + (start + j) * FFT_LANES;
+                float *br = ar + h * FFT_LANES;
+                float *bi = ai + h * FFT_LANES;
+
+                // conjugated twiddle factors
+                for (unsigned l = 0; l < FFT_LANES; ++l) {
+                    const float tr = br[l] * wr + bi[l] * wi;
+                    const float ti = bi[l] * wr - br[l] * wi;
+
+                    br[l] = ar[l] - tr;
+                    bi[l] = ai[l] - ti;
+                    ar[l] += tr;
+                    ai[l] += ti;
+                }
+            }
+        }
+    }
+}
@@ -48,7 +48,7 @@
 #include "fir_convolve_nosimd_impl.h"
 #undef FF_BOUNDARY_PTR_RIGHT
 
-#elif !defined(FF_KERNEL_SYMMETRIC) && !defined(FF_KERNEL_ANTISYMMETRIC)
+#elif !defined(FF_KERNEL_SYMMETRIC) && !defined(FF_KERNEL_ANTISYMMETRIC) && !defined(FF_KERNEL_ASYMMETRIC)
 
 #define FF_KERNEL_SYMMETRIC
 #include "fir_convolve_nosimd_impl.h"
@@ -58,6 +58,10 @@
 #include "fir_convolve_nosimd_impl.h"
 #undef FF_KERNEL_ANTISYMMETRIC
 
+#define FF_KERNEL_ASYMMETRIC
+#include "fir_convolve_nosimd_impl.h"
+#undef FF_KERNEL_ASYMMETRIC
+
 #else
 
 #ifdef FF_BOUNDARY_OPTIMISTIC_LEFT
@@ -80,12 +84,18 @@
 #error "No boundary treatment mode defined."
 #endif
 
+// contribution of the pixels k to the right and to the left of the current one
 #ifdef FF_KERNEL_SYMMETRIC
 #define symmetry_name symmetric
+#define kernel_tap(k, right, left) (kernel->coefs[k] * ((right) + (left)))
 #elif defined(FF_KERNEL_ANTISYMMETRIC)
 #define symmetry_name antisymmetric
+#define kernel_tap(k, right, left) (kernel->coefs[k] * ((right) - (left)))
+#elif defined(FF_KERNEL_ASYMMETRIC)
+#define symmetry_name asymmetric
+#define kernel_tap(k, right, left) (kernel->coefs[k] * (right) + kernel->coefs[KERNEL_LEN + (k)] * (left))
 #else
-#error "FF_KERNEL_SYMMETRIC and FF_KERNEL_ANTISYMMETRIC not defined"
+#error "FF_KERNEL_SYMMETRIC, FF_KERNEL_ANTISYMMETRIC and FF_KERNEL_ASYMMETRIC not defined"
 #endif
 
 #define boundary_name BOOST_PP_CAT(boundary_name_left, boundary_name_right)
@@ -141,13 +151,7 @@ static bool BOOST_PP_CAT(FNAME, _impl)(const float *inptr, const float *in_borde
                     offset_right = n_pixels - ((k + j) % n_pixels) - 2;
                 else
                     offset_right = j + k;
-#ifdef FF_KERNEL_SYMMETRIC
-                sum +=
-                    kernel->coefs[k] * (cur_inptr[offset_right * pixel_stride] + cur_inptr[offset_left * pixel_stride]);
-#else
-                sum +=
-                    kernel->coefs[k] * (cur_inptr[offset_right * pixel_stride] - cur_inptr[offset_left * pixel_stride]);
-#endif
+                sum += kernel_tap(k, cur_inptr[offset_right * pixel_stride], cur_inptr[offset_left * pixel_stride]);
             }
 
             cur_outptr[j * pixel_stride] = sum;
@@ -170,11 +174,7 @@ static bool BOOST_PP_CAT(FNAME, _impl)(const float *inptr, const float *in_borde
                 else
                     left = cur_inptr[(j - k) * pixel_stride];
 
-#ifdef FF_KERNEL_SYMMETRIC
-                sum += kernel->coefs[k] * (cur_inptr[(j + k) * pixel_stride] + left);
-#else
-                sum += kernel->coefs[k] * (cur_inptr[(j + k) * pixel_stride] - left);
-#endif
+                sum += kernel_tap(k, cur_inptr[(j + k) * pixel_stride], left);
             }
 
             cur_outptr[j * pixel_stride] = sum;
@@ -194,11 +194,7 @@ static bool BOOST_PP_CAT(FNAME, _impl)(const float *inptr, const float *in_borde
 
             for (unsigned int k = 1; k <= KERNEL_LEN; ++k) {
                 int offset_left = (int)(i_inner - k) * pixel_stride;
-#ifdef FF_KERNEL_SYMMETRIC
-                sum += kernel->coefs[k] * (cur_inptr[(i_inner + k) * pixel_stride] + cur_inptr[offset_left]);
-#else
-                sum += kernel->coefs[k] * (cur_inptr[(i_inner + k) * pixel_stride] - cur_inptr[offset_left]);
-#endif
+                sum += kernel_tap(k, cur_inptr[(i_inner + k) * pixel_stride], cur_inptr[offset_left]);
             }
 
             cur_outptr[i_inner * pixel_stride] = sum;
@@ -222,13 +218,7 @@ static bool BOOST_PP_CAT(FNAME, _impl)(const float *inptr, const float *in_borde
                     offset_right = n_pixels - ((k + i_inner) % n_pixels) - 2;
                 else
                     offset_right = i_inner + k;
-#ifdef FF_KERNEL_SYMMETRIC
-                sum +=
-                    kernel->coefs[k] * (cur_inptr[offset_right * pixel_stride] + cur_inptr[offset_left * pixel_stride]);
-#else
-                sum +=
-                    kernel->coefs[k] * (cur_inptr[offset_right * pixel_stride] - cur_inptr[offset_left * pixel_stride]);
-#endif
+                sum += kernel_tap(k, cur_inptr[offset_right * pixel_stride], cur_inptr[offset_left * pixel_stride]);
             }
 
             cur_outptr[i_inner * pixel_stride] = sum;
@@ -245,14 +235,11 @@ static bool BOOST_PP_CAT(FNAME, _impl)(const float *inptr, const float *in_borde
                 float right;
 
                 if (k + i_inner >= n_pixels)
-                    right = in_border_right[i_outer * borderptr_outer_stride + ((k + i_inner) % n_pixels)];
+                    right =
+                        in_border_right[i_outer * borderptr_outer_stride + ((k + i_inner) % n_pixels) * pixel_stride];
                 else
                     right = cur_inptr[(i_inner + k) * pixel_stride];
-#ifdef FF_KERNEL_SYMMETRIC
-                sum += kernel->coefs[k] * (right + cur_inptr[(i_inner - k) * pixel_stride]);
-#else
-                sum += kernel->coefs[k] * (right - cur_inptr[(i_inner - k) * pixel_stride]);
-#endif
+                sum += kernel_tap(k, right, *(cur_inptr + i_inner * pixel_stride - k * pixel_stride));
             }
 
             cur_outptr[i_inner * pixel_stride] = sum;
@@ -301,9 +288,6 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
     (void)borderptr_outer_stride;
 #endif
 
-    if (n_outer != outptr_outer_stride)
-        return false;
-
     float *tmp = fastfilters_memory_alloc((KERNEL_LEN + 1) * n_outer * sizeof(float));
 
     if (!tmp)
@@ -331,13 +315,8 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
                 else
                     offset_right = i_pixel + k;
 
-#ifdef FF_KERNEL_SYMMETRIC
-                sum += kernel->coefs[k] * (inptr[offset_right * pixel_stride + outer_stride * i_outer] +
-                                           inptr[offset_left * pixel_stride + outer_stride * i_outer]);
-#else
-                sum += kernel->coefs[k] * (inptr[offset_right * pixel_stride + outer_stride * i_outer] -
-                                           inptr[offset_left * pixel_stride + outer_stride * i_outer]);
-#endif
+                sum += kernel_tap(k, inptr[offset_right * pixel_stride + outer_stride * i_outer],
+                                  inptr[offset_left * pixel_stride + outer_stride * i_outer]);
             }
 
             tmp[n_outer * i_pixel + i_outer] = sum;
@@ -360,11 +339,7 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
                 else
                     left = inptr[(i_pixel - k) * pixel_stride + outer_stride * i_outer];
 
-#ifdef FF_KERNEL_SYMMETRIC
-                sum += kernel->coefs[k] * (inptr[(i_pixel + k) * pixel_stride + outer_stride * i_outer] + left);
-#else
-                sum += kernel->coefs[k] * (inptr[(i_pixel + k) * pixel_stride + outer_stride * i_outer] - left);
-#endif
+                sum += kernel_tap(k, inptr[(i_pixel + k) * pixel_stride + outer_stride * i_outer], left);
             }
 
             tmp[n_outer * i_pixel + i_outer] = sum;
@@ -389,13 +364,7 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
 
             for (unsigned int k = 1; k <= KERNEL_LEN; ++k) {
                 int offset_left = (i_pixel - k) * pixel_stride + outer_stride * i_outer;
-#ifdef FF_KERNEL_SYMMETRIC
-                sum += kernel->coefs[k] *
-                       (inptr[(i_pixel + k) * pixel_stride + outer_stride * i_outer] + inptr[offset_left]);
-#else
-                sum += kernel->coefs[k] *
-                       (inptr[(i_pixel + k) * pixel_stride + outer_stride * i_outer] - inptr[offset_left]);
-#endif
+                sum += kernel_tap(k, inptr[(i_pixel + k) * pixel_stride + outer_stride * i_outer], inptr[offset_left]);
             }
 
             tmpptr[i_outer] = sum;
@@ -408,8 +377,7 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
 
         const unsigned writeidx = (i_pixel + 1) % (KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer;
-        // FIXME: outer_stride
-        memcpy(outptr + (i_pixel - KERNEL_LEN) * pixel_stride, writeptr, n_outer * sizeof(float));
+        memcpy(outptr + (i_pixel - KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer * sizeof(float));
     }
 
 // right border
@@ -435,22 +403,21 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
                 else
                     offset_right = i_pixel + k;
 
-#ifdef FF_KERNEL_SYMMETRIC
-                sum += kernel->coefs[k] * (inptr[offset_right * pixel_stride + outer_stride * i_outer] +
-                                           inptr[offset_left * pixel_stride + outer_stride * i_outer]);
-#else
-                sum += kernel->coefs[k] * (inptr[offset_right * pixel_stride + outer_stride * i_outer] -
-                                           inptr[offset_left * pixel_stride + outer_stride * i_outer]);
-#endif
+                sum += kernel_tap(k, inptr[offset_right * pixel_stride + outer_stride * i_outer],
+                                  inptr[offset_left * pixel_stride + outer_stride * i_outer]);
             }
 
             tmpptr[i_outer] = sum;
         }
 
+#ifdef FF_BOUNDARY_OPTIMISTIC_LEFT
+        if (i_pixel < KERNEL_LEN)
+            continue;
+#endif
+
         const unsigned writeidx = (i_pixel + 1) % (KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer;
-        // FIXME: outer_stride
-        memcpy(outptr + (i_pixel - KERNEL_LEN) * pixel_stride, writeptr, n_outer * sizeof(float));
+        memcpy(outptr + (i_pixel - KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer * sizeof(float));
     }
 #endif
 
@@ -472,20 +439,21 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
                 else
                     right = inptr[(i_pixel + k) * pixel_stride + outer_stride * i_outer];
 
-#ifdef FF_KERNEL_SYMMETRIC
-                sum += kernel->coefs[k] * (right + inptr[(i_pixel - k) * pixel_stride + outer_stride * i_outer]);
-#else
-                sum += kernel->coefs[k] * (right - inptr[(i_pixel - k) * pixel_stride + outer_stride * i_outer]);
-#endif
+                sum += kernel_tap(k, right,
+                                  *(inptr + i_pixel * pixel_stride - k * pixel_stride + outer_stride * i_outer));
             }
 
             tmpptr[i_outer] = sum;
         }
 
+#ifdef FF_BOUNDARY_OPTIMISTIC_LEFT
+        if (i_pixel < KERNEL_LEN)
+            continue;
+#endif
+
         const unsigned writeidx = (i_pixel + 1) % (KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer;
-        // FIXME: outer_stride
-        memcpy(outptr + (i_pixel - KERNEL_LEN) * pixel_stride, writeptr, n_outer * sizeof(float));
+        memcpy(outptr + (i_pixel - KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer * sizeof(float));
     }
 #endif
 
@@ -493,8 +461,7 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
         unsigned pixel = n_pixels + i;
         const unsigned writeidx = (pixel + 1) % (KERNEL_LEN + 1);
         float *writeptr = tmp + writeidx * n_outer;
-        // FIXME: outer_stride
-        memcpy(outptr + (pixel - KERNEL_LEN) * pixel_stride, writeptr, n_outer * sizeof(float));
+        memcpy(outptr + (pixel - KERNEL_LEN) * outptr_outer_stride, writeptr, n_outer * sizeof(float));
     }
 
     fastfilters_memory_free(tmp);
@@ -502,6 +469,7 @@ static bool FNAME(const float *inptr, const float *in_border_left, const float *
 }
 
 #undef symmetry_name
+#undef kernel_tap
 #undef boundary_name
 #undef boundary_name_left
 #undef boundary_name_right
@@ -0,0 +1,422 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+// large scales are evaluated on a grid decimated by f along every axis whose sigma is at least 2 * f pixels:
+//
+//   1. the input is smoothed with a gaussian of sigma f and sampled at every f-th pixel,
+//   2. the requested kernel is applied to the samples with the remaining variance,
+//   3. the result is interpolated with another gaussian of sigma f, unless the decimated result is returned.
+//
+// the variances of the three steps add up to sigma^2. the spectra of the steps overlap the aliased frequencies by at
+// most exp(-3 pi^2 / 2), about 4e-7, at sigma = 2 * f, so the deviation from filtering at full resolution is
+// dominated by the truncation of the kernels.
+
+// radius of the resampling kernels in units of f
+#define RESAMPLE_RADIUS 4
+
+// resampling along one axis, either decimating n_in pixels to every f-th pixel with pad mirrored samples on both
+// sides, or interpolating n_out pixels from such samples.
+typedef struct {
+    size_t n_in;
+    size_t n_out;
+    unsigned f;
+    size_t pad;
+    bool interpolate;
+    unsigned n_taps;
+    // n_taps weights when decimating, n_taps weights for every phase x % f when interpolating
+    float *weights;
+} resample_t;
+
+static size_t reflect(ptrdiff_t i, size_t n)
+{
+    const ptrdiff_t period = 2 * ((ptrdiff_t)n - 1);
+
+    if (i >= 0 && i < (ptrdiff_t)n)
+        return i;
+    if (n == 1)
+        return 0;
+
+    i %= period;
+    if (i < 0)
+        i += period;
+
+    return i < (ptrdiff_t)n ? (size_t)i : (size_t)(period - i);
+}
+
+static double resample_weight(double d, unsigned f)
+{
+    return exp(-0.5 * d * d / ((double)f * f));
+}
+
+static bool resample_init(resample_t *r, size_t n, unsigned f, size_t pad, bool interpolate)
+{
+    const int radius = interpolate ? RESAMPLE_RADIUS : RESAMPLE_RADIUS * (int)f;
+
+    r->f = f;
+    r->pad = pad;
+    r->interpolate = interpolate;
+    r->n_taps = 2 * radius + 1;
+    r->n_in = interpolate ? (n + f - 1) / f + 2 * pad : n;
+    r->n_out = interpolate ? n : (n + f - 1) / f + 2 * pad;
+
+    r->weights = fastfilters_memory_alloc((interpolate ? f : 1) * r->n_taps * sizeof(float));
+    if (!r->weights)
+        return false;
+
+    for (unsigned p = 0; p < (interpolate ? f : 1); ++p) {
+        float *weights = r->weights + p * r->n_taps;
+        double norm = 0.0;
+
+        // the interpolated pixel f * m + p lies p pixels after sample m
+        for (int t = -radius; t <= radius; ++t)
+            norm += resample_weight(interpolate ? (double)p - (double)t * f : t, f);
+        for (int t = -radius; t <= radius; ++t)
+            weights[t + radius] = resample_weight(interpolate ? (double)p - (double)t * f : t, f) / norm;
+    }
+
+    return true;
+}
+
+static void resample_free(resample_t *r)
+{
+    if (r->weights)
+        fastfilters_memory_free(r->weights);
+}
+
+// index of the input pixel read by tap k of output pixel i
+static size_t resample_index(const resample_t *r, size_t i, unsigned k)
+{
+    const int radius = (r->n_taps - 1) / 2;
+
+    if (r->interpolate)
+        return i / r->f + r->pad + k - radius;
+
+    return reflect(((ptrdiff_t)i - (ptrdiff_t)r->pad) * r->f + (ptrdiff_t)k - radius, r->n_in);
+}
+
+static const float *resample_weights(const resample_t *r, size_t i)
+{
+    return r->interpolate ? r->weights + (i % r->f) * r->n_taps : r->weights;
+}
+
+static void row_accumulate(bool first, float w, const float *in, size_t in_stride, float *out, size_t out_stride,
+                           size_t n_x, size_t n_channels)
+{
+    if (in_stride == n_channels && out_stride == n_channels) {
+        const size_t len = n_x * n_channels;
+
+        if (first)
+            for (size_t i = 0; i < len; ++i)
+                out[i] = w * in[i];
+        else
+            for (size_t i = 0; i < len; ++i)
+                out[i] += w * in[i];
+        return;
+    }
+
+    for (size_t x = 0; x < n_x; ++x)
+        for (size_t c = 0; c < n_channels; ++c) {
+            const float v = w * in[x * in_stride + c];
+            out[x * out_stride + c] = first ? v : out[x * out_stride + c] + v;
+        }
+}
+
+// along x, the pixels are split into their f phases x % f first. every tap then reads a contiguous run of one phase
+// for all output pixels, which keeps the inner loops vectorizable.
+static size_t phase_len(const resample_t *r)
+{
+    if (r->interpolate)
+        return r->n_in;
+    return ((r->n_out - 1) * r->f + r->n_taps + r->f - 1) / r->f;
+}
+
+// phase[m] = in[x0 + m * f] for m < n, mirrored at the borders of the row
+static void gather_phase(const float *in, size_t in_stride, size_t n_in, ptrdiff_t x0, unsigned f, size_t n,
+                         size_t n_channels, float *phase)
+{
+    const ptrdiff_t first_inside = x0 >= 0 ? 0 : (f - 1 - x0) / f;
+    const ptrdiff_t end_inside = ((ptrdiff_t)n_in - x0 + f - 1) / f;
+    const size_t begin = first_inside < (ptrdiff_t)n ? (size_t)first_inside : n;
+    const size_t end = end_inside < (ptrdiff_t)begin ? begin : end_inside < (ptrdiff_t)n ? (size_t)end_inside : n;
+
+    for (size_t m = 0; m < n; ++m) {
+        if (m == begin && n_channels == 1) {
+            for (; m < end; ++m)
+                phase[m] = in[(x0 + (ptrdiff_t)(m * f)) * in_stride];
+            if (m == n)
+                break;
+        }
+
+        const float *src = in + reflect(x0 + (ptrdiff_t)(m * f), n_in) * in_stride;
+        for (size_t c = 0; c < n_channels; ++c)
+            phase[m * n_channels + c] = src[c];
+    }
+}
+
+static void resample_row_x(const resample_t *r, const float *in, size_t in_stride, float *out, size_t out_stride,
+                           size_t n_channels, float *phases, float *acc, const float **rows)
+{
+    const size_t n_phase = phase_len(r);
+    const unsigned f = r->f;
+    const unsigned radius = (r->n_taps - 1) / 2;
+
+    if (!r->interpolate) {
+        const ptrdiff_t first = -(ptrdiff_t)radius - (ptrdiff_t)(r->pad * f);
+        float *sum = out_stride == n_channels ? out : acc;
+
+        for (unsigned p = 0; p < f; ++p)
+            gather_phase(in, in_stride, r->n_in, first + (ptrdiff_t)p, f, n_phase, n_channels,
+                         phases + p * n_phase * n_channels);
+
+        for (unsigned k = 0; k < r->n_taps; ++k)
+            rows[k] = phases + ((k % f) * n_phase + k / f) * n_channels;
+        fastfilters_fir_weighted_sum(rows, r->weights, r->n_taps, sum, r->n_out * n_channels);
+
+        if (sum == acc)
+            row_accumulate(true, 1.0, acc, n_channels, out, out_stride, r->n_out, n_channels);
+        return;
+    }
+
+    // the input is a packed temporary array here, every phase x % f is computed for all samples at once
+    const size_t n_m = (r->n_out + f - 1) / f;
+
+    for (unsigned k = 0; k < r->n_taps; ++k)
+        rows[k] = in + (r->pad + k - radius) * n_channels;
+
+    for (unsigned p = 0; p < f; ++p) {
+        fastfilters_fir_weighted_sum(rows, r->weights + p * r->n_taps, r->n_taps, acc, n_m * n_channels);
+        row_accumulate(true, 1.0, acc, n_channels, out + p * out_stride, f * out_stride,
+                       (r->n_out - p + f - 1) / f, n_channels);
+    }
+    (void)in_stride;
+}
+
+// resamples in along axis into out, whose extent along axis is r->n_out
+static bool resample_axis(const fastfilters_array3d_t *in, unsigned axis, const resample_t *r,
+                          const fastfilters_array3d_t *out)
+{
+    const size_t n_channels = in->n_channels;
+    const float **rows = fastfilters_memory_alloc(r->n_taps * sizeof(*rows));
+
+    if (!rows)
+        return false;
+
+    if (axis == 0) {
+        float *phases = fastfilters_memory_align(32, r->f * phase_len(r) * n_channels * sizeof(float));
+        float *acc = fastfilters_memory_align(32, r->n_out * n_channels * sizeof(float));
+        bool result = phases && acc;
+
+        for (size_t z = 0; result && z < out->n_z; ++z)
+            for (size_t y = 0; y < out->n_y; ++y)
+                resample_row_x(r, in->ptr + z * in->stride_z + y * in->stride_y, in->stride_x,
+                               out->ptr + z * out->stride_z + y * out->stride_y, out->stride_x, n_channels, phases,
+                               acc, rows);
+
+        if (phases)
+            fastfilters_memory_align_free(phases);
+        if (acc)
+            fastfilters_memory_align_free(acc);
+        fastfilters_memory_free(rows);
+        return result;
+    }
+
+    // along y and z whole rows are accumulated
+    const size_t n_other = axis == 1 ? out->n_z : out->n_y;
+    const size_t in_other = axis == 1 ? in->stride_z : in->stride_y;
+    const size_t out_other = axis == 1 ? out->stride_z : out->stride_y;
+    const size_t in_step = axis == 1 ? in->stride_y : in->stride_z;
+    const size_t out_step = axis == 1 ? out->stride_y : out->stride_z;
+
+    for (size_t o = 0; o < n_other; ++o)
+        for (size_t i = 0; i < r->n_out; ++i) {
+            const float *weights = resample_weights(r, i);
+            float *outrow = out->ptr + o * out_other + i * out_step;
+
+            for (unsigned k = 0; k < r->n_taps; ++k)
+                rows[k] = in->ptr + o * in_other + resample_index(r, i, k) * in_step;
+
+            if (in->stride_x == n_channels && out->stride_x == n_channels) {
+                fastfilters_fir_weighted_sum(rows, weights, r->n_taps, outrow, out->n_x * n_channels);
+                continue;
+            }
+
+            for (unsigned k = 0; k < r->n_taps; ++k)
+                row_accumulate(k == 0, weights[k], rows[k], in->stride_x, outrow, out->stride_x, out->n_x,
+                               n_channels);
+        }
+
+    fastfilters_memory_free(rows);
+    return true;
+}
+
+static fastfilters_array3d_t *array_resized(const fastfilters_array3d_t *a, unsigned axis, size_t n)
+{
+    size_t dims[3] = {a->n_x, a->n_y, a->n_z};
+    dims[axis] = n;
+    return fastfilters_array3d_alloc(dims[0], dims[1], dims[2], a->n_channels);
+}
+
+bool DLL_LOCAL fastfilters_fir_derivative_decimated(const fastfilters_array3d_t *in, unsigned n_axes,
+                                                    const unsigned *order, const double *sigma,
+                                                    const fastfilters_array3d_t *out,
+                                                    const fastfilters_options_t *options)
+{
+    bool result = false;
+    const unsigned decimation = opt_decimation(options) > 1 ? opt_decimation(options) : 1;
+    const size_t n[3] = {in->n_x, in->n_y, in->n_z};
+    const size_t n_out[3] = {out->n_x, out->n_y, out->n_z};
+    bool full_out = n_out[2] == n[2];
+    bool decimated_out = decimation > 1 && n_out[2] == (n_axes == 3 ? (n[2] + decimation - 1) / decimation : n[2]);
+    bool resampled = false;
+    unsigned f[3] = {1, 1, 1};
+    size_t pad[3] = {0, 0, 0};
+    fastfilters_kernel_fir_t k[3] = {NULL, NULL, NULL};
+    resample_t down[3], up[3];
+    fastfilters_array3d_t *tmp[7];
+    unsigned n_tmp = 0;
+    unsigned last = 0;
+    const fastfilters_array3d_t *cur = in;
+
+    memset(down, 0, sizeof(down));
+    memset(up, 0, sizeof(up));
+
+    for (unsigned a = 0; a < 2; ++a) {
+        full_out = full_out && n_out[a] == n[a];
+        decimated_out = decimated_out && n_out[a] == (n[a] + decimation - 1) / decimation;
+    }
+
+    if (full_out)
+        decimated_out = false;
+    else if (!decimated_out)
+        goto out;
+
+    for (unsigned a = 0; a < n_axes; ++a) {
+        const double voxel_size = opt_voxel_size(options, a);
+        const double sigma_px = sigma[a] / voxel_size;
+        double variance = sigma_px * sigma_px;
+
+        f[a] = decimation;
+        if (decimated_out && sigma_px < 2.0 * f[a])
+            goto out;
+        while (f[a] > 1 && sigma_px < 2.0 * f[a])
+            f[a] /= 2;
+
+        if (f[a] > 1) {
+            variance -= (decimated_out ? 1.0 : 2.0) * f[a] * f[a];
+            resampled = true;
+        }
+
+        k[a] = fastfilters_kernel_fir_gaussian_opt(order[a], sqrt(variance) / f[a], options);
+        if (!k[a])
+            goto out;
+
+        // derivatives on the coarse grid are taken with respect to its sample distance
+        if (order[a] > 0 && f[a] * voxel_size != 1.0)
+            fastfilters_kernel_fir_scale(k[a], pow(f[a] * voxel_size, -(double)order[a]));
+
+        if (f[a] == 1)
+            continue;
+
+        // the padding keeps the borders of the coarse filter away from all samples that are used
+        pad[a] = k[a]->len + (decimated_out ? 0 : RESAMPLE_RADIUS);
+        if (!resample_init(&down[a], n[a], f[a], pad[a], false))
+            goto out;
+        if (!decimated_out && !resample_init(&up[a], n[a], f[a], pad[a], true))
+            goto out;
+    }
+
+    if (!resampled) {
+        result = fastfilters_fir_convolve3d(in, k[0], k[1], k[2], out, options);
+        goto out;
+    }
+
+    for (unsigned a = 0; a < n_axes; ++a) {
+        if (f[a] == 1)
+            continue;
+
+        tmp[n_tmp] = array_resized(cur, a, down[a].n_out);
+        if (!tmp[n_tmp])
+            goto out;
+
+        if (!resample_axis(cur, a, &down[a], tmp[n_tmp]))
+            goto out;
+        cur = tmp[n_tmp++];
+    }
+
+    tmp[n_tmp] = array_resized(cur, 0, cur->n_x);
+    if (!tmp[n_tmp])
+        goto out;
+
+    if (!fastfilters_fir_convolve3d(cur, k[0], k[1], k[2], tmp[n_tmp], options))
+        goto out;
+    cur = tmp[n_tmp++];
+
+    if (decimated_out) {
+        const fastfilters_array3d_t view = {cur->ptr + pad[0] * cur->stride_x + pad[1] * cur->stride_y +
+                                                pad[2] * cur->stride_z,
+                                            out->n_x, out->n_y, out->n_z, cur->stride_x, cur->stride_y,
+                                            cur->stride_z, cur->n_channels};
+        fastfilters_array3d_copy(&view, out);
+        result = true;
+        goto out;
+    }
+
+    for (unsigned a = 0; a < n_axes; ++a)
+        if (f[a] > 1)
+            last = a;
+
+    for (unsigned a = 0; a <= last; ++a) {
+        if (f[a] == 1)
+            continue;
+
+        if (a == last) {
+            result = resample_axis(cur, a, &up[a], out);
+            goto out;
+        }
+
+        tmp[n_tmp] = array_resized(cur, a, n[a]);
+        if (!tmp[n_tmp])
+            goto out;
+
+        if (!resample_axis(cur, a, &up[a], tmp[n_tmp]))
+            goto out;
+        cur = tmp[n_tmp++];
+    }
+
+out:
+    for (unsigned a = 0; a < 3; ++a) {
+        resample_free(&down[a]);
+        resample_free(&up[a]);
+    }
+    for (unsigned i = 0; i < n_tmp; ++i)
+        fastfilters_array3d_free(tmp[i]);
+    for (unsigned a = 0; a < 3; ++a)
+        if (k[a])
+            fastfilters_kernel_fir_free(k[a]);
+
+    return result;
+}
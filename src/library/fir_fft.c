@@ -0,0 +1,428 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+// long kernels (see fastfilters_tuning_t) are applied by overlap-save: every line is split into blocks of n_fft
+// samples overlapping by 2 * len, each block is convolved circularly in the frequency domain
+// (fastfilters_fir_fft_block) and only the samples not affected by the wrap-around are kept. as the kernels are real
+// two signals are convolved at once as the real and imaginary part of one complex signal, and FFT_LANES of those are
+// interleaved so that the butterflies work on whole vectors. with radix-2 transforms a block costs about
+// n_fft * log2(n_fft) butterflies compared to 2 * len + 1 multiply-adds per pixel for the direct convolution, which
+// makes the frequency domain faster from about len = 20 (a gaussian with sigma 7) on, the FFT_MIN_KERNEL_LEN default.
+#define FFT_MAX_LOG2 16
+#define FFT_SIGNALS (2 * FFT_LANES)
+
+// per-sample cost of the gathering, scattering and kernel multiplication of a block in butterfly stages
+#define FFT_BLOCK_OVERHEAD 2
+
+bool DLL_LOCAL fastfilters_fir_fft_preferred(const fastfilters_kernel_fir_t kernel, size_t n_pixels,
+                                             fastfilters_border_treatment_t left_border,
+                                             fastfilters_border_treatment_t right_border, bool outer)
+{
+    const fastfilters_tuning_t *tuning = fastfilters_tuning();
+    size_t min_len = outer ? tuning->fft_min_len_outer : tuning->fft_min_len_inner;
+
+    switch (fastfilters_fir_path()) {
+    case FASTFILTERS_PATH_AUTO:
+        break;
+    case FASTFILTERS_PATH_FFT:
+        min_len = 1;
+        break;
+    default:
+        return false;
+    }
+
+    if (kernel->len < min_len || 4 * kernel->len >= ((size_t)1 << FFT_MAX_LOG2))
+        return false;
+
+    // mirroring reflects once at the border like the direct implementations
+    if ((left_border == FASTFILTERS_BORDER_MIRROR || right_border == FASTFILTERS_BORDER_MIRROR) &&
+        kernel->len >= n_pixels)
+        return false;
+
+    return true;
+}
+
+// block size with the least work for a line of n_pixels pixels. blocks longer than the padded line gain nothing.
+static unsigned fft_block_log2(size_t n_pixels, size_t len)
+{
+    unsigned best = 0;
+    double best_cost = 0.0;
+
+    for (unsigned log2n = 2; log2n <= FFT_MAX_LOG2; ++log2n) {
+        const size_t n_fft = (size_t)1 << log2n;
+
+        if (n_fft <= 4 * len)
+            continue;
+
+        const size_t step = n_fft - 2 * len;
+        const size_t n_blocks = (n_pixels + step - 1) / step;
+        const double cost = (double)n_blocks * (double)n_fft * (double)(log2n + FFT_BLOCK_OVERHEAD);
+
+        if (!best || cost < best_cost) {
+            best = log2n;
+            best_cost = cost;
+        }
+
+        if (n_fft >= n_pixels + 2 * len)
+            break;
+    }
+
+    return best;
+}
+
+// kernel coefficient applied to pixel i + k
+static double kernel_coef(const fastfilters_kernel_fir_t kernel, long k)
+{
+    if (k >= 0)
+        return kernel->coefs[k];
+
+    switch (kernel->symmetry) {
+    case FASTFILTERS_KERNEL_SYMMETRIC:
+        return kernel->coefs[-k];
+    case FASTFILTERS_KERNEL_ANTISYMMETRIC:
+        return -kernel->coefs[-k];
+    default:
+        return kernel->coefs[kernel->len - k];
+    }
+}
+
+static void fft_plan_free(fastfilters_fft_plan_t *plan)
+{
+    if (plan->twiddle_re)
+        fastfilters_memory_align_free(plan->twiddle_re);
+    plan->twiddle_re = NULL;
+}
+
+// the twiddle factors exp(-2 pi i j / (2 h)) of the stages with h butterflies per group are stored at h + j. the
+// kernel is transformed with the same (decimation in frequency) butterflies in double precision so its spectrum ends
+// up in the same bit-reversed order as the transformed blocks. the normalisation of the inverse transform is folded
+// into it.
+static bool fft_plan_init(fastfilters_fft_plan_t *plan, unsigned log2n, const fastfilters_kernel_fir_t kernel)
+{
+    bool result = false;
+    const size_t n = (size_t)1 << log2n;
+    const long len = kernel->len;
+    double *tbl = NULL;
+
+    plan->n_fft = n;
+    plan->twiddle_re = fastfilters_memory_align(32, 4 * n * sizeof(float));
+    if (!plan->twiddle_re)
+        goto out;
+
+    plan->twiddle_im = plan->twiddle_re + n;
+    plan->kernel_re = plan->twiddle_re + 2 * n;
+    plan->kernel_im = plan->twiddle_re + 3 * n;
+
+    // cos and sin of 2 pi m / n, and the kernel being transformed
+    tbl = fastfilters_memory_alloc(4 * n * sizeof(double));
+    if (!tbl)
+        goto out;
+
+    double *cos_tbl = tbl;
+    double *sin_tbl = tbl + n;
+    double *hr = tbl + 2 * n;
+    double *hi = tbl + 3 * n;
+
+    for (size_t m = 0; m < n; ++m) {
+        cos_tbl[m] = cos(2.0 * M_PI * (double)m / (double)n);
+        sin_tbl[m] = sin(2.0 * M_PI * (double)m / (double)n);
+    }
+
+    plan->twiddle_re[0] = 1.0;
+    plan->twiddle_im[0] = 0.0;
+    for (size_t h = 1; h < n; h *= 2)
+        for (size_t j = 0; j < h; ++j) {
+            plan->twiddle_re[h + j] = cos_tbl[j * (n / (2 * h))];
+            plan->twiddle_im[h + j] = -sin_tbl[j * (n / (2 * h))];
+        }
+
+    // out[i] = sum_k coef(k) * in[i + k] is a circular convolution with coef(k) at -k
+    memset(hr, 0, 2 * n * sizeof(double));
+    for (long k = -len; k <= len; ++k)
+        hr[(n - k) % n] = kernel_coef(kernel, k);
+
+    for (size_t h = n / 2; h >= 1; h /= 2)
+        for (size_t start = 0; start < n; start += 2 * h)
+            for (size_t j = 0; j < h; ++j) {
+                const double wr = cos_tbl[j * (n / (2 * h))];
+                const double wi = -sin_tbl[j * (n / (2 * h))];
+                const size_t a = start + j;
+                const size_t b = a + h;
+                const double dr = hr[a] - hr[b];
+                const double di = hi[a] - hi[b];
+
+                hr[a] += hr[b];
+                hi[a] += hi[b];
+                hr[b] = dr * wr - di * wi;
+                hi[b] = dr * wi + di * wr;
+            }
+
+    for (size_t k = 0; k < n; ++k) {
+        plan->kernel_re[k] = hr[k] / (double)n;
+        plan->kernel_im[k] = hi[k] / (double)n;
+    }
+
+    result = true;
+
+out:
+    if (tbl)
+        fastfilters_memory_free(tbl);
+    if (!result)
+        fft_plan_free(plan);
+    return result;
+}
+
+// n_lines lines with n_channels interleaved channels each. pixel x of channel c of line i is at
+// i * line_stride + c + x * pixel_stride of the input, the output or the border pointers.
+typedef struct {
+    const float *inptr;
+    float *outptr;
+    const float *border_left;
+    const float *border_right;
+    size_t n_pixels;
+    size_t n_lines;
+    size_t n_channels;
+    size_t in_line_stride;
+    size_t in_pixel_stride;
+    size_t out_line_stride;
+    size_t out_pixel_stride;
+    size_t border_line_stride;
+    size_t border_pixel_stride;
+    fastfilters_border_treatment_t left_border;
+    fastfilters_border_treatment_t right_border;
+} fft_lines_t;
+
+// pixel x in [-len, n_pixels + len) of the line at in_offset / border_offset, mirrored or taken from the borders
+static inline const float *line_pixel(const fft_lines_t *lines, size_t in_offset, size_t border_offset, size_t len,
+                                      long x)
+{
+    const long n = lines->n_pixels;
+    const long stride = lines->in_pixel_stride;
+    const float *in = lines->inptr + in_offset;
+
+    if (likely(x >= 0 && x < n))
+        return in + x * stride;
+
+    if (x < 0) {
+        if (lines->left_border == FASTFILTERS_BORDER_MIRROR)
+            return in - x * stride;
+        if (lines->left_border == FASTFILTERS_BORDER_PTR)
+            return lines->border_left + border_offset + ((long)len + x) * (long)lines->border_pixel_stride;
+    } else {
+        if (lines->right_border == FASTFILTERS_BORDER_MIRROR)
+            return in + (2 * n - 2 - x) * stride;
+        if (lines->right_border == FASTFILTERS_BORDER_PTR)
+            return lines->border_right + border_offset + (x - n) * (long)lines->border_pixel_stride;
+    }
+
+    return in + x * stride;
+}
+
+// whether the lines are single channel and neighbours in memory, so that one sample of all of them can be copied at
+// once (the outer passes)
+static bool lines_packed(const fft_lines_t *lines)
+{
+    return lines->n_channels == 1 && lines->in_line_stride == 1 && lines->out_line_stride == 1 &&
+           lines->border_line_stride == 1;
+}
+
+// copies the signals first, ..., first + n_signals - 1 padded by len pixels on both sides into the lanes of re and im
+static void fft_gather(const fft_lines_t *lines, size_t first, unsigned n_signals, size_t len, float *re, float *im)
+{
+    const size_t n_padded = lines->n_pixels + 2 * len;
+
+    if (n_signals < FFT_SIGNALS) {
+        memset(re, 0, n_padded * FFT_LANES * sizeof(float));
+        memset(im, 0, n_padded * FFT_LANES * sizeof(float));
+    }
+
+    if (lines_packed(lines)) {
+        const unsigned n_re = n_signals < FFT_LANES ? n_signals : FFT_LANES;
+
+        for (size_t i = 0; i < n_padded; ++i) {
+            const float *src = line_pixel(lines, first, first, len, (long)i - (long)len);
+
+            memcpy(re + i * FFT_LANES, src, n_re * sizeof(float));
+            memcpy(im + i * FFT_LANES, src + n_re, (n_signals - n_re) * sizeof(float));
+        }
+
+        return;
+    }
+
+    for (unsigned k = 0; k < n_signals; ++k) {
+        const size_t line = (first + k) / lines->n_channels;
+        const size_t c = (first + k) % lines->n_channels;
+        const size_t in_offset = line * lines->in_line_stride + c;
+        const size_t border_offset = line * lines->border_line_stride + c;
+        float *lane = (k < FFT_LANES ? re : im) + k % FFT_LANES;
+
+        for (size_t i = 0; i < n_padded; ++i)
+            lane[i * FFT_LANES] = *line_pixel(lines, in_offset, border_offset, len, (long)i - (long)len);
+    }
+}
+
+// writes n samples of the lanes of re and im to pixels x0, ..., x0 + n - 1 of the output lines
+static void fft_scatter(const fft_lines_t *lines, size_t first, unsigned n_signals, const float *re, const float *im,
+                        size_t x0, size_t n)
+{
+    if (lines_packed(lines)) {
+        const unsigned n_re = n_signals < FFT_LANES ? n_signals : FFT_LANES;
+
+        for (size_t i = 0; i < n; ++i) {
+            float *dst = lines->outptr + first + (x0 + i) * lines->out_pixel_stride;
+
+            memcpy(dst, re + i * FFT_LANES, n_re * sizeof(float));
+            memcpy(dst + n_re, im + i * FFT_LANES, (n_signals - n_re) * sizeof(float));
+        }
+
+        return;
+    }
+
+    for (unsigned k = 0; k < n_signals; ++k) {
+        const size_t line = (first + k) / lines->n_channels;
+        const size_t c = (first + k) % lines->n_channels;
+        float *dst = lines->outptr + line * lines->out_line_stride + c + x0 * lines->out_pixel_stride;
+        const float *lane = (k < FFT_LANES ? re : im) + k % FFT_LANES;
+
+        for (size_t i = 0; i < n; ++i)
+            dst[i * lines->out_pixel_stride] = lane[i * FFT_LANES];
+    }
+}
+
+// every group of signals is copied with its borders first, so the lines may be filtered in place
+static bool fft_convolve_lines(const fft_lines_t *lines, const fastfilters_kernel_fir_t kernel)
+{
+    bool result = false;
+    float *buf = NULL;
+    fastfilters_fft_plan_t plan = {0, NULL, NULL, NULL, NULL};
+
+    const size_t len = kernel->len;
+    const size_t n_pixels = lines->n_pixels;
+    const size_t n_padded = n_pixels + 2 * len;
+    const size_t n_signals = lines->n_lines * lines->n_channels;
+    const unsigned log2n = fft_block_log2(n_pixels, len);
+
+    if (!log2n || !fft_plan_init(&plan, log2n, kernel))
+        goto out;
+
+    const size_t n_fft = plan.n_fft;
+    const size_t step = n_fft - 2 * len;
+
+    buf = fastfilters_memory_align(32, 2 * (n_padded + n_fft) * FFT_LANES * sizeof(float));
+    if (!buf)
+        goto out;
+
+    float *padded_re = buf;
+    float *padded_im = padded_re + n_padded * FFT_LANES;
+    float *block_re = padded_im + n_padded * FFT_LANES;
+    float *block_im = block_re + n_fft * FFT_LANES;
+
+    for (size_t first = 0; first < n_signals; first += FFT_SIGNALS) {
+        const unsigned n = n_signals - first < FFT_SIGNALS ? n_signals - first : FFT_SIGNALS;
+
+        fft_gather(lines, first, n, len, padded_re, padded_im);
+
+        for (size_t x0 = 0; x0 < n_pixels; x0 += step) {
+            const size_t n_in = n_padded - x0 < n_fft ? n_padded - x0 : n_fft;
+            const size_t n_out = n_pixels - x0 < step ? n_pixels - x0 : step;
+
+            memcpy(block_re, padded_re + x0 * FFT_LANES, n_in * FFT_LANES * sizeof(float));
+            memcpy(block_im, padded_im + x0 * FFT_LANES, n_in * FFT_LANES * sizeof(float));
+            memset(block_re + n_in * FFT_LANES, 0, (n_fft - n_in) * FFT_LANES * sizeof(float));
+            memset(block_im + n_in * FFT_LANES, 0, (n_fft - n_in) * FFT_LANES * sizeof(float));
+
+            fastfilters_fir_fft_block(&plan, block_re, block_im);
+
+            // output pixel x0 + i is sample len + i of the block
+            fft_scatter(lines, first, n, block_re + len * FFT_LANES, block_im + len * FFT_LANES, x0, n_out);
+        }
+    }
+
+    result = true;
+
+out:
+    if (buf)
+        fastfilters_memory_align_free(buf);
+    fft_plan_free(&plan);
+    return result;
+}
+
+// same arguments as fastfilters_fir_convolve_fir_inner: n_outer lines of n_pixels pixels with pixel_stride channels
+bool DLL_LOCAL fastfilters_fir_convolve_fft_inner(const float *inptr, size_t n_pixels, size_t pixel_stride,
+                                                  size_t n_outer, size_t outer_stride, float *outptr,
+                                                  size_t outptr_stride, fastfilters_kernel_fir_t kernel,
+                                                  fastfilters_border_treatment_t left_border,
+                                                  fastfilters_border_treatment_t right_border,
+                                                  const float *borderptr_left, const float *borderptr_right,
+                                                  size_t border_outer_stride)
+{
+    const fft_lines_t lines = {.inptr = inptr,
+                               .outptr = outptr,
+                               .border_left = borderptr_left,
+                               .border_right = borderptr_right,
+                               .n_pixels = n_pixels,
+                               .n_lines = n_outer,
+                               .n_channels = pixel_stride,
+                               .in_line_stride = outer_stride,
+                               .in_pixel_stride = pixel_stride,
+                               .out_line_stride = outptr_stride,
+                               .out_pixel_stride = pixel_stride,
+                               .border_line_stride = border_outer_stride,
+                               .border_pixel_stride = pixel_stride,
+                               .left_border = left_border,
+                               .right_border = right_border};
+
+    return fft_convolve_lines(&lines, kernel);
+}
+
+// same arguments as fastfilters_fir_convolve_fir_outer: n_outer neighbouring lines with pixels pixel_stride apart
+bool DLL_LOCAL fastfilters_fir_convolve_fft_outer(const float *inptr, size_t n_pixels, size_t pixel_stride,
+                                                  size_t n_outer, size_t outer_stride, float *outptr,
+                                                  size_t outptr_stride, fastfilters_kernel_fir_t kernel,
+                                                  fastfilters_border_treatment_t left_border,
+                                                  fastfilters_border_treatment_t right_border,
+                                                  const float *borderptr_left, const float *borderptr_right,
+                                                  size_t border_outer_stride)
+{
+    const fft_lines_t lines = {.inptr = inptr,
+                               .outptr = outptr,
+                               .border_left = borderptr_left,
+                               .border_right = borderptr_right,
+                               .n_pixels = n_pixels,
+                               .n_lines = n_outer,
+                               .n_channels = 1,
+                               .in_line_stride = outer_stride,
+                               .in_pixel_stride = pixel_stride,
+                               .out_line_stride = outer_stride,
+                               .out_pixel_stride = outptr_stride,
+                               .border_line_stride = 1,
+                               .border_pixel_stride = border_outer_stride,
+                               .left_border = left_border,
+                               .right_border = right_border};
+
+    return fft_convolve_lines(&lines, kernel);
+}
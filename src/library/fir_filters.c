@@ -23,111 +23,274 @@
 #include "fastfilters.h"
 #include "common.h"
 
-bool DLL_PUBLIC fastfilters_fir_gaussian2d(const fastfilters_array2d_t *inarray, unsigned order, double sigma,
-                                           fastfilters_array2d_t *outarray, const fastfilters_options_t *options)
+static fastfilters_kernel_fir_t kernel_axis(unsigned order, const double *sigma, unsigned axis,
+                                            const fastfilters_options_t *options)
+{
+    const double voxel_size = opt_voxel_size(options, axis);
+    fastfilters_kernel_fir_t kernel;
+
+    kernel = fastfilters_kernel_fir_gaussian_opt(order, sigma[axis] / voxel_size, options);
+
+    // derivatives are taken with respect to physical coordinates
+    if (kernel && order > 0 && voxel_size != 1.0)
+        fastfilters_kernel_fir_scale(kernel, pow(voxel_size, -(double)order));
+
+    return kernel;
+}
+
+// bytes read and written by a filter on n_arrays arrays of the input's shape, for the trace
+static uint64_t filter_bytes2d(const fastfilters_array2d_t *a, size_t n_arrays)
+{
+    return (uint64_t)a->n_x * a->n_y * a->n_channels * n_arrays * sizeof(float);
+}
+
+static uint64_t filter_bytes3d(const fastfilters_array3d_t *a, size_t n_arrays)
+{
+    return (uint64_t)a->n_x * a->n_y * a->n_z * a->n_channels * n_arrays * sizeof(float);
+}
+
+static bool kernels_alloc(unsigned order, const double *sigma, unsigned n_axes, const fastfilters_options_t *options,
+                          fastfilters_kernel_fir_t *kernels)
+{
+    for (unsigned i = 0; i < n_axes; ++i) {
+        kernels[i] = kernel_axis(order, sigma, i, options);
+        if (!kernels[i])
+            return false;
+    }
+
+    return true;
+}
+
+static void kernels_free(fastfilters_kernel_fir_t *kernels, unsigned n_axes)
+{
+    for (unsigned i = 0; i < n_axes; ++i)
+        if (kernels[i])
+            fastfilters_kernel_fir_free(kernels[i]);
+}
+
+bool DLL_PUBLIC fastfilters_fir_derivative2d(const fastfilters_array2d_t *inarray, const unsigned *order,
+                                             const double *sigma, fastfilters_array2d_t *outarray,
+                                             const fastfilters_options_t *options)
 {
     bool result = false;
-    fastfilters_kernel_fir_t kx = NULL;
+    fastfilters_kernel_fir_t k[2] = {NULL, NULL};
+
+    fastfilters_trace_begin("filter", "derivative2d", filter_bytes2d(inarray, 2));
 
-    kx = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
-    if (!kx)
+    if (opt_decimation(options) > 1) {
+        const fastfilters_array3d_t in = array2d_as_3d(inarray);
+        const fastfilters_array3d_t out = array2d_as_3d(outarray);
+        result = fastfilters_fir_derivative_decimated(&in, 2, order, sigma, &out, options);
         goto out;
+    }
 
-    result = fastfilters_fir_convolve2d(inarray, kx, kx, outarray, options);
+    for (unsigned i = 0; i < 2; ++i) {
+        k[i] = kernel_axis(order[i], sigma, i, options);
+        if (!k[i])
+            goto out;
+    }
+
+    result = fastfilters_fir_convolve2d(inarray, k[0], k[1], outarray, options);
 
 out:
-    if (kx)
-        fastfilters_kernel_fir_free(kx);
+    kernels_free(k, 2);
+    fastfilters_trace_end("filter", "derivative2d");
     return result;
 }
 
-bool DLL_PUBLIC fastfilters_fir_hog2d(const fastfilters_array2d_t *inarray, double sigma, fastfilters_array2d_t *out_xx,
-                                      fastfilters_array2d_t *out_xy, fastfilters_array2d_t *out_yy,
-                                      const fastfilters_options_t *options)
+bool DLL_PUBLIC fastfilters_fir_gaussian2d_aniso(const fastfilters_array2d_t *inarray, unsigned order,
+                                                 const double *sigma, fastfilters_array2d_t *outarray,
+                                                 const fastfilters_options_t *options)
+{
+    const unsigned orders[2] = {order, order};
+    return fastfilters_fir_derivative2d(inarray, orders, sigma, outarray, options);
+}
+
+bool DLL_PUBLIC fastfilters_fir_gaussian2d(const fastfilters_array2d_t *inarray, unsigned order, double sigma,
+                                           fastfilters_array2d_t *outarray, const fastfilters_options_t *options)
+{
+    const double sigmas[2] = {sigma, sigma};
+    return fastfilters_fir_gaussian2d_aniso(inarray, order, sigmas, outarray, options);
+}
+
+// kernels for scale i of a multi-scale series. with FASTFILTERS_PRECISION_FAST, scale i is smoothed further from
+// scale i - 1 by sqrt(s_i^2 - s_(i-1)^2) wherever the scales increase, which needs much shorter kernels than
+// filtering the input again. the discrete kernels do not compose exactly, so this is an approximation.
+static bool multiscale_kernels(const double *sigmas, size_t i, unsigned n_axes, fastfilters_precision_t precision,
+                               const fastfilters_options_t *options, fastfilters_kernel_fir_t *kernels, bool *cascade)
+{
+    double sigma[3];
+
+    *cascade = false;
+    if (precision == FASTFILTERS_PRECISION_FAST && i > 0 && sigmas[i] > sigmas[i - 1]) {
+        const double sigma_d = sqrt(sigmas[i] * sigmas[i] - sigmas[i - 1] * sigmas[i - 1]);
+
+        for (unsigned a = 0; a < n_axes; ++a)
+            sigma[a] = sigma_d;
+        if (!kernels_alloc(0, sigma, n_axes, options, kernels))
+            return false;
+
+        // an empty kernel cannot be applied out-of-place, start over from the input instead
+        *cascade = true;
+        for (unsigned a = 0; a < n_axes; ++a)
+            *cascade = *cascade && kernels[a]->len > 0;
+        if (*cascade)
+            return true;
+
+        kernels_free(kernels, n_axes);
+        for (unsigned a = 0; a < n_axes; ++a)
+            kernels[a] = NULL;
+    }
+
+    for (unsigned a = 0; a < n_axes; ++a)
+        sigma[a] = sigmas[i];
+    return kernels_alloc(0, sigma, n_axes, options, kernels);
+}
+
+bool DLL_PUBLIC fastfilters_fir_gaussian2d_multiscale(const fastfilters_array2d_t *inarray, const double *sigmas,
+                                                      size_t n_scales, fastfilters_precision_t precision,
+                                                      fastfilters_array2d_t *const *outarrays,
+                                                      const fastfilters_options_t *options)
+{
+    bool result = true;
+
+    fastfilters_trace_begin("filter", "gaussian2d_multiscale", filter_bytes2d(inarray, 1 + n_scales));
+
+    for (size_t i = 0; result && i < n_scales; ++i) {
+        fastfilters_kernel_fir_t k[2] = {NULL, NULL};
+        bool cascade;
+        result = multiscale_kernels(sigmas, i, 2, precision, options, k, &cascade) &&
+                 fastfilters_fir_convolve2d(cascade ? outarrays[i - 1] : inarray, k[0], k[1], outarrays[i], options);
+
+        kernels_free(k, 2);
+    }
+
+    fastfilters_trace_end("filter", "gaussian2d_multiscale");
+    return result;
+}
+
+bool DLL_PUBLIC fastfilters_fir_hog2d_aniso(const fastfilters_array2d_t *inarray, const double *sigma,
+                                            fastfilters_array2d_t *out_xx, fastfilters_array2d_t *out_xy,
+                                            fastfilters_array2d_t *out_yy, const fastfilters_options_t *options)
 {
     bool result = false;
-    fastfilters_kernel_fir_t k_smooth = NULL;
-    fastfilters_kernel_fir_t k_first = NULL;
-    fastfilters_kernel_fir_t k_second = NULL;
+    fastfilters_kernel_fir_t k_smooth[2] = {NULL, NULL};
+    fastfilters_kernel_fir_t k_first[2] = {NULL, NULL};
+    fastfilters_kernel_fir_t k_second[2] = {NULL, NULL};
 
-    k_smooth = fastfilters_kernel_fir_gaussian(0, sigma, opt_window_ratio(options));
-    if (!k_smooth)
-        goto out;
+    fastfilters_trace_begin("filter", "hog2d", filter_bytes2d(inarray, 4));
 
-    k_first = fastfilters_kernel_fir_gaussian(1, sigma, opt_window_ratio(options));
-    if (!k_first)
+    if (!kernels_alloc(0, sigma, 2, options, k_smooth))
         goto out;
 
-    k_second = fastfilters_kernel_fir_gaussian(2, sigma, opt_window_ratio(options));
-    if (!k_second)
+    if (!kernels_alloc(1, sigma, 2, options, k_first))
         goto out;
 
-    result = fastfilters_fir_convolve2d(inarray, k_second, k_smooth, out_xx, options);
-    if (!result)
+    if (!kernels_alloc(2, sigma, 2, options, k_second))
         goto out;
 
-    result = fastfilters_fir_convolve2d(inarray, k_smooth, k_second, out_yy, options);
-    if (!result)
-        goto out;
+    const fastfilters_kernel_fir_t kernels[3][3] = {
+        {k_second[0], k_smooth[1], NULL}, {k_first[0], k_first[1], NULL}, {k_smooth[0], k_second[1], NULL}};
+    const fastfilters_array3d_t in = array2d_as_3d(inarray);
+    const fastfilters_array3d_t xx = array2d_as_3d(out_xx);
+    const fastfilters_array3d_t xy = array2d_as_3d(out_xy);
+    const fastfilters_array3d_t yy = array2d_as_3d(out_yy);
+    const fastfilters_array3d_t *outs[3] = {&xx, &xy, &yy};
 
-    result = fastfilters_fir_convolve2d(inarray, k_first, k_first, out_xy, options);
-    if (!result)
-        goto out;
+    result = fastfilters_fir_convolve3d_multi(&in, kernels, 3, outs);
 
 out:
-    if (k_smooth)
-        fastfilters_kernel_fir_free(k_smooth);
-    if (k_first)
-        fastfilters_kernel_fir_free(k_first);
-    if (k_second)
-        fastfilters_kernel_fir_free(k_second);
+    kernels_free(k_smooth, 2);
+    kernels_free(k_first, 2);
+    kernels_free(k_second, 2);
+    fastfilters_trace_end("filter", "hog2d");
     return result;
 }
 
-static bool fastfilters_fir_deriv2d_inner(const fastfilters_array2d_t *inarray, double sigma, unsigned order,
+bool DLL_PUBLIC fastfilters_fir_hog2d(const fastfilters_array2d_t *inarray, double sigma, fastfilters_array2d_t *out_xx,
+                                      fastfilters_array2d_t *out_xy, fastfilters_array2d_t *out_yy,
+                                      const fastfilters_options_t *options)
+{
+    const double sigmas[2] = {sigma, sigma};
+    return fastfilters_fir_hog2d_aniso(inarray, sigmas, out_xx, out_xy, out_yy, options);
+}
+
+static bool fastfilters_fir_deriv2d_inner(const fastfilters_array2d_t *inarray, const double *sigma, unsigned order,
                                           fastfilters_array2d_t *out0, fastfilters_array2d_t *out1,
                                           const fastfilters_options_t *options)
 {
     bool result = false;
-    fastfilters_kernel_fir_t k_smooth = NULL;
-    fastfilters_kernel_fir_t k_deriv = NULL;
+    fastfilters_kernel_fir_t k_smooth[2] = {NULL, NULL};
+    fastfilters_kernel_fir_t k_deriv[2] = {NULL, NULL};
 
-    k_smooth = fastfilters_kernel_fir_gaussian(0, sigma, opt_window_ratio(options));
-    if (!k_smooth)
+    if (!kernels_alloc(0, sigma, 2, options, k_smooth))
         goto out;
 
-    k_deriv = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
-    if (!k_deriv)
+    if (!kernels_alloc(order, sigma, 2, options, k_deriv))
         goto out;
 
-    result = fastfilters_fir_convolve2d(inarray, k_deriv, k_smooth, out0, options);
+    result = fastfilters_fir_convolve2d(inarray, k_deriv[0], k_smooth[1], out0, options);
     if (!result)
         goto out;
 
-    result = fastfilters_fir_convolve2d(inarray, k_smooth, k_deriv, out1, options);
+    result = fastfilters_fir_convolve2d(inarray, k_smooth[0], k_deriv[1], out1, options);
     if (!result)
         goto out;
 
 out:
-    if (k_smooth)
-        fastfilters_kernel_fir_free(k_smooth);
-    if (k_deriv)
-        fastfilters_kernel_fir_free(k_deriv);
+    kernels_free(k_smooth, 2);
+    kernels_free(k_deriv, 2);
     return result;
 }
 
-static bool fastfilters_fir_deriv2d(const fastfilters_array2d_t *inarray, double sigma, unsigned order,
+// the fused reduction feeds the inner pass straight from the input, which needs packed pixels
+static bool reduce_fusable(const fastfilters_array3d_t *in, const fastfilters_kernel_fir_t *k_smooth,
+                           const fastfilters_kernel_fir_t *k_deriv, unsigned n_axes)
+{
+    if (in->stride_x != in->n_channels)
+        return false;
+
+    for (unsigned i = 0; i < n_axes; ++i)
+        if (k_smooth[i]->len == 0 || k_deriv[i]->len == 0)
+            return false;
+
+    return true;
+}
+
+static bool fastfilters_fir_deriv2d(const fastfilters_array2d_t *inarray, const double *sigma, unsigned order,
                                     fastfilters_array2d_t *outarray, bool do_sqrt, const fastfilters_options_t *options)
 {
     bool result = false;
     fastfilters_array2d_t *tmparray = NULL;
+    fastfilters_kernel_fir_t k_smooth[2] = {NULL, NULL};
+    fastfilters_kernel_fir_t k_deriv[2] = {NULL, NULL};
+    const fastfilters_array3d_t in = array2d_as_3d(inarray);
+    const fastfilters_array3d_t out = array2d_as_3d(outarray);
+    const char *name = order == 1 ? "gradmag2d" : "laplacian2d";
+
+    fastfilters_trace_begin("filter", name, filter_bytes2d(inarray, 2));
+
+    if (!kernels_alloc(0, sigma, 2, options, k_smooth))
+        goto out;
+
+    if (!kernels_alloc(order, sigma, 2, options, k_deriv))
+        goto out;
+
+    if (reduce_fusable(&in, k_smooth, k_deriv, 2)) {
+        const fastfilters_kernel_fir_t kernels[2][3] = {{k_deriv[0], k_smooth[1], NULL},
+                                                        {k_smooth[0], k_deriv[1], NULL}};
+        result = fastfilters_fir_convolve3d_reduce(&in, kernels, do_sqrt, &out);
+        goto out;
+    }
 
     tmparray = fastfilters_array2d_alloc(inarray->n_x, inarray->n_y, inarray->n_channels);
     if (!tmparray)
         goto out;
 
-    result = fastfilters_fir_deriv2d_inner(inarray, sigma, order, tmparray, outarray, options);
-    if (!result)
+    if (!fastfilters_fir_convolve2d(inarray, k_smooth[0], k_deriv[1], tmparray, options))
+        goto out;
+
+    if (!fastfilters_fir_convolve2d(inarray, k_deriv[0], k_smooth[1], outarray, options))
         goto out;
 
     if (do_sqrt)
@@ -135,41 +298,58 @@ static bool fastfilters_fir_deriv2d(const fastfilters_array2d_t *inarray, double
     else
         fastfilters_combine_add2d(outarray, tmparray, outarray);
 
+    result = true;
+
 out:
+    kernels_free(k_smooth, 2);
+    kernels_free(k_deriv, 2);
     if (tmparray)
         fastfilters_array2d_free(tmparray);
+    fastfilters_trace_end("filter", name);
     return result;
 }
 
+bool DLL_PUBLIC fastfilters_fir_gradmag2d_aniso(const fastfilters_array2d_t *inarray, const double *sigma,
+                                                fastfilters_array2d_t *outarray, const fastfilters_options_t *options)
+{
+    return fastfilters_fir_deriv2d(inarray, sigma, 1, outarray, true, options);
+}
+
 bool DLL_PUBLIC fastfilters_fir_gradmag2d(const fastfilters_array2d_t *inarray, double sigma,
                                           fastfilters_array2d_t *outarray, const fastfilters_options_t *options)
 {
-    return fastfilters_fir_deriv2d(inarray, sigma, 1, outarray, true, options);
+    const double sigmas[2] = {sigma, sigma};
+    return fastfilters_fir_deriv2d(inarray, sigmas, 1, outarray, true, options);
+}
+
+bool DLL_PUBLIC fastfilters_fir_laplacian2d_aniso(const fastfilters_array2d_t *inarray, const double *sigma,
+                                                  fastfilters_array2d_t *outarray,
+                                                  const fastfilters_options_t *options)
+{
+    return fastfilters_fir_deriv2d(inarray, sigma, 2, outarray, false, options);
 }
 
 bool DLL_PUBLIC fastfilters_fir_laplacian2d(const fastfilters_array2d_t *inarray, double sigma,
                                             fastfilters_array2d_t *outarray, const fastfilters_options_t *options)
 {
-    return fastfilters_fir_deriv2d(inarray, sigma, 2, outarray, false, options);
+    const double sigmas[2] = {sigma, sigma};
+    return fastfilters_fir_deriv2d(inarray, sigmas, 2, outarray, false, options);
 }
 
-bool DLL_PUBLIC fastfilters_fir_structure_tensor2d(const fastfilters_array2d_t *inarray, double sigma_outer,
-                                                   double sigma_inner, fastfilters_array2d_t *out_xx,
-                                                   fastfilters_array2d_t *out_xy, fastfilters_array2d_t *out_yy,
-                                                   const fastfilters_options_t *options)
+bool DLL_PUBLIC fastfilters_fir_structure_tensor2d_aniso(const fastfilters_array2d_t *inarray,
+                                                         const double *sigma_outer, const double *sigma_inner,
+                                                         fastfilters_array2d_t *out_xx, fastfilters_array2d_t *out_xy,
+                                                         fastfilters_array2d_t *out_yy,
+                                                         const fastfilters_options_t *options)
 {
     bool result = false;
-    fastfilters_kernel_fir_t k_smooth = NULL;
-    fastfilters_array2d_t *tmp = NULL;
+    fastfilters_kernel_fir_t k_smooth[2] = {NULL, NULL};
     fastfilters_array2d_t *tmpx = NULL;
     fastfilters_array2d_t *tmpy = NULL;
 
-    k_smooth = fastfilters_kernel_fir_gaussian(0, sigma_outer, opt_window_ratio(options));
-    if (!k_smooth)
-        goto out;
+    fastfilters_trace_begin("filter", "structure_tensor2d", filter_bytes2d(inarray, 4));
 
-    tmp = fastfilters_array2d_alloc(inarray->n_x, inarray->n_y, inarray->n_channels);
-    if (!tmp)
+    if (!kernels_alloc(0, sigma_outer, 2, options, k_smooth))
         goto out;
 
     tmpx = fastfilters_array2d_alloc(inarray->n_x, inarray->n_y, inarray->n_channels);
@@ -184,149 +364,205 @@ bool DLL_PUBLIC fastfilters_fir_structure_tensor2d(const fastfilters_array2d_t *
     if (!result)
         goto out;
 
-    fastfilters_combine_mul2d(tmpx, tmpx, tmp);
-    result = fastfilters_fir_convolve2d(tmp, k_smooth, k_smooth, out_xx, options);
-    if (!result)
-        goto out;
-
-    fastfilters_combine_mul2d(tmpy, tmpy, tmp);
-    result = fastfilters_fir_convolve2d(tmp, k_smooth, k_smooth, out_yy, options);
-    if (!result)
-        goto out;
+    const fastfilters_array3d_t grad[2] = {array2d_as_3d(tmpx), array2d_as_3d(tmpy)};
+    const fastfilters_array3d_t tensor[3] = {array2d_as_3d(out_xx), array2d_as_3d(out_xy), array2d_as_3d(out_yy)};
+    const fastfilters_array3d_t *in[2] = {&grad[0], &grad[1]};
+    const fastfilters_array3d_t *outs[3] = {&tensor[0], &tensor[1], &tensor[2]};
+    const unsigned pairs[3][2] = {{0, 0}, {0, 1}, {1, 1}};
 
-    fastfilters_combine_mul2d(tmpx, tmpy, tmp);
-    result = fastfilters_fir_convolve2d(tmp, k_smooth, k_smooth, out_xy, options);
-    if (!result)
-        goto out;
+    result = fastfilters_fir_convolve3d_products(in, pairs, 3, k_smooth[0], k_smooth[1], NULL, outs);
 
 out:
-    if (k_smooth)
-        fastfilters_kernel_fir_free(k_smooth);
-    if (tmp)
-        fastfilters_array2d_free(tmp);
+    kernels_free(k_smooth, 2);
     if (tmpx)
         fastfilters_array2d_free(tmpx);
     if (tmpy)
         fastfilters_array2d_free(tmpy);
+    fastfilters_trace_end("filter", "structure_tensor2d");
     return result;
 }
 
-DLL_PUBLIC bool fastfilters_fir_hog3d(const fastfilters_array3d_t *inarray, double sigma, fastfilters_array3d_t *out_xx,
-                                      fastfilters_array3d_t *out_yy, fastfilters_array3d_t *out_zz,
-                                      fastfilters_array3d_t *out_xy, fastfilters_array3d_t *out_xz,
-                                      fastfilters_array3d_t *out_yz, const fastfilters_options_t *options)
+bool DLL_PUBLIC fastfilters_fir_structure_tensor2d(const fastfilters_array2d_t *inarray, double sigma_outer,
+                                                   double sigma_inner, fastfilters_array2d_t *out_xx,
+                                                   fastfilters_array2d_t *out_xy, fastfilters_array2d_t *out_yy,
+                                                   const fastfilters_options_t *options)
+{
+    const double sigmas_outer[2] = {sigma_outer, sigma_outer};
+    const double sigmas_inner[2] = {sigma_inner, sigma_inner};
+    return fastfilters_fir_structure_tensor2d_aniso(inarray, sigmas_outer, sigmas_inner, out_xx, out_xy, out_yy,
+                                                    options);
+}
+
+DLL_PUBLIC bool fastfilters_fir_hog3d_aniso(const fastfilters_array3d_t *inarray, const double *sigma,
+                                            fastfilters_array3d_t *out_xx, fastfilters_array3d_t *out_yy,
+                                            fastfilters_array3d_t *out_zz, fastfilters_array3d_t *out_xy,
+                                            fastfilters_array3d_t *out_xz, fastfilters_array3d_t *out_yz,
+                                            const fastfilters_options_t *options)
 {
     bool result = false;
-    fastfilters_kernel_fir_t k_smooth = NULL;
-    fastfilters_kernel_fir_t k_first = NULL;
-    fastfilters_kernel_fir_t k_second = NULL;
+    fastfilters_kernel_fir_t k_smooth[3] = {NULL, NULL, NULL};
+    fastfilters_kernel_fir_t k_first[3] = {NULL, NULL, NULL};
+    fastfilters_kernel_fir_t k_second[3] = {NULL, NULL, NULL};
 
-    k_smooth = fastfilters_kernel_fir_gaussian(0, sigma, opt_window_ratio(options));
-    if (!k_smooth)
-        goto out;
+    fastfilters_trace_begin("filter", "hog3d", filter_bytes3d(inarray, 7));
 
-    k_first = fastfilters_kernel_fir_gaussian(1, sigma, opt_window_ratio(options));
-    if (!k_first)
+    if (!kernels_alloc(0, sigma, 3, options, k_smooth))
         goto out;
 
-    k_second = fastfilters_kernel_fir_gaussian(2, sigma, opt_window_ratio(options));
-    if (!k_second)
+    if (!kernels_alloc(1, sigma, 3, options, k_first))
         goto out;
 
-    result = fastfilters_fir_convolve3d(inarray, k_second, k_smooth, k_smooth, out_xx, options);
-    if (!result)
+    if (!kernels_alloc(2, sigma, 3, options, k_second))
         goto out;
 
-    result = fastfilters_fir_convolve3d(inarray, k_smooth, k_second, k_smooth, out_yy, options);
-    if (!result)
-        goto out;
+    const fastfilters_kernel_fir_t kernels[6][3] = {
+        {k_second[0], k_smooth[1], k_smooth[2]}, {k_smooth[0], k_second[1], k_smooth[2]},
+        {k_smooth[0], k_smooth[1], k_second[2]}, {k_first[0], k_first[1], k_smooth[2]},
+        {k_first[0], k_smooth[1], k_first[2]},   {k_smooth[0], k_first[1], k_first[2]}};
+    const fastfilters_array3d_t *outs[6] = {out_xx, out_yy, out_zz, out_xy, out_xz, out_yz};
 
-    result = fastfilters_fir_convolve3d(inarray, k_smooth, k_smooth, k_second, out_zz, options);
-    if (!result)
-        goto out;
+    result = fastfilters_fir_convolve3d_multi(inarray, kernels, 6, outs);
 
-    result = fastfilters_fir_convolve3d(inarray, k_first, k_first, k_smooth, out_xy, options);
-    if (!result)
-        goto out;
+out:
+    kernels_free(k_smooth, 3);
+    kernels_free(k_first, 3);
+    kernels_free(k_second, 3);
+    fastfilters_trace_end("filter", "hog3d");
+    return result;
+}
 
-    result = fastfilters_fir_convolve3d(inarray, k_first, k_smooth, k_first, out_xz, options);
-    if (!result)
-        goto out;
+DLL_PUBLIC bool fastfilters_fir_hog3d(const fastfilters_array3d_t *inarray, double sigma, fastfilters_array3d_t *out_xx,
+                                      fastfilters_array3d_t *out_yy, fastfilters_array3d_t *out_zz,
+                                      fastfilters_array3d_t *out_xy, fastfilters_array3d_t *out_xz,
+                                      fastfilters_array3d_t *out_yz, const fastfilters_options_t *options)
+{
+    const double sigmas[3] = {sigma, sigma, sigma};
+    return fastfilters_fir_hog3d_aniso(inarray, sigmas, out_xx, out_yy, out_zz, out_xy, out_xz, out_yz, options);
+}
 
-    result = fastfilters_fir_convolve3d(inarray, k_smooth, k_first, k_first, out_yz, options);
-    if (!result)
+bool DLL_PUBLIC fastfilters_fir_derivative3d(const fastfilters_array3d_t *inarray, const unsigned *order,
+                                             const double *sigma, fastfilters_array3d_t *outarray,
+                                             const fastfilters_options_t *options)
+{
+    bool result = false;
+    fastfilters_kernel_fir_t k[3] = {NULL, NULL, NULL};
+
+    fastfilters_trace_begin("filter", "derivative3d", filter_bytes3d(inarray, 2));
+
+    if (opt_decimation(options) > 1) {
+        result = fastfilters_fir_derivative_decimated(inarray, 3, order, sigma, outarray, options);
         goto out;
+    }
+
+    for (unsigned i = 0; i < 3; ++i) {
+        k[i] = kernel_axis(order[i], sigma, i, options);
+        if (!k[i])
+            goto out;
+    }
+
+    result = fastfilters_fir_convolve3d(inarray, k[0], k[1], k[2], outarray, options);
 
 out:
-    if (k_smooth)
-        fastfilters_kernel_fir_free(k_smooth);
-    if (k_first)
-        fastfilters_kernel_fir_free(k_first);
-    if (k_second)
-        fastfilters_kernel_fir_free(k_second);
+    kernels_free(k, 3);
+    fastfilters_trace_end("filter", "derivative3d");
     return result;
 }
 
+bool DLL_PUBLIC fastfilters_fir_gaussian3d_aniso(const fastfilters_array3d_t *inarray, unsigned order,
+                                                 const double *sigma, fastfilters_array3d_t *outarray,
+                                                 const fastfilters_options_t *options)
+{
+    const unsigned orders[3] = {order, order, order};
+    return fastfilters_fir_derivative3d(inarray, orders, sigma, outarray, options);
+}
+
 bool DLL_PUBLIC fastfilters_fir_gaussian3d(const fastfilters_array3d_t *inarray, unsigned order, double sigma,
                                            fastfilters_array3d_t *outarray, const fastfilters_options_t *options)
 {
-    bool result = false;
-    fastfilters_kernel_fir_t kx = NULL;
+    const double sigmas[3] = {sigma, sigma, sigma};
+    return fastfilters_fir_gaussian3d_aniso(inarray, order, sigmas, outarray, options);
+}
 
-    kx = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
-    if (!kx)
-        goto out;
+bool DLL_PUBLIC fastfilters_fir_gaussian3d_multiscale(const fastfilters_array3d_t *inarray, const double *sigmas,
+                                                      size_t n_scales, fastfilters_precision_t precision,
+                                                      fastfilters_array3d_t *const *outarrays,
+                                                      const fastfilters_options_t *options)
+{
+    bool result = true;
 
-    result = fastfilters_fir_convolve3d(inarray, kx, kx, kx, outarray, options);
+    fastfilters_trace_begin("filter", "gaussian3d_multiscale", filter_bytes3d(inarray, 1 + n_scales));
 
-out:
-    if (kx)
-        fastfilters_kernel_fir_free(kx);
+    for (size_t i = 0; result && i < n_scales; ++i) {
+        fastfilters_kernel_fir_t k[3] = {NULL, NULL, NULL};
+        bool cascade;
+        result = multiscale_kernels(sigmas, i, 3, precision, options, k, &cascade) &&
+                 fastfilters_fir_convolve3d(cascade ? outarrays[i - 1] : inarray, k[0], k[1], k[2], outarrays[i],
+                                            options);
+
+        kernels_free(k, 3);
+    }
+
+    fastfilters_trace_end("filter", "gaussian3d_multiscale");
     return result;
 }
 
-static bool fastfilters_fir_deriv3d_inner(const fastfilters_array3d_t *inarray, double sigma, unsigned order,
+static bool fastfilters_fir_deriv3d_inner(const fastfilters_array3d_t *inarray, const double *sigma, unsigned order,
                                           fastfilters_array3d_t *out0, fastfilters_array3d_t *out1,
                                           fastfilters_array3d_t *out2, const fastfilters_options_t *options)
 {
     bool result = false;
-    fastfilters_kernel_fir_t k_smooth = NULL;
-    fastfilters_kernel_fir_t k_deriv = NULL;
+    fastfilters_kernel_fir_t k_smooth[3] = {NULL, NULL, NULL};
+    fastfilters_kernel_fir_t k_deriv[3] = {NULL, NULL, NULL};
 
-    k_smooth = fastfilters_kernel_fir_gaussian(0, sigma, opt_window_ratio(options));
-    if (!k_smooth)
+    if (!kernels_alloc(0, sigma, 3, options, k_smooth))
         goto out;
 
-    k_deriv = fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
-    if (!k_deriv)
+    if (!kernels_alloc(order, sigma, 3, options, k_deriv))
         goto out;
 
-    result = fastfilters_fir_convolve3d(inarray, k_deriv, k_smooth, k_smooth, out0, options);
+    result = fastfilters_fir_convolve3d(inarray, k_deriv[0], k_smooth[1], k_smooth[2], out0, options);
     if (!result)
         goto out;
 
-    result = fastfilters_fir_convolve3d(inarray, k_smooth, k_deriv, k_smooth, out1, options);
+    result = fastfilters_fir_convolve3d(inarray, k_smooth[0], k_deriv[1], k_smooth[2], out1, options);
     if (!result)
         goto out;
 
-    result = fastfilters_fir_convolve3d(inarray, k_smooth, k_smooth, k_deriv, out2, options);
+    result = fastfilters_fir_convolve3d(inarray, k_smooth[0], k_smooth[1], k_deriv[2], out2, options);
     if (!result)
         goto out;
 
 out:
-    if (k_smooth)
-        fastfilters_kernel_fir_free(k_smooth);
-    if (k_deriv)
-        fastfilters_kernel_fir_free(k_deriv);
+    kernels_free(k_smooth, 3);
+    kernels_free(k_deriv, 3);
     return result;
 }
 
-static bool fastfilters_fir_deriv3d(const fastfilters_array3d_t *inarray, double sigma, unsigned order,
+static bool fastfilters_fir_deriv3d(const fastfilters_array3d_t *inarray, const double *sigma, unsigned order,
                                     fastfilters_array3d_t *outarray, bool do_sqrt, const fastfilters_options_t *options)
 {
     bool result = false;
     fastfilters_array3d_t *tmparray0 = NULL;
     fastfilters_array3d_t *tmparray1 = NULL;
+    fastfilters_kernel_fir_t k_smooth[3] = {NULL, NULL, NULL};
+    fastfilters_kernel_fir_t k_deriv[3] = {NULL, NULL, NULL};
+    const char *name = order == 1 ? "gradmag3d" : "laplacian3d";
+
+    fastfilters_trace_begin("filter", name, filter_bytes3d(inarray, 2));
+
+    if (!kernels_alloc(0, sigma, 3, options, k_smooth))
+        goto out;
+
+    if (!kernels_alloc(order, sigma, 3, options, k_deriv))
+        goto out;
+
+    if (reduce_fusable(inarray, k_smooth, k_deriv, 3)) {
+        const fastfilters_kernel_fir_t kernels[3][3] = {{k_deriv[0], k_smooth[1], k_smooth[2]},
+                                                        {k_smooth[0], k_deriv[1], k_smooth[2]},
+                                                        {k_smooth[0], k_smooth[1], k_deriv[2]}};
+        result = fastfilters_fir_convolve3d_reduce(inarray, kernels, do_sqrt, outarray);
+        goto out;
+    }
 
     tmparray0 = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
     if (!tmparray0)
@@ -336,8 +572,13 @@ static bool fastfilters_fir_deriv3d(const fastfilters_array3d_t *inarray, double
     if (!tmparray1)
         goto out;
 
-    result = fastfilters_fir_deriv3d_inner(inarray, sigma, order, outarray, tmparray0, tmparray1, options);
-    if (!result)
+    if (!fastfilters_fir_convolve3d(inarray, k_smooth[0], k_deriv[1], k_smooth[2], tmparray0, options))
+        goto out;
+
+    if (!fastfilters_fir_convolve3d(inarray, k_smooth[0], k_smooth[1], k_deriv[2], tmparray1, options))
+        goto out;
+
+    if (!fastfilters_fir_convolve3d(inarray, k_deriv[0], k_smooth[1], k_smooth[2], outarray, options))
         goto out;
 
     if (do_sqrt)
@@ -345,40 +586,62 @@ static bool fastfilters_fir_deriv3d(const fastfilters_array3d_t *inarray, double
     else
         fastfilters_combine_add3d(outarray, tmparray0, tmparray1, outarray);
 
+    result = true;
+
 out:
+    kernels_free(k_smooth, 3);
+    kernels_free(k_deriv, 3);
     if (tmparray0)
         fastfilters_array3d_free(tmparray0);
     if (tmparray1)
         fastfilters_array3d_free(tmparray1);
+    fastfilters_trace_end("filter", name);
     return result;
 }
 
+bool DLL_PUBLIC fastfilters_fir_gradmag3d_aniso(const fastfilters_array3d_t *inarray, const double *sigma,
+                                                fastfilters_array3d_t *outarray, const fastfilters_options_t *options)
+{
+    return fastfilters_fir_deriv3d(inarray, sigma, 1, outarray, true, options);
+}
+
 bool DLL_PUBLIC fastfilters_fir_gradmag3d(const fastfilters_array3d_t *inarray, double sigma,
                                           fastfilters_array3d_t *outarray, const fastfilters_options_t *options)
 {
-    return fastfilters_fir_deriv3d(inarray, sigma, 1, outarray, true, options);
+    const double sigmas[3] = {sigma, sigma, sigma};
+    return fastfilters_fir_deriv3d(inarray, sigmas, 1, outarray, true, options);
+}
+
+bool DLL_PUBLIC fastfilters_fir_laplacian3d_aniso(const fastfilters_array3d_t *inarray, const double *sigma,
+                                                  fastfilters_array3d_t *outarray,
+                                                  const fastfilters_options_t *options)
+{
+    return fastfilters_fir_deriv3d(inarray, sigma, 2, outarray, false, options);
 }
 
 bool DLL_PUBLIC fastfilters_fir_laplacian3d(const fastfilters_array3d_t *inarray, double sigma,
                                             fastfilters_array3d_t *outarray, const fastfilters_options_t *options)
 {
-    return fastfilters_fir_deriv3d(inarray, sigma, 2, outarray, false, options);
+    const double sigmas[3] = {sigma, sigma, sigma};
+    return fastfilters_fir_deriv3d(inarray, sigmas, 2, outarray, false, options);
 }
 
-bool DLL_PUBLIC fastfilters_fir_structure_tensor3d(const fastfilters_array3d_t *inarray, double sigma_outer,
-                                                   double sigma_inner, fastfilters_array3d_t *out_xx,
-                                                   fastfilters_array3d_t *out_yy, fastfilters_array3d_t *out_zz,
-                                                   fastfilters_array3d_t *out_xy, fastfilters_array3d_t *out_xz,
-                                                   fastfilters_array3d_t *out_yz, const fastfilters_options_t *options)
+bool DLL_PUBLIC fastfilters_fir_structure_tensor3d_aniso(const fastfilters_array3d_t *inarray,
+                                                         const double *sigma_outer, const double *sigma_inner,
+                                                         fastfilters_array3d_t *out_xx, fastfilters_array3d_t *out_yy,
+                                                         fastfilters_array3d_t *out_zz, fastfilters_array3d_t *out_xy,
+                                                         fastfilters_array3d_t *out_xz, fastfilters_array3d_t *out_yz,
+                                                         const fastfilters_options_t *options)
 {
     bool result = false;
+    fastfilters_kernel_fir_t k_smooth[3] = {NULL, NULL, NULL};
     fastfilters_array3d_t *tmpx = NULL;
     fastfilters_array3d_t *tmpy = NULL;
     fastfilters_array3d_t *tmpz = NULL;
-    fastfilters_array3d_t *tmp = NULL;
 
-    tmp = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
-    if (!tmp)
+    fastfilters_trace_begin("filter", "structure_tensor3d", filter_bytes3d(inarray, 7));
+
+    if (!kernels_alloc(0, sigma_outer, 3, options, k_smooth))
         goto out;
 
     tmpx = fastfilters_array3d_alloc(inarray->n_x, inarray->n_y, inarray->n_z, inarray->n_channels);
@@ -397,44 +660,32 @@ bool DLL_PUBLIC fastfilters_fir_structure_tensor3d(const fastfilters_array3d_t *
     if (!result)
         goto out;
 
-    fastfilters_combine_mul3d(tmpx, tmpx, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_xx, options);
-    if (!result)
-        goto out;
-
-    fastfilters_combine_mul3d(tmpy, tmpy, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_yy, options);
-    if (!result)
-        goto out;
-
-    fastfilters_combine_mul3d(tmpz, tmpz, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_zz, options);
-    if (!result)
-        goto out;
-
-    fastfilters_combine_mul3d(tmpx, tmpy, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_xy, options);
-    if (!result)
-        goto out;
-
-    fastfilters_combine_mul3d(tmpx, tmpz, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_xz, options);
-    if (!result)
-        goto out;
+    const fastfilters_array3d_t *in[3] = {tmpx, tmpy, tmpz};
+    const fastfilters_array3d_t *outs[6] = {out_xx, out_yy, out_zz, out_xy, out_xz, out_yz};
+    const unsigned pairs[6][2] = {{0, 0}, {1, 1}, {2, 2}, {0, 1}, {0, 2}, {1, 2}};
 
-    fastfilters_combine_mul3d(tmpy, tmpz, tmp);
-    result = fastfilters_fir_gaussian3d(tmp, 0, sigma_outer, out_yz, options);
-    if (!result)
-        goto out;
+    result = fastfilters_fir_convolve3d_products(in, pairs, 6, k_smooth[0], k_smooth[1], k_smooth[2], outs);
 
 out:
-    if (tmp)
-        fastfilters_array3d_free(tmp);
+    kernels_free(k_smooth, 3);
     if (tmpx)
         fastfilters_array3d_free(tmpx);
     if (tmpy)
         fastfilters_array3d_free(tmpy);
     if (tmpz)
         fastfilters_array3d_free(tmpz);
+    fastfilters_trace_end("filter", "structure_tensor3d");
     return result;
-}
\ No newline at end of file
+}
+
+bool DLL_PUBLIC fastfilters_fir_structure_tensor3d(const fastfilters_array3d_t *inarray, double sigma_outer,
+                                                   double sigma_inner, fastfilters_array3d_t *out_xx,
+                                                   fastfilters_array3d_t *out_yy, fastfilters_array3d_t *out_zz,
+                                                   fastfilters_array3d_t *out_xy, fastfilters_array3d_t *out_xz,
+                                                   fastfilters_array3d_t *out_yz, const fastfilters_options_t *options)
+{
+    const double sigmas_outer[3] = {sigma_outer, sigma_outer, sigma_outer};
+    const double sigmas_inner[3] = {sigma_inner, sigma_inner, sigma_inner};
+    return fastfilters_fir_structure_tensor3d_aniso(inarray, sigmas_outer, sigmas_inner, out_xx, out_yy, out_zz,
+                                                    out_xy, out_xz, out_yz, options);
+}
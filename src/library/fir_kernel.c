@@ -55,8 +55,7 @@
 #include "fastfilters.h"
 #include "common.h"
 
-fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian(unsigned int order, double sigma,
-                                                                    float window_ratio)
+static fastfilters_kernel_fir_t gaussian_kernel(unsigned int order, double sigma, size_t len)
 {
     double norm;
     double sigma2 = -0.5 / sigma / sigma;
@@ -71,10 +70,7 @@ fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian(unsigned int
     if (!kernel)
         return NULL;
 
-    if (window_ratio > 0)
-        kernel->len = floor(window_ratio * sigma + 0.5);
-    else
-        kernel->len = ceil((3.0 + 0.5 * (double)order) * sigma);
+    kernel->len = len;
 
     if (fabs(sigma) < 1e-6)
         kernel->len = 0;
@@ -86,9 +82,9 @@ fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian(unsigned int
     }
 
     if (order == 1)
-        kernel->is_symmetric = false;
+        kernel->symmetry = FASTFILTERS_KERNEL_ANTISYMMETRIC;
     else
-        kernel->is_symmetric = true;
+        kernel->symmetry = FASTFILTERS_KERNEL_SYMMETRIC;
 
     switch (order) {
     case 1:
@@ -137,7 +133,7 @@ fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian(unsigned int
 
         int sign;
 
-        if (kernel->is_symmetric)
+        if (kernel->symmetry == FASTFILTERS_KERNEL_SYMMETRIC)
             sign = 1;
         else
             sign = -1;
@@ -155,7 +151,10 @@ fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian(unsigned int
     for (unsigned int x = 0; x <= kernel->len; ++x)
         kernel->coefs[x] /= sum;
 
-    if (!kernel->is_symmetric)
+    if (kernel->len == 0 && order == 0)
+        kernel->coefs[0] = 1.0;
+
+    if (kernel->symmetry == FASTFILTERS_KERNEL_ANTISYMMETRIC)
         for (unsigned int x = 0; x <= kernel->len; ++x)
             kernel->coefs[x] *= -1;
 
@@ -165,10 +164,170 @@ fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian(unsigned int
     kernel->fn_outer_mirror = NULL;
     kernel->fn_outer_ptr = NULL;
     kernel->fn_outer_optimistic = NULL;
+    kernel->fn_inner_generation = 0;
+    kernel->fn_outer_generation = 0;
 
     return kernel;
 }
 
+fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian(unsigned int order, double sigma,
+                                                                    float window_ratio)
+{
+    if (window_ratio > 0)
+        return gaussian_kernel(order, sigma, floor(window_ratio * sigma + 0.5));
+
+    return gaussian_kernel(order, sigma, ceil((3.0 + 0.5 * (double)order) * sigma));
+}
+
+// magnitude of the unnormalised gaussian derivative at x
+static double gaussian_magnitude(unsigned int order, double sigma, double x)
+{
+    const double g = exp(-0.5 * x * x / (sigma * sigma));
+
+    switch (order) {
+    case 1:
+        return fabs(x) * g;
+    case 2:
+        return fabs(1.0 - (x / sigma) * (x / sigma)) * g;
+    default:
+        return g;
+    }
+}
+
+// smallest radius whose coefficients beyond it hold at most epsilon of the absolute mass of the kernel. the mass
+// beyond (8 + order) * sigma is negligible and not taken into account.
+static size_t gaussian_radius(unsigned int order, double sigma, double epsilon)
+{
+    const size_t n = ceil((8.0 + (double)order) * sigma) + 1;
+    double total = gaussian_magnitude(order, sigma, 0.0);
+    double tail = 0.0;
+
+    for (size_t x = 1; x <= n; ++x)
+        total += 2.0 * gaussian_magnitude(order, sigma, x);
+
+    for (size_t r = n; r > 0; --r) {
+        tail += 2.0 * gaussian_magnitude(order, sigma, r);
+        if (tail > epsilon * total)
+            return r;
+    }
+
+    return 0;
+}
+
+fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_gaussian_epsilon(unsigned int order, double sigma,
+                                                                            double epsilon)
+{
+    size_t len = 0;
+
+    if (epsilon <= 0.0 || epsilon >= 1.0)
+        return NULL;
+
+    if (sigma >= 1e-6)
+        len = gaussian_radius(order, sigma, epsilon);
+
+    // derivatives need at least the direct neighbours
+    if (order > 0 && len == 0)
+        len = 1;
+
+    return gaussian_kernel(order, sigma, len);
+}
+
+fastfilters_kernel_fir_t DLL_LOCAL fastfilters_kernel_fir_gaussian_opt(unsigned int order, double sigma,
+                                                                       const fastfilters_options_t *options)
+{
+    if (opt_window_ratio(options) <= 0 && opt_epsilon(options) > 0)
+        return fastfilters_kernel_fir_gaussian_epsilon(order, sigma, opt_epsilon(options));
+
+    return fastfilters_kernel_fir_gaussian(order, sigma, opt_window_ratio(options));
+}
+
+static float coef_at(const float *coefs, size_t n_coefs, long offset)
+{
+    long idx = (long)(n_coefs / 2) + offset;
+
+    if (idx < 0 || idx >= (long)n_coefs)
+        return 0.0;
+    return coefs[idx];
+}
+
+fastfilters_kernel_fir_t DLL_PUBLIC fastfilters_kernel_fir_create(const float *coefs, size_t n_coefs)
+{
+    bool symmetric = true;
+    bool antisymmetric;
+    size_t n_stored;
+
+    if (n_coefs == 0)
+        return NULL;
+
+    fastfilters_kernel_fir_t kernel = fastfilters_memory_alloc(sizeof(struct _fastfilters_kernel_fir_t));
+    if (!kernel)
+        return NULL;
+
+    kernel->len = n_coefs / 2;
+
+    // a length 0 kernel is only accepted as identity by the convolution passes
+    if (kernel->len == 0 && coefs[0] != 1.0)
+        kernel->len = 1;
+
+    antisymmetric = coef_at(coefs, n_coefs, 0) == 0.0;
+    for (long k = 1; k <= (long)kernel->len; ++k) {
+        float right = coef_at(coefs, n_coefs, k);
+        float left = coef_at(coefs, n_coefs, -k);
+
+        if (right != left)
+            symmetric = false;
+        if (right != -left)
+            antisymmetric = false;
+    }
+
+    if (symmetric)
+        kernel->symmetry = FASTFILTERS_KERNEL_SYMMETRIC;
+    else if (antisymmetric)
+        kernel->symmetry = FASTFILTERS_KERNEL_ANTISYMMETRIC;
+    else
+        kernel->symmetry = FASTFILTERS_KERNEL_ASYMMETRIC;
+
+    if (kernel->symmetry == FASTFILTERS_KERNEL_ASYMMETRIC)
+        n_stored = 2 * kernel->len + 1;
+    else
+        n_stored = kernel->len + 1;
+
+    kernel->coefs = fastfilters_memory_alloc(sizeof(float) * n_stored);
+    if (!kernel->coefs) {
+        fastfilters_memory_free(kernel);
+        return NULL;
+    }
+
+    for (long k = 0; k <= (long)kernel->len; ++k)
+        kernel->coefs[k] = coef_at(coefs, n_coefs, k);
+
+    if (kernel->symmetry == FASTFILTERS_KERNEL_ASYMMETRIC)
+        for (long k = 1; k <= (long)kernel->len; ++k)
+            kernel->coefs[kernel->len + k] = coef_at(coefs, n_coefs, -k);
+
+    kernel->fn_inner_mirror = NULL;
+    kernel->fn_inner_ptr = NULL;
+    kernel->fn_inner_optimistic = NULL;
+    kernel->fn_outer_mirror = NULL;
+    kernel->fn_outer_ptr = NULL;
+    kernel->fn_outer_optimistic = NULL;
+    kernel->fn_inner_generation = 0;
+    kernel->fn_outer_generation = 0;
+
+    return kernel;
+}
+
+void fastfilters_kernel_fir_scale(fastfilters_kernel_fir_t kernel, double factor)
+{
+    size_t n_coefs = kernel->len + 1;
+
+    if (kernel->symmetry == FASTFILTERS_KERNEL_ASYMMETRIC)
+        n_coefs += kernel->len;
+
+    for (unsigned int x = 0; x < n_coefs; ++x)
+        kernel->coefs[x] *= factor;
+}
+
 void DLL_PUBLIC fastfilters_kernel_fir_free(fastfilters_kernel_fir_t kernel)
 {
     fastfilters_memory_free(kernel->coefs);
@@ -25,6 +25,8 @@ typedef void (*ev3d_fn_t)(const float *, const float *, const float *, const flo
 
 typedef void (*combine_add_fn_t)(const float *, const float *, float *, size_t);
 typedef void (*combine_add3_fn_t)(const float *, const float *, const float *, float *, size_t);
+typedef void (*interleave2_fn_t)(const float *, const float *, float *, size_t, size_t);
+typedef void (*interleave3_fn_t)(const float *, const float *, const float *, float *, size_t, size_t);
 
 void DLL_LOCAL _ev2d_avx(const float *xx, const float *xy, const float *yy, float *ev_small, float *ev_big,
                          const size_t len);
@@ -33,11 +35,35 @@ void DLL_LOCAL _combine_add_avx(const float *a, const float *b, float *c, size_t
 void DLL_LOCAL _combine_addsqrt_avx(const float *a, const float *b, float *c, size_t len);
 void DLL_LOCAL _combine_mul_avx(const float *a, const float *b, float *c, size_t len);
 
+void DLL_LOCAL _interleave2_avx(const float *a, const float *b, float *out, size_t stride, size_t len);
+void DLL_LOCAL _interleave3_avx(const float *a, const float *b, const float *c, float *out, size_t stride, size_t len);
+
 void DLL_LOCAL _combine_add3_avx(const float *a, const float *b, const float *c, float *res, size_t len);
 void DLL_LOCAL _combine_addsqrt3_avx(const float *a, const float *b, const float *c, float *res, size_t len);
+void DLL_LOCAL _combine_muladd_avx(const float *a, const float *b, const float *c, float *res, size_t len);
+
+void DLL_LOCAL _ev2d_avxfma(const float *xx, const float *xy, const float *yy, float *ev_small, float *ev_big,
+                            const size_t len);
+
+void DLL_LOCAL _combine_add_avxfma(const float *a, const float *b, float *c, size_t len);
+void DLL_LOCAL _combine_addsqrt_avxfma(const float *a, const float *b, float *c, size_t len);
+void DLL_LOCAL _combine_mul_avxfma(const float *a, const float *b, float *c, size_t len);
+
+void DLL_LOCAL _combine_add3_avxfma(const float *a, const float *b, const float *c, float *res, size_t len);
+void DLL_LOCAL _combine_addsqrt3_avxfma(const float *a, const float *b, const float *c, float *res, size_t len);
+void DLL_LOCAL _combine_muladd_avxfma(const float *a, const float *b, const float *c, float *res, size_t len);
 
 DLL_LOCAL void _ev3d_avx(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
                          const float *a22, float *ev0, float *ev1, float *ev2, const size_t len);
+DLL_LOCAL void _ev3d_avxfma(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
+                            const float *a22, float *ev0, float *ev1, float *ev2, const size_t len);
+DLL_LOCAL void _ev3d_fast_avx(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
+                              const float *a22, float *ev0, float *ev1, float *ev2, const size_t len);
+DLL_LOCAL void _ev3d_fast_avxfma(const float *a00, const float *a01, const float *a02, const float *a11,
+                                 const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                 const size_t len);
+DLL_LOCAL void _ev3d_fast_avx2(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
+                               const float *a22, float *ev0, float *ev1, float *ev2, const size_t len);
 DLL_LOCAL void _ev3d_avx2(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
                           const float *a22, float *ev0, float *ev1, float *ev2, const size_t len);
 
@@ -199,38 +225,110 @@ static void _combine_addsqrt3_default(const float *a, const float *b, const floa
         res[i] = sqrt(a[i] * a[i] + b[i] * b[i] + c[i] * c[i]);
 }
 
+static void _combine_muladd_default(const float *a, const float *b, const float *c, float *res, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        res[i] = a[i] * b[i] + c[i];
+}
+
+static void _interleave2_default(const float *a, const float *b, float *out, size_t stride, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out[i * stride] = a[i];
+        out[i * stride + 1] = b[i];
+    }
+}
+
+static void _interleave3_default(const float *a, const float *b, const float *c, float *out, size_t stride, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out[i * stride] = a[i];
+        out[i * stride + 1] = b[i];
+        out[i * stride + 2] = c[i];
+    }
+}
+
 static ev2d_fn_t g_ev2d_fn = NULL;
 static ev3d_fn_t g_ev3d_fn = NULL;
+static ev3d_fn_t g_ev3d_fast_fn = NULL;
 static combine_add_fn_t g_combine_add = NULL;
 static combine_add_fn_t g_combine_mul = NULL;
 static combine_add_fn_t g_combine_addsqrt = NULL;
 static combine_add3_fn_t g_combine_add3 = NULL;
 static combine_add3_fn_t g_combine_addsqrt3 = NULL;
+static combine_add3_fn_t g_combine_muladd = NULL;
+static interleave2_fn_t g_interleave2 = NULL;
+static interleave3_fn_t g_interleave3 = NULL;
 
 void fastfilters_linalg_init()
 {
-    if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX)) {
+    if (fastfilters_cpu_check(FASTFILTERS_CPU_FMA)) {
+        g_combine_add = _combine_add_avxfma;
+        g_combine_add3 = _combine_add3_avxfma;
+        g_combine_mul = _combine_mul_avxfma;
+        g_combine_addsqrt = _combine_addsqrt_avxfma;
+        g_combine_addsqrt3 = _combine_addsqrt3_avxfma;
+        g_combine_muladd = _combine_muladd_avxfma;
+        g_ev2d_fn = _ev2d_avxfma;
+        g_interleave2 = _interleave2_avx;
+        g_interleave3 = _interleave3_avx;
+    } else if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX)) {
         g_combine_add = _combine_add_avx;
         g_combine_add3 = _combine_add3_avx;
         g_combine_mul = _combine_mul_avx;
         g_combine_addsqrt = _combine_addsqrt_avx;
         g_combine_addsqrt3 = _combine_addsqrt3_avx;
+        g_combine_muladd = _combine_muladd_avx;
         g_ev2d_fn = _ev2d_avx;
+        g_interleave2 = _interleave2_avx;
+        g_interleave3 = _interleave3_avx;
     } else {
         g_combine_add = _combine_add_default;
         g_combine_add3 = _combine_add3_default;
         g_combine_mul = _combine_mul_default;
         g_combine_addsqrt = _combine_addsqrt_default;
         g_combine_addsqrt3 = _combine_addsqrt3_default;
+        g_combine_muladd = _combine_muladd_default;
         g_ev2d_fn = _ev2d_default;
+        g_interleave2 = _interleave2_default;
+        g_interleave3 = _interleave3_default;
     }
 
-    if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX2)) {
+    if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX2) && fastfilters_cpu_check(FASTFILTERS_CPU_FMA)) {
         g_ev3d_fn = _ev3d_avx2;
+        g_ev3d_fast_fn = _ev3d_fast_avx2;
+    } else if (fastfilters_cpu_check(FASTFILTERS_CPU_FMA)) {
+        g_ev3d_fn = _ev3d_avxfma;
+        g_ev3d_fast_fn = _ev3d_fast_avxfma;
     } else if (fastfilters_cpu_check(FASTFILTERS_CPU_AVX)) {
         g_ev3d_fn = _ev3d_avx;
+        g_ev3d_fast_fn = _ev3d_fast_avx;
     } else {
         g_ev3d_fn = _ev3d_default;
+        g_ev3d_fast_fn = _ev3d_default;
+    }
+}
+
+// the eigenvalues of every pixel are independent. with OpenMP, large inputs are split into chunks that are processed
+// by all threads.
+#define EV_CHUNK_LEN 4096
+#define EV_PARALLEL_MIN_LEN (16 * EV_CHUNK_LEN)
+
+void DLL_PUBLIC fastfilters_linalg_ev3d_ex(const float *a00, const float *a01, const float *a02, const float *a11,
+                                           const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
+                                           const size_t len, fastfilters_precision_t precision)
+{
+    const ev3d_fn_t ev3d_fn = precision == FASTFILTERS_PRECISION_FAST ? g_ev3d_fast_fn : g_ev3d_fn;
+    const ptrdiff_t n_chunks = (len + EV_CHUNK_LEN - 1) / EV_CHUNK_LEN;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (len >= EV_PARALLEL_MIN_LEN)
+#endif
+    for (ptrdiff_t chunk = 0; chunk < n_chunks; ++chunk) {
+        const size_t i = chunk * EV_CHUNK_LEN;
+        const size_t n = len - i < EV_CHUNK_LEN ? len - i : EV_CHUNK_LEN;
+
+        ev3d_fn(a00 + i, a01 + i, a02 + i, a11 + i, a12 + i, a22 + i, ev0 + i, ev1 + i, ev2 + i, n);
     }
 }
 
@@ -238,47 +336,180 @@ void DLL_PUBLIC fastfilters_linalg_ev3d(const float *a00, const float *a01, cons
                                         const float *a12, const float *a22, float *ev0, float *ev1, float *ev2,
                                         const size_t len)
 {
-    g_ev3d_fn(a00, a01, a02, a11, a12, a22, ev0, ev1, ev2, len);
+    fastfilters_linalg_ev3d_ex(a00, a01, a02, a11, a12, a22, ev0, ev1, ev2, len, FASTFILTERS_PRECISION_FULL);
 }
 
 void DLL_PUBLIC fastfilters_linalg_ev2d(const float *xx, const float *xy, const float *yy, float *ev_small,
                                         float *ev_big, const size_t len)
 {
-    g_ev2d_fn(xx, xy, yy, ev_small, ev_big, len);
+    const ptrdiff_t n_chunks = (len + EV_CHUNK_LEN - 1) / EV_CHUNK_LEN;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (len >= EV_PARALLEL_MIN_LEN)
+#endif
+    for (ptrdiff_t chunk = 0; chunk < n_chunks; ++chunk) {
+        const size_t i = chunk * EV_CHUNK_LEN;
+        const size_t n = len - i < EV_CHUNK_LEN ? len - i : EV_CHUNK_LEN;
+
+        g_ev2d_fn(xx + i, xy + i, yy + i, ev_small + i, ev_big + i, n);
+    }
+}
+
+// the planar kernels work on blocks small enough to stay in L1, the block is interleaved into ev from there
+#define EV_BLOCK_LEN 256
+
+void DLL_PUBLIC fastfilters_linalg_ev2d_strided(const float *xx, const float *xy, const float *yy, float *ev,
+                                                size_t ev_stride, const size_t len)
+{
+    const ptrdiff_t n_blocks = (len + EV_BLOCK_LEN - 1) / EV_BLOCK_LEN;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (len >= EV_PARALLEL_MIN_LEN)
+#endif
+    for (ptrdiff_t block = 0; block < n_blocks; ++block) {
+        const size_t i = block * EV_BLOCK_LEN;
+        const size_t n = len - i < EV_BLOCK_LEN ? len - i : EV_BLOCK_LEN;
+        float ev0[EV_BLOCK_LEN], ev1[EV_BLOCK_LEN];
+
+        g_ev2d_fn(xx + i, xy + i, yy + i, ev0, ev1, n);
+        g_interleave2(ev0, ev1, ev + i * ev_stride, ev_stride, n);
+    }
+}
+
+void DLL_PUBLIC fastfilters_linalg_ev3d_strided(const float *a00, const float *a01, const float *a02,
+                                                const float *a11, const float *a12, const float *a22, float *ev,
+                                                size_t ev_stride, const size_t len, fastfilters_precision_t precision)
+{
+    const ev3d_fn_t ev3d_fn = precision == FASTFILTERS_PRECISION_FAST ? g_ev3d_fast_fn : g_ev3d_fn;
+    const ptrdiff_t n_blocks = (len + EV_BLOCK_LEN - 1) / EV_BLOCK_LEN;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (len >= EV_PARALLEL_MIN_LEN)
+#endif
+    for (ptrdiff_t block = 0; block < n_blocks; ++block) {
+        const size_t i = block * EV_BLOCK_LEN;
+        const size_t n = len - i < EV_BLOCK_LEN ? len - i : EV_BLOCK_LEN;
+        float ev0[EV_BLOCK_LEN], ev1[EV_BLOCK_LEN], ev2[EV_BLOCK_LEN];
+
+        ev3d_fn(a00 + i, a01 + i, a02 + i, a11 + i, a12 + i, a22 + i, ev0, ev1, ev2, n);
+        g_interleave3(ev0, ev1, ev2, ev + i * ev_stride, ev_stride, n);
+    }
+}
+
+void DLL_PUBLIC fastfilters_linalg_ev2d_interleaved(const float *xx, const float *xy, const float *yy, float *ev,
+                                                    const size_t len)
+{
+    fastfilters_linalg_ev2d_strided(xx, xy, yy, ev, 2, len);
+}
+
+void DLL_PUBLIC fastfilters_linalg_ev3d_interleaved(const float *a00, const float *a01, const float *a02,
+                                                    const float *a11, const float *a12, const float *a22, float *ev,
+                                                    const size_t len, fastfilters_precision_t precision)
+{
+    fastfilters_linalg_ev3d_strided(a00, a01, a02, a11, a12, a22, ev, 3, len, precision);
+}
+
+// the kernels work on contiguous floats. packed arrays are handed over as a whole, views with padded rows or planes
+// row by row and views that skip pixels pixel by pixel.
+static void combine3d(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b, const fastfilters_array3d_t *c,
+                      const fastfilters_array3d_t *out, combine_add_fn_t fn2, combine_add3_fn_t fn3)
+{
+    const fastfilters_array3d_t *arrays[4] = {a, b, c ? c : a, out};
+    const size_t row_len = out->n_x * out->n_channels;
+    bool x_packed = true;
+    bool packed = true;
+
+    for (unsigned i = 0; i < ARRAY_LENGTH(arrays); ++i) {
+        x_packed = x_packed && arrays[i]->stride_x == out->n_channels;
+        packed = packed && x_packed && arrays[i]->stride_y == row_len &&
+                 (out->n_z == 1 || arrays[i]->stride_z == out->n_y * row_len);
+    }
+
+    const size_t n_x = x_packed ? 1 : out->n_x;
+    const size_t len = x_packed ? row_len : out->n_channels;
+    const size_t n_y = packed ? 1 : out->n_y;
+    const size_t n_z = packed ? 1 : out->n_z;
+
+    for (size_t z = 0; z < n_z; ++z) {
+        for (size_t y = 0; y < n_y; ++y) {
+            for (size_t x = 0; x < n_x; ++x) {
+                const float *ptrs[3];
+
+                for (unsigned i = 0; i < 3; ++i)
+                    ptrs[i] = arrays[i]->ptr + z * arrays[i]->stride_z + y * arrays[i]->stride_y +
+                              x * arrays[i]->stride_x;
+
+                float *outptr = out->ptr + z * out->stride_z + y * out->stride_y + x * out->stride_x;
+
+                if (fn3)
+                    fn3(ptrs[0], ptrs[1], ptrs[2], outptr, packed ? out->n_z * out->n_y * row_len : len);
+                else
+                    fn2(ptrs[0], ptrs[1], outptr, packed ? out->n_z * out->n_y * row_len : len);
+            }
+        }
+    }
+}
+
+static void combine2d(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b, const fastfilters_array2d_t *c,
+                      const fastfilters_array2d_t *out, combine_add_fn_t fn2, combine_add3_fn_t fn3)
+{
+    const fastfilters_array3d_t a3 = array2d_as_3d(a);
+    const fastfilters_array3d_t b3 = array2d_as_3d(b);
+    const fastfilters_array3d_t c3 = array2d_as_3d(c ? c : a);
+    const fastfilters_array3d_t out3 = array2d_as_3d(out);
+
+    combine3d(&a3, &b3, c ? &c3 : NULL, &out3, fn2, fn3);
+}
+
+void DLL_LOCAL fastfilters_combine_mul_row(const float *a, const float *b, float *out, size_t len)
+{
+    g_combine_mul(a, b, out, len);
 }
 
 void DLL_PUBLIC fastfilters_combine_add2d(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b,
                                           fastfilters_array2d_t *out)
 {
-    g_combine_add(a->ptr, b->ptr, out->ptr, a->n_y * a->stride_y);
+    combine2d(a, b, NULL, out, g_combine_add, NULL);
 }
 
 void DLL_PUBLIC fastfilters_combine_addsqrt2d(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b,
                                               fastfilters_array2d_t *out)
 {
-    g_combine_addsqrt(a->ptr, b->ptr, out->ptr, a->n_y * a->stride_y);
+    combine2d(a, b, NULL, out, g_combine_addsqrt, NULL);
 }
 
 void DLL_PUBLIC fastfilters_combine_mul2d(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b,
                                           fastfilters_array2d_t *out)
 {
-    g_combine_mul(a->ptr, b->ptr, out->ptr, a->n_y * a->stride_y);
+    combine2d(a, b, NULL, out, g_combine_mul, NULL);
+}
+
+void DLL_PUBLIC fastfilters_combine_muladd2d(const fastfilters_array2d_t *a, const fastfilters_array2d_t *b,
+                                             const fastfilters_array2d_t *c, fastfilters_array2d_t *out)
+{
+    combine2d(a, b, c, out, NULL, g_combine_muladd);
 }
 
 void DLL_PUBLIC fastfilters_combine_mul3d(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b,
                                           fastfilters_array3d_t *out)
 {
-    g_combine_mul(a->ptr, b->ptr, out->ptr, a->n_z * a->stride_z);
+    combine3d(a, b, NULL, out, g_combine_mul, NULL);
+}
+
+void DLL_PUBLIC fastfilters_combine_muladd3d(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b,
+                                             const fastfilters_array3d_t *c, fastfilters_array3d_t *out)
+{
+    combine3d(a, b, c, out, NULL, g_combine_muladd);
 }
 
 void DLL_PUBLIC fastfilters_combine_add3d(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b,
                                           const fastfilters_array3d_t *c, fastfilters_array3d_t *out)
 {
-    g_combine_add3(a->ptr, b->ptr, c->ptr, out->ptr, a->n_z * a->stride_z);
+    combine3d(a, b, c, out, NULL, g_combine_add3);
 }
 
 void DLL_PUBLIC fastfilters_combine_addsqrt3d(const fastfilters_array3d_t *a, const fastfilters_array3d_t *b,
                                               const fastfilters_array3d_t *c, fastfilters_array3d_t *out)
 {
-    g_combine_addsqrt3(a->ptr, b->ptr, c->ptr, out->ptr, a->n_z * a->stride_z);
+    combine3d(a, b, c, out, NULL, g_combine_addsqrt3);
 }
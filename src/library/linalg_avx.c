@@ -22,8 +22,15 @@
 
 #include <immintrin.h>
 
-void DLL_LOCAL _ev2d_avx(const float *xx, const float *xy, const float *yy, float *ev_big, float *ev_small,
-                         const size_t len)
+// this file is compiled with and without FMA, the FMA build appends fma to the function names
+#ifdef __FMA__
+#define FNAME(x) x##fma
+#else
+#define FNAME(x) x
+#endif
+
+void DLL_LOCAL FNAME(_ev2d_avx)(const float *xx, const float *xy, const float *yy, float *ev_big, float *ev_small,
+                                const size_t len)
 {
     const size_t avx_end = len & ~7;
 
@@ -38,7 +45,7 @@ void DLL_LOCAL _ev2d_avx(const float *xx, const float *xy, const float *yy, floa
         __m256 tmp1 = _mm256_mul_ps(_mm256_sub_ps(v_xx, v_yy), _mm256_set1_ps(0.5));
         tmp1 = _mm256_mul_ps(tmp1, tmp1);
 
-        __m256 det = _mm256_sqrt_ps(_mm256_add_ps(tmp1, _mm256_mul_ps(v_xy, v_xy)));
+        __m256 det = _mm256_sqrt_ps(_avxfun_fmadd(v_xy, v_xy, tmp1));
 
         __m256 ev0 = _mm256_add_ps(tmp0, det);
         __m256 ev1 = _mm256_sub_ps(tmp0, det);
@@ -76,7 +83,7 @@ void DLL_LOCAL _ev2d_avx(const float *xx, const float *xy, const float *yy, floa
     }
 }
 
-void DLL_LOCAL _combine_add_avx(const float *a, const float *b, float *c, size_t len)
+void DLL_LOCAL FNAME(_combine_add_avx)(const float *a, const float *b, float *c, size_t len)
 {
     const size_t avx_end = len & ~7;
 
@@ -92,7 +99,7 @@ void DLL_LOCAL _combine_add_avx(const float *a, const float *b, float *c, size_t
         c[i] = a[i] + b[i];
 }
 
-void DLL_LOCAL _combine_add3_avx(const float *a, const float *b, const float *c, float *res, size_t len)
+void DLL_LOCAL FNAME(_combine_add3_avx)(const float *a, const float *b, const float *c, float *res, size_t len)
 {
     const size_t avx_end = len & ~7;
 
@@ -109,7 +116,7 @@ void DLL_LOCAL _combine_add3_avx(const float *a, const float *b, const float *c,
         res[i] = a[i] + b[i] + c[i];
 }
 
-void DLL_LOCAL _combine_addsqrt_avx(const float *a, const float *b, float *c, size_t len)
+void DLL_LOCAL FNAME(_combine_addsqrt_avx)(const float *a, const float *b, float *c, size_t len)
 {
     const size_t avx_end = len & ~7;
 
@@ -118,17 +125,14 @@ void DLL_LOCAL _combine_addsqrt_avx(const float *a, const float *b, float *c, si
         va = _mm256_loadu_ps(a + i);
         vb = _mm256_loadu_ps(b + i);
 
-        va = _mm256_mul_ps(va, va);
-        vb = _mm256_mul_ps(vb, vb);
-
-        _mm256_storeu_ps(c + i, _mm256_sqrt_ps(_mm256_add_ps(va, vb)));
+        _mm256_storeu_ps(c + i, _mm256_sqrt_ps(_avxfun_fmadd(va, va, _mm256_mul_ps(vb, vb))));
     }
 
     for (size_t i = avx_end; i < len; i++)
         c[i] = sqrt(a[i] * a[i] + b[i] * b[i]);
 }
 
-void DLL_LOCAL _combine_addsqrt3_avx(const float *a, const float *b, const float *c, float *res, size_t len)
+void DLL_LOCAL FNAME(_combine_addsqrt3_avx)(const float *a, const float *b, const float *c, float *res, size_t len)
 {
     const size_t avx_end = len & ~7;
 
@@ -138,11 +142,7 @@ void DLL_LOCAL _combine_addsqrt3_avx(const float *a, const float *b, const float
         vb = _mm256_loadu_ps(b + i);
         vc = _mm256_loadu_ps(c + i);
 
-        va = _mm256_mul_ps(va, va);
-        vb = _mm256_mul_ps(vb, vb);
-        vc = _mm256_mul_ps(vc, vc);
-
-        __m256 sum = _mm256_add_ps(_mm256_add_ps(va, vb), vc);
+        __m256 sum = _avxfun_fmadd(vc, vc, _avxfun_fmadd(vb, vb, _mm256_mul_ps(va, va)));
 
         _mm256_storeu_ps(res + i, _mm256_sqrt_ps(sum));
     }
@@ -151,7 +151,7 @@ void DLL_LOCAL _combine_addsqrt3_avx(const float *a, const float *b, const float
         res[i] = sqrt(a[i] * a[i] + b[i] * b[i] + c[i] * c[i]);
 }
 
-void DLL_LOCAL _combine_mul_avx(const float *a, const float *b, float *c, size_t len)
+void DLL_LOCAL FNAME(_combine_mul_avx)(const float *a, const float *b, float *c, size_t len)
 {
     const size_t avx_end = len & ~7;
 
@@ -165,4 +165,116 @@ void DLL_LOCAL _combine_mul_avx(const float *a, const float *b, float *c, size_t
 
     for (size_t i = avx_end; i < len; i++)
         c[i] = a[i] * b[i];
-}
\ No newline at end of file
+}
+
+void DLL_LOCAL FNAME(_combine_muladd_avx)(const float *a, const float *b, const float *c, float *res, size_t len)
+{
+    const size_t avx_end = len & ~7;
+
+    for (size_t i = 0; i < avx_end; i += 8) {
+        __m256 va, vb, vc;
+        va = _mm256_loadu_ps(a + i);
+        vb = _mm256_loadu_ps(b + i);
+        vc = _mm256_loadu_ps(c + i);
+
+        _mm256_storeu_ps(res + i, _avxfun_fmadd(va, vb, vc));
+    }
+
+    for (size_t i = avx_end; i < len; i++)
+        res[i] = a[i] * b[i] + c[i];
+}
+
+#ifndef __FMA__
+void DLL_LOCAL _interleave2_avx(const float *a, const float *b, float *out, size_t stride, size_t len)
+{
+    const size_t avx_end = len & ~7;
+
+    for (size_t i = 0; i < avx_end; i += 8) {
+        __m256 va = _mm256_loadu_ps(a + i);
+        __m256 vb = _mm256_loadu_ps(b + i);
+        float *outptr = out + i * stride;
+
+        // a0 b0 a1 b1 | a4 b4 a5 b5 and a2 b2 a3 b3 | a6 b6 a7 b7
+        __m256 ab_lo = _mm256_unpacklo_ps(va, vb);
+        __m256 ab_hi = _mm256_unpackhi_ps(va, vb);
+
+        if (stride == 2) {
+            _mm256_storeu_ps(outptr, _mm256_permute2f128_ps(ab_lo, ab_hi, 0x20));
+            _mm256_storeu_ps(outptr + 8, _mm256_permute2f128_ps(ab_lo, ab_hi, 0x31));
+        } else {
+            __m128 ab_lo0 = _mm256_castps256_ps128(ab_lo);
+            __m128 ab_hi0 = _mm256_castps256_ps128(ab_hi);
+            __m128 ab_lo1 = _mm256_extractf128_ps(ab_lo, 1);
+            __m128 ab_hi1 = _mm256_extractf128_ps(ab_hi, 1);
+
+            _mm_storel_pi((__m64 *)outptr, ab_lo0);
+            _mm_storeh_pi((__m64 *)(outptr + stride), ab_lo0);
+            _mm_storel_pi((__m64 *)(outptr + 2 * stride), ab_hi0);
+            _mm_storeh_pi((__m64 *)(outptr + 3 * stride), ab_hi0);
+            _mm_storel_pi((__m64 *)(outptr + 4 * stride), ab_lo1);
+            _mm_storeh_pi((__m64 *)(outptr + 5 * stride), ab_lo1);
+            _mm_storel_pi((__m64 *)(outptr + 6 * stride), ab_hi1);
+            _mm_storeh_pi((__m64 *)(outptr + 7 * stride), ab_hi1);
+        }
+    }
+
+    for (size_t i = avx_end; i < len; i++) {
+        out[i * stride] = a[i];
+        out[i * stride + 1] = b[i];
+    }
+}
+
+void DLL_LOCAL _interleave3_avx(const float *a, const float *b, const float *c, float *out, size_t stride, size_t len)
+{
+    const size_t avx_end = len & ~7;
+
+    for (size_t i = 0; i < avx_end; i += 8) {
+        __m256 va = _mm256_loadu_ps(a + i);
+        __m256 vb = _mm256_loadu_ps(b + i);
+        __m256 vc = _mm256_loadu_ps(c + i);
+        float *outptr = out + i * stride;
+
+        __m256 ab_lo = _mm256_unpacklo_ps(va, vb);
+        __m256 ab_hi = _mm256_unpackhi_ps(va, vb);
+
+        if (stride == 3) {
+            __m256 ca_lo = _mm256_unpacklo_ps(vc, va);
+            __m256 ca_hi = _mm256_unpackhi_ps(vc, va);
+            __m256 bc_lo = _mm256_unpacklo_ps(vb, vc);
+            __m256 bc_hi = _mm256_unpackhi_ps(vb, vc);
+
+            // a0 b0 c0 a1 | b1 c1 a2 b2 | c2 a3 b3 c3 in each 128 bit lane
+            __m256 o0 = _mm256_shuffle_ps(ab_lo, ca_lo, _MM_SHUFFLE(3, 0, 1, 0));
+            __m256 o1 = _mm256_shuffle_ps(bc_lo, ab_hi, _MM_SHUFFLE(1, 0, 3, 2));
+            __m256 o2 = _mm256_shuffle_ps(ca_hi, bc_hi, _MM_SHUFFLE(3, 2, 3, 0));
+
+            _mm256_storeu_ps(outptr, _mm256_permute2f128_ps(o0, o1, 0x20));
+            _mm256_storeu_ps(outptr + 8, _mm256_permute2f128_ps(o2, o0, 0x30));
+            _mm256_storeu_ps(outptr + 16, _mm256_permute2f128_ps(o1, o2, 0x31));
+        } else {
+            __m128 ab_lo0 = _mm256_castps256_ps128(ab_lo);
+            __m128 ab_hi0 = _mm256_castps256_ps128(ab_hi);
+            __m128 ab_lo1 = _mm256_extractf128_ps(ab_lo, 1);
+            __m128 ab_hi1 = _mm256_extractf128_ps(ab_hi, 1);
+
+            _mm_storel_pi((__m64 *)outptr, ab_lo0);
+            _mm_storeh_pi((__m64 *)(outptr + stride), ab_lo0);
+            _mm_storel_pi((__m64 *)(outptr + 2 * stride), ab_hi0);
+            _mm_storeh_pi((__m64 *)(outptr + 3 * stride), ab_hi0);
+            _mm_storel_pi((__m64 *)(outptr + 4 * stride), ab_lo1);
+            _mm_storeh_pi((__m64 *)(outptr + 5 * stride), ab_lo1);
+            _mm_storel_pi((__m64 *)(outptr + 6 * stride), ab_hi1);
+            _mm_storeh_pi((__m64 *)(outptr + 7 * stride), ab_hi1);
+
+            for (size_t j = 0; j < 8; ++j)
+                outptr[j * stride + 2] = c[i + j];
+        }
+    }
+
+    for (size_t i = avx_end; i < len; i++) {
+        out[i * stride] = a[i];
+        out[i * stride + 1] = b[i];
+        out[i * stride + 2] = c[i];
+    }
+}
+#endif
\ No newline at end of file
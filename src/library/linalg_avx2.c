@@ -21,6 +21,7 @@
 #include "avx_mathfun.h"
 
 #include <immintrin.h>
+#include <float.h>
 
 static inline void swap(float *a, float *b)
 {
@@ -29,10 +30,58 @@ static inline void swap(float *a, float *b)
     *b = tmp;
 }
 
+static inline void ev3d_scalar(const float *a00, const float *a01, const float *a02, const float *a11,
+                               const float *a12, const float *a22, float *ev0, float *ev1, float *ev2, size_t i)
+{
+    float inv3 = 1.0 / 3.0;
+    float root3 = sqrt(3.0);
+
+    float c0 = a00[i] * a11[i] * a22[i] + 2.0 * a01[i] * a02[i] * a12[i] - a00[i] * a12[i] * a12[i] -
+               a11[i] * a02[i] * a02[i] - a22[i] * a01[i] * a01[i];
+    float c1 =
+        a00[i] * a11[i] - a01[i] * a01[i] + a00[i] * a22[i] - a02[i] * a02[i] + a11[i] * a22[i] - a12[i] * a12[i];
+    float c2 = a00[i] + a11[i] + a22[i];
+    float c2Div3 = c2 * inv3;
+    float aDiv3 = (c1 - c2 * c2Div3) * inv3;
+
+    if (aDiv3 > 0.0)
+        aDiv3 = 0.0;
+
+    float mbDiv2 = 0.5 * (c0 + c2Div3 * (2.0 * c2Div3 * c2Div3 - c1));
+    float q = mbDiv2 * mbDiv2 + aDiv3 * aDiv3 * aDiv3;
+
+    if (q > 0.0)
+        q = 0.0;
+
+    float magnitude = sqrt(-aDiv3);
+    float angle = atan2(sqrt(-q), mbDiv2) * inv3;
+    float cs = cos(angle);
+    float sn = sin(angle);
+    float r0 = (c2Div3 + 2.0 * magnitude * cs);
+    float r1 = (c2Div3 - magnitude * (cs + root3 * sn));
+    float r2 = (c2Div3 - magnitude * (cs - root3 * sn));
+
+    if (r0 < r1)
+        swap(&r0, &r1);
+    if (r0 < r2)
+        swap(&r0, &r2);
+    if (r1 < r2)
+        swap(&r1, &r2);
+
+    *ev0 = r0;
+    *ev1 = r1;
+    *ev2 = r2;
+}
+
 #ifdef __AVX2__
 #define fname _ev3d_avx2
+#define fname_fast _ev3d_fast_avx2
+#elif defined(__FMA__)
+#define fname _ev3d_avxfma
+#define fname_fast _ev3d_fast_avxfma
 #elif defined(__AVX__)
 #define fname _ev3d_avx
+#define fname_fast _ev3d_fast_avx
 #else
 #error "linalg_avx2.c needs to be compiled with avx or avx2 support"
 #endif
@@ -55,25 +104,27 @@ DLL_LOCAL void fname(const float *a00, const float *a01, const float *a02, const
         __m256 v_a12 = _mm256_loadu_ps(a12 + i);
         __m256 v_a22 = _mm256_loadu_ps(a22 + i);
 
-        __m256 c0 = _avx_sub(_avx_sub(_avx_sub(_avx_add(_avx_mul(_avx_mul(v_a00, v_a11), v_a22),
-            _avx_mul(_avx_mul(_avx_mul(two, v_a01), v_a02), v_a12)),
-            _avx_mul(_avx_mul(v_a00, v_a12), v_a12)),
-            _avx_mul(_avx_mul(v_a11, v_a02), v_a02)),
-            _avx_mul(_avx_mul(v_a22, v_a01), v_a01));
-        __m256 c1 = _avx_sub(_avx_add(_avx_sub(_avx_add(_avx_sub(_avx_mul(v_a00, v_a11),
-            _avx_mul(v_a01, v_a01)),
-            _avx_mul(v_a00, v_a22)),
-            _avx_mul(v_a02, v_a02)),
-            _avx_mul(v_a11, v_a22)),
-            _avx_mul(v_a12, v_a12));
+        __m256 c0 = _avx_mul(_avx_mul(v_a00, v_a11), v_a22);
+        c0 = _avxfun_fmadd(_avx_mul(_avx_mul(two, v_a01), v_a02), v_a12, c0);
+        c0 = _avxfun_fnmadd(v_a00, _avx_mul(v_a12, v_a12), c0);
+        c0 = _avxfun_fnmadd(v_a11, _avx_mul(v_a02, v_a02), c0);
+        c0 = _avxfun_fnmadd(v_a22, _avx_mul(v_a01, v_a01), c0);
+
+        __m256 c1 = _avx_mul(v_a00, v_a11);
+        c1 = _avxfun_fnmadd(v_a01, v_a01, c1);
+        c1 = _avxfun_fmadd(v_a00, v_a22, c1);
+        c1 = _avxfun_fnmadd(v_a02, v_a02, c1);
+        c1 = _avxfun_fmadd(v_a11, v_a22, c1);
+        c1 = _avxfun_fnmadd(v_a12, v_a12, c1);
+
         __m256 c2 = _avx_add(_avx_add(v_a00, v_a11), v_a22);
         __m256 c2Div3 = _avx_mul(c2, v_inv3);
-        __m256 aDiv3 = _avx_mul(_avx_sub(c1, _avx_mul(c2, c2Div3)), v_inv3);
+        __m256 aDiv3 = _avx_mul(_avxfun_fnmadd(c2, c2Div3, c1), v_inv3);
 
         aDiv3 = _mm256_min_ps(aDiv3, zero);
 
-        __m256 mbDiv2 = _avx_mul(half, _avx_add(c0, _avx_mul(c2Div3, _avx_sub(_avx_mul(_avx_mul(two, c2Div3), c2Div3), c1))));
-        __m256 q = _avx_add(_avx_mul(mbDiv2, mbDiv2), _avx_mul(_avx_mul(aDiv3, aDiv3), aDiv3));
+        __m256 mbDiv2 = _avx_mul(half, _avxfun_fmadd(c2Div3, _avxfun_fmsub(_avx_mul(two, c2Div3), c2Div3, c1), c0));
+        __m256 q = _avxfun_fmadd(mbDiv2, mbDiv2, _avx_mul(_avx_mul(aDiv3, aDiv3), aDiv3));
 
         q = _mm256_min_ps(q, zero);
 
@@ -83,9 +134,9 @@ DLL_LOCAL void fname(const float *a00, const float *a01, const float *a02, const
 
         sincos256_ps(angle, &sn, &cs);
 
-        __m256 r0 = _avx_add(c2Div3, _avx_mul(_avx_mul(two, magnitude), cs));
-        __m256 r1 = _avx_sub(c2Div3, _avx_mul(magnitude, _avx_add(cs, _avx_mul(v_root3, sn))));
-        __m256 r2 = _avx_sub(c2Div3, _avx_mul(magnitude, _avx_sub(cs, _avx_mul(v_root3, sn))));
+        __m256 r0 = _avxfun_fmadd(_avx_mul(two, magnitude), cs, c2Div3);
+        __m256 r1 = _avxfun_fnmadd(magnitude, _avxfun_fmadd(v_root3, sn, cs), c2Div3);
+        __m256 r2 = _avxfun_fnmadd(magnitude, _avxfun_fnmadd(v_root3, sn, cs), c2Div3);
 
         __m256 v_r0_tmp = _mm256_min_ps(r0, r1);
         __m256 v_r1_tmp = _mm256_max_ps(r0, r1);
@@ -101,44 +152,126 @@ DLL_LOCAL void fname(const float *a00, const float *a01, const float *a02, const
         _mm256_storeu_ps(ev0 + i, v_r2);
     }
 
-    for (size_t i = avx_end; i < len; ++i) {
-        float inv3 = 1.0 / 3.0;
-        float root3 = sqrt(3.0);
-
-        float c0 = a00[i] * a11[i] * a22[i] + 2.0 * a01[i] * a02[i] * a12[i] - a00[i] * a12[i] * a12[i] -
-                   a11[i] * a02[i] * a02[i] - a22[i] * a01[i] * a01[i];
-        float c1 =
-            a00[i] * a11[i] - a01[i] * a01[i] + a00[i] * a22[i] - a02[i] * a02[i] + a11[i] * a22[i] - a12[i] * a12[i];
-        float c2 = a00[i] + a11[i] + a22[i];
-        float c2Div3 = c2 * inv3;
-        float aDiv3 = (c1 - c2 * c2Div3) * inv3;
-
-        if (aDiv3 > 0.0)
-            aDiv3 = 0.0;
-
-        float mbDiv2 = 0.5 * (c0 + c2Div3 * (2.0 * c2Div3 * c2Div3 - c1));
-        float q = mbDiv2 * mbDiv2 + aDiv3 * aDiv3 * aDiv3;
-
-        if (q > 0.0)
-            q = 0.0;
-
-        float magnitude = sqrt(-aDiv3);
-        float angle = atan2(sqrt(-q), mbDiv2) * inv3;
-        float cs = cos(angle);
-        float sn = sin(angle);
-        float r0 = (c2Div3 + 2.0 * magnitude * cs);
-        float r1 = (c2Div3 - magnitude * (cs + root3 * sn));
-        float r2 = (c2Div3 - magnitude * (cs - root3 * sn));
-
-        if (r0 < r1)
-            swap(&r0, &r1);
-        if (r0 < r2)
-            swap(&r0, &r2);
-        if (r1 < r2)
-            swap(&r1, &r2);
-
-        ev0[i] = r0;
-        ev1[i] = r1;
-        ev2[i] = r2;
+    for (size_t i = avx_end; i < len; ++i)
+        ev3d_scalar(a00, a01, a02, a11, a12, a22, ev0 + i, ev1 + i, ev2 + i, i);
+}
+// 1/sqrt(x) from the hardware estimate refined by one newton step, about 23 bits accurate
+static inline __m256 rsqrt_nr(__m256 x)
+{
+    __m256 y = _mm256_rsqrt_ps(x);
+    __m256 xyy = _avx_mul(_avx_mul(x, y), y);
+
+    return _avx_mul(_avx_mul(_mm256_set1_ps(0.5), y), _avx_sub(_mm256_set1_ps(3.0), xyy));
+}
+
+// same as above with the trigonometric part replaced by low degree polynomials. instead of
+// atan2(sqrt(-q), mbDiv2) the angle is computed as acos(mbDiv2 / magnitude^3) which needs only reciprocal square
+// roots. the eigenvalues have an absolute error of about 1e-4 * magnitude.
+DLL_LOCAL void fname_fast(const float *a00, const float *a01, const float *a02, const float *a11, const float *a12,
+                          const float *a22, float *ev0, float *ev1, float *ev2, const size_t len)
+{
+    const size_t avx_end = len & ~7;
+    __m256 v_inv3 = _mm256_set1_ps(1.0 / 3.0);
+    __m256 v_root3 = _mm256_sqrt_ps(_mm256_set1_ps(3.0));
+    __m256 two = _mm256_set1_ps(2.0);
+    __m256 half = _mm256_set1_ps(0.5);
+    __m256 one = _mm256_set1_ps(1.0);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 tiny = _mm256_set1_ps(FLT_MIN);
+    __m256 pi = _mm256_set1_ps(M_PI);
+    __m256 sign_mask = _mm256_set1_ps(-0.0f);
+
+    // acos(x) = sqrt(1 - x) * (a0 + a1 * x + a2 * x^2 + a3 * x^3) for 0 <= x <= 1, error < 7e-5
+    // (Abramowitz and Stegun 4.4.45)
+    __m256 acos_a0 = _mm256_set1_ps(1.5707288);
+    __m256 acos_a1 = _mm256_set1_ps(-0.2121144);
+    __m256 acos_a2 = _mm256_set1_ps(0.0742610);
+    __m256 acos_a3 = _mm256_set1_ps(-0.0187293);
+
+    // taylor series of cos and sin, the angle is in [0, pi / 3]
+    __m256 cos_c2 = _mm256_set1_ps(-1.0 / 2.0);
+    __m256 cos_c4 = _mm256_set1_ps(1.0 / 24.0);
+    __m256 cos_c6 = _mm256_set1_ps(-1.0 / 720.0);
+    __m256 cos_c8 = _mm256_set1_ps(1.0 / 40320.0);
+    __m256 sin_c3 = _mm256_set1_ps(-1.0 / 6.0);
+    __m256 sin_c5 = _mm256_set1_ps(1.0 / 120.0);
+    __m256 sin_c7 = _mm256_set1_ps(-1.0 / 5040.0);
+
+    for (size_t i = 0; i < avx_end; i += 8) {
+        __m256 v_a00 = _mm256_loadu_ps(a00 + i);
+        __m256 v_a01 = _mm256_loadu_ps(a01 + i);
+        __m256 v_a02 = _mm256_loadu_ps(a02 + i);
+        __m256 v_a11 = _mm256_loadu_ps(a11 + i);
+        __m256 v_a12 = _mm256_loadu_ps(a12 + i);
+        __m256 v_a22 = _mm256_loadu_ps(a22 + i);
+
+        __m256 c0 = _avx_mul(_avx_mul(v_a00, v_a11), v_a22);
+        c0 = _avxfun_fmadd(_avx_mul(_avx_mul(two, v_a01), v_a02), v_a12, c0);
+        c0 = _avxfun_fnmadd(v_a00, _avx_mul(v_a12, v_a12), c0);
+        c0 = _avxfun_fnmadd(v_a11, _avx_mul(v_a02, v_a02), c0);
+        c0 = _avxfun_fnmadd(v_a22, _avx_mul(v_a01, v_a01), c0);
+
+        __m256 c1 = _avx_mul(v_a00, v_a11);
+        c1 = _avxfun_fnmadd(v_a01, v_a01, c1);
+        c1 = _avxfun_fmadd(v_a00, v_a22, c1);
+        c1 = _avxfun_fnmadd(v_a02, v_a02, c1);
+        c1 = _avxfun_fmadd(v_a11, v_a22, c1);
+        c1 = _avxfun_fnmadd(v_a12, v_a12, c1);
+
+        __m256 c2 = _avx_add(_avx_add(v_a00, v_a11), v_a22);
+        __m256 c2Div3 = _avx_mul(c2, v_inv3);
+        __m256 aDiv3 = _avx_mul(_avxfun_fnmadd(c2, c2Div3, c1), v_inv3);
+
+        aDiv3 = _mm256_min_ps(aDiv3, zero);
+
+        __m256 mbDiv2 = _avx_mul(half, _avxfun_fmadd(c2Div3, _avxfun_fmsub(_avx_mul(two, c2Div3), c2Div3, c1), c0));
+
+        // magnitude = sqrt(-aDiv3), cos(3 * angle) = mbDiv2 / magnitude^3. the products are ordered such that
+        // nothing overflows for magnitude = 0.
+        __m256 p = _avx_neg(aDiv3);
+        __m256 inv_magnitude = rsqrt_nr(_mm256_max_ps(p, tiny));
+        __m256 magnitude = _avx_mul(p, inv_magnitude);
+        __m256 r = _avx_mul(_avx_mul(mbDiv2, inv_magnitude), _avx_mul(inv_magnitude, inv_magnitude));
+
+        r = _mm256_max_ps(_mm256_min_ps(r, one), _avx_neg(one));
+
+        __m256 x = _mm256_andnot_ps(sign_mask, r);
+        __m256 one_minus_x = _avx_sub(one, x);
+        __m256 angle = _avxfun_fmadd(acos_a3, x, acos_a2);
+        angle = _avxfun_fmadd(angle, x, acos_a1);
+        angle = _avxfun_fmadd(angle, x, acos_a0);
+        angle = _avx_mul(angle, _avx_mul(one_minus_x, rsqrt_nr(_mm256_max_ps(one_minus_x, tiny))));
+        angle = _mm256_blendv_ps(angle, _avx_sub(pi, angle), r);
+        angle = _avx_mul(angle, v_inv3);
+
+        __m256 angle2 = _avx_mul(angle, angle);
+        __m256 cs = _avxfun_fmadd(cos_c8, angle2, cos_c6);
+        cs = _avxfun_fmadd(cs, angle2, cos_c4);
+        cs = _avxfun_fmadd(cs, angle2, cos_c2);
+        cs = _avxfun_fmadd(cs, angle2, one);
+        __m256 sn = _avxfun_fmadd(sin_c7, angle2, sin_c5);
+        sn = _avxfun_fmadd(sn, angle2, sin_c3);
+        sn = _avxfun_fmadd(sn, angle2, one);
+        sn = _avx_mul(sn, angle);
+
+        __m256 r0 = _avxfun_fmadd(_avx_mul(two, magnitude), cs, c2Div3);
+        __m256 r1 = _avxfun_fnmadd(magnitude, _avxfun_fmadd(v_root3, sn, cs), c2Div3);
+        __m256 r2 = _avxfun_fnmadd(magnitude, _avxfun_fnmadd(v_root3, sn, cs), c2Div3);
+
+        __m256 v_r0_tmp = _mm256_min_ps(r0, r1);
+        __m256 v_r1_tmp = _mm256_max_ps(r0, r1);
+
+        __m256 v_r0 = _mm256_min_ps(v_r0_tmp, r2);
+        __m256 v_r2_tmp = _mm256_max_ps(v_r0_tmp, r2);
+
+        __m256 v_r1 = _mm256_min_ps(v_r1_tmp, v_r2_tmp);
+        __m256 v_r2 = _mm256_max_ps(v_r1_tmp, v_r2_tmp);
+
+        _mm256_storeu_ps(ev2 + i, v_r0);
+        _mm256_storeu_ps(ev1 + i, v_r1);
+        _mm256_storeu_ps(ev0 + i, v_r2);
     }
-}
\ No newline at end of file
+
+    for (size_t i = avx_end; i < len; ++i)
+        ev3d_scalar(a00, a01, a02, a11, a12, a22, ev0 + i, ev1 + i, ev2 + i, i);
+}
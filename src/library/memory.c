@@ -24,9 +24,75 @@
 
 #define ALIGN_MAGIC 0xd2ac461d9c25ee00
 
+// every allocation starts with its size, which keeps the alignment of the allocator for up to 16 bytes
+#define SIZE_HEADER 16
+
+// allocations and frees of different threads update the same counters
+#ifdef _MSC_VER
+#define memory_add(p, v) (_InterlockedExchangeAdd64((volatile __int64 *)(p), (__int64)(v)) + (v))
+#define memory_load(p) (*(volatile int64_t *)(p))
+#define memory_store(p, v) _InterlockedExchange64((volatile __int64 *)(p), (__int64)(v))
+#else
+#define memory_add(p, v) __atomic_add_fetch((p), (v), __ATOMIC_RELAXED)
+#define memory_load(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define memory_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#endif
+
+typedef struct {
+    int64_t current;
+    int64_t peak;
+    int64_t allocations;
+    int64_t largest;
+} memory_counters_t;
+
 static fastfilters_alloc_fn_t g_alloc_fn = NULL;
 static fastfilters_free_fn_t g_free_fn = NULL;
 
+static memory_counters_t g_memory = {0, 0, 0, 0};
+static FF_THREAD_LOCAL memory_counters_t t_memory = {0, 0, 0, 0};
+
+// the profiling counters attribute the difference around a pass to it
+static FF_THREAD_LOCAL uint64_t t_allocated = 0;
+
+static void memory_max(int64_t *p, int64_t value)
+{
+    int64_t cur = memory_load(p);
+
+    while (cur < value) {
+#ifdef _MSC_VER
+        const int64_t prev = _InterlockedCompareExchange64((volatile __int64 *)p, value, cur);
+        if (prev == cur)
+            break;
+        cur = prev;
+#else
+        if (__atomic_compare_exchange_n(p, &cur, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            break;
+#endif
+    }
+}
+
+static void memory_count_alloc(int64_t size)
+{
+    t_allocated += size;
+
+    t_memory.current += size;
+    t_memory.allocations++;
+    if (t_memory.current > t_memory.peak)
+        t_memory.peak = t_memory.current;
+    if (size > t_memory.largest)
+        t_memory.largest = size;
+
+    memory_max(&g_memory.peak, memory_add(&g_memory.current, size));
+    memory_add(&g_memory.allocations, 1);
+    memory_max(&g_memory.largest, size);
+}
+
+static void memory_count_free(int64_t size)
+{
+    t_memory.current -= size;
+    memory_add(&g_memory.current, -size);
+}
+
 void fastfilters_memory_init(fastfilters_alloc_fn_t alloc_fn, fastfilters_free_fn_t free_fn)
 {
     if (alloc_fn)
@@ -42,12 +108,68 @@ void fastfilters_memory_init(fastfilters_alloc_fn_t alloc_fn, fastfilters_free_f
 
 void *fastfilters_memory_alloc(size_t size)
 {
-    return g_alloc_fn(size);
+    char *ptr = g_alloc_fn(size + SIZE_HEADER);
+
+    if (!ptr)
+        return NULL;
+
+    *(size_t *)ptr = size;
+    memory_count_alloc((int64_t)size);
+    return ptr + SIZE_HEADER;
+}
+
+uint64_t fastfilters_memory_thread_allocated(void)
+{
+    return t_allocated;
 }
 
 void fastfilters_memory_free(void *ptr)
 {
-    g_free_fn(ptr);
+    char *ptr_cast;
+
+    if (!ptr)
+        return;
+
+    ptr_cast = (char *)ptr - SIZE_HEADER;
+    memory_count_free((int64_t)*(size_t *)ptr_cast);
+    g_free_fn(ptr_cast);
+}
+
+static void memory_counters_copy(const memory_counters_t *counters, fastfilters_memory_stats_t *stats)
+{
+    stats->current_bytes = counters->current;
+    stats->peak_bytes = counters->peak;
+    stats->allocations = (uint64_t)counters->allocations;
+    stats->largest_bytes = (uint64_t)counters->largest;
+}
+
+void DLL_PUBLIC fastfilters_memory_stats_get(fastfilters_memory_stats_t *global, fastfilters_memory_stats_t *thread)
+{
+    if (global) {
+        memory_counters_t counters;
+
+        counters.current = memory_load(&g_memory.current);
+        counters.peak = memory_load(&g_memory.peak);
+        counters.allocations = memory_load(&g_memory.allocations);
+        counters.largest = memory_load(&g_memory.largest);
+        memory_counters_copy(&counters, global);
+    }
+
+    if (thread)
+        memory_counters_copy(&t_memory, thread);
+}
+
+void DLL_PUBLIC fastfilters_memory_stats_reset(void)
+{
+    // allocations of other threads may run concurrently, raise the peak again if one of them moved current past it
+    memory_store(&g_memory.peak, memory_load(&g_memory.current));
+    memory_max(&g_memory.peak, memory_load(&g_memory.current));
+    memory_store(&g_memory.allocations, 0);
+    memory_store(&g_memory.largest, 0);
+
+    t_memory.peak = t_memory.current;
+    t_memory.allocations = 0;
+    t_memory.largest = 0;
 }
 
 void *fastfilters_memory_align(size_t alignment, size_t size)
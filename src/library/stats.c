@@ -0,0 +1,114 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+// clock_gettime
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "fastfilters.h"
+#include "common.h"
+
+// the passes of different threads add to the same counters
+#ifdef _MSC_VER
+#define stats_add(p, v) _InterlockedExchangeAdd64((volatile __int64 *)(p), (__int64)(v))
+#define stats_load(p) (*(volatile uint64_t *)(p))
+#else
+#define stats_add(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define stats_load(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#endif
+
+static bool g_stats_enabled = false;
+static fastfilters_stats_t g_stats;
+
+uint64_t DLL_LOCAL fastfilters_time_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+bool DLL_LOCAL fastfilters_stats_enabled(void)
+{
+    return g_stats_enabled;
+}
+
+void DLL_LOCAL fastfilters_stats_add(bool outer, fastfilters_stats_variant_t variant,
+                                     const fastfilters_stats_pass_t *pass)
+{
+    fastfilters_stats_pass_t *s = &g_stats.passes[outer ? 1 : 0][variant];
+
+    stats_add(&s->calls, pass->calls);
+    stats_add(&s->time_ns, pass->time_ns);
+    stats_add(&s->pixels, pass->pixels);
+    stats_add(&s->scalar_pixels, pass->scalar_pixels);
+    stats_add(&s->scratch_bytes, pass->scratch_bytes);
+}
+
+void DLL_PUBLIC fastfilters_stats_enable(bool enable)
+{
+    g_stats_enabled = enable;
+}
+
+void DLL_PUBLIC fastfilters_stats_get(fastfilters_stats_t *stats)
+{
+    for (unsigned d = 0; d < 2; ++d) {
+        for (unsigned v = 0; v < FASTFILTERS_STATS_N_VARIANTS; ++v) {
+            const fastfilters_stats_pass_t *s = &g_stats.passes[d][v];
+            fastfilters_stats_pass_t *res = &stats->passes[d][v];
+
+            res->calls = stats_load(&s->calls);
+            res->time_ns = stats_load(&s->time_ns);
+            res->pixels = stats_load(&s->pixels);
+            res->scalar_pixels = stats_load(&s->scalar_pixels);
+            res->scratch_bytes = stats_load(&s->scratch_bytes);
+        }
+    }
+}
+
+void DLL_PUBLIC fastfilters_stats_reset(void)
+{
+    memset(&g_stats, 0, sizeof(g_stats));
+}
+
+void DLL_LOCAL fastfilters_stats_init(void)
+{
+    const char *stats = getenv("FASTFILTERS_STATS");
+
+    if (stats && strcmp(stats, "1") == 0)
+        g_stats_enabled = true;
+}
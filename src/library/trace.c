@@ -0,0 +1,134 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+// getpid
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "fastfilters.h"
+#include "common.h"
+
+#ifdef _MSC_VER
+#define trace_next_tid() _InterlockedIncrement(&g_next_tid)
+#else
+#define trace_next_tid() __atomic_add_fetch(&g_next_tid, 1, __ATOMIC_RELAXED)
+#endif
+
+// events are written as they happen. every event is a single fprintf, which locks the stream, so the lines of
+// concurrent threads do not mix.
+static FILE *g_trace = NULL;
+static uint64_t g_trace_start = 0;
+static int g_trace_pid = 0;
+
+// threads are numbered in the order of their first event
+static long g_next_tid = 0;
+static FF_THREAD_LOCAL long t_tid = 0;
+
+static long trace_tid(void)
+{
+    if (!t_tid)
+        t_tid = trace_next_tid();
+    return t_tid;
+}
+
+// microseconds since fastfilters_trace_start
+static double trace_ts(void)
+{
+    return (double)(fastfilters_time_ns() - g_trace_start) * 1e-3;
+}
+
+bool DLL_LOCAL fastfilters_trace_enabled(void)
+{
+    return g_trace != NULL;
+}
+
+void DLL_LOCAL fastfilters_trace_begin(const char *category, const char *name, uint64_t bytes)
+{
+    FILE *f = g_trace;
+
+    if (!f)
+        return;
+
+    fprintf(f,
+            "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"B\", \"ts\": %.3f, \"pid\": %d, \"tid\": %ld, "
+            "\"args\": {\"bytes\": %llu}},\n",
+            name, category, trace_ts(), g_trace_pid, trace_tid(), (unsigned long long)bytes);
+}
+
+void DLL_LOCAL fastfilters_trace_end(const char *category, const char *name)
+{
+    FILE *f = g_trace;
+
+    if (!f)
+        return;
+
+    fprintf(f, "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"E\", \"ts\": %.3f, \"pid\": %d, \"tid\": %ld},\n", name,
+            category, trace_ts(), g_trace_pid, trace_tid());
+}
+
+bool DLL_PUBLIC fastfilters_trace_start(const char *path)
+{
+    FILE *f;
+
+    fastfilters_trace_stop();
+
+    f = fopen(path, "w");
+    if (!f)
+        return false;
+
+    fprintf(f, "{\"traceEvents\": [\n");
+
+    g_trace_start = fastfilters_time_ns();
+    g_trace_pid = (int)getpid();
+    g_trace = f;
+    return true;
+}
+
+void DLL_PUBLIC fastfilters_trace_stop(void)
+{
+    FILE *f = g_trace;
+
+    if (!f)
+        return;
+
+    // every event is followed by a comma, the process name closes the list
+    g_trace = NULL;
+    fprintf(f, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"fastfilters\"}}\n]}\n",
+            g_trace_pid);
+    fclose(f);
+}
+
+void DLL_LOCAL fastfilters_trace_init(void)
+{
+    const char *path = getenv("FASTFILTERS_TRACE");
+
+    if (path && *path && fastfilters_trace_start(path))
+        atexit(fastfilters_trace_stop);
+}
@@ -0,0 +1,421 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <stdbool.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+// the cache holds one line per cpu and instruction set, "<key>\t<fft inner> <fft outer> <rows> <planes>". the key
+// starts with a format version that is bumped whenever the meaning of the values changes.
+#define TUNE_VERSION "v1"
+#define TUNE_FILE_NAME "fastfilters_tune.txt"
+#define TUNE_PATH_LEN 1024
+#define TUNE_KEY_LEN 128
+#define TUNE_LINE_LEN 256
+
+#define TUNE_REPEATS 3
+#define TUNE_N_2D 1024
+#define TUNE_N_3D 128
+// enough for both benchmark arrays
+#define TUNE_N_VALUES (TUNE_N_3D * TUNE_N_3D * TUNE_N_3D)
+
+// the frequency domain is never used, all kernels shorter than 1 << FFT_MAX_LOG2 / 4 stay below this
+#define TUNE_FFT_NEVER UINT_MAX
+
+// a strip size replaces the current best one only if it is faster by more than the timing noise
+#define TUNE_MIN_GAIN 0.97
+
+static const unsigned tune_fft_lens[] = {6, 8, 10, 12, 16, 20, 24, 32, 48, 64};
+static const unsigned tune_strip_rows[] = {64, 128, 256, 512};
+static const unsigned tune_strip_planes[] = {16, 32, 64, 128};
+
+#define N_ELEMS(a) (sizeof(a) / sizeof((a)[0]))
+
+static const fastfilters_tuning_t g_default_tuning = {FFT_MIN_KERNEL_LEN, FFT_MIN_KERNEL_LEN, REDUCE_STRIP_ROWS,
+                                                      REDUCE_STRIP_PLANES};
+static fastfilters_tuning_t g_tuning = {FFT_MIN_KERNEL_LEN, FFT_MIN_KERNEL_LEN, REDUCE_STRIP_ROWS,
+                                        REDUCE_STRIP_PLANES};
+
+const fastfilters_tuning_t DLL_LOCAL *fastfilters_tuning(void)
+{
+    return &g_tuning;
+}
+
+void DLL_PUBLIC fastfilters_tuning_get(fastfilters_tuning_t *tuning)
+{
+    *tuning = g_tuning;
+}
+
+void DLL_PUBLIC fastfilters_tuning_set(const fastfilters_tuning_t *tuning)
+{
+    g_tuning = g_default_tuning;
+
+    if (!tuning)
+        return;
+
+    if (tuning->fft_min_len_inner)
+        g_tuning.fft_min_len_inner = tuning->fft_min_len_inner;
+    if (tuning->fft_min_len_outer)
+        g_tuning.fft_min_len_outer = tuning->fft_min_len_outer;
+    if (tuning->reduce_strip_rows)
+        g_tuning.reduce_strip_rows = tuning->reduce_strip_rows;
+    if (tuning->reduce_strip_planes)
+        g_tuning.reduce_strip_planes = tuning->reduce_strip_planes;
+}
+
+// the tier the passes are dispatched to, which fastfilters_dispatch_force may have pinned
+static const char *isa_name(void)
+{
+    switch (fastfilters_fir_isa()) {
+    case FASTFILTERS_ISA_AVXFMA:
+        return "avxfma";
+    case FASTFILTERS_ISA_AVX:
+        return "avx";
+    default:
+        return "plain";
+    }
+}
+
+static void tune_key(char *buf, size_t len)
+{
+    char model[64];
+
+    fastfilters_cpu_model(model, sizeof(model));
+    snprintf(buf, len, "%s %s %s", TUNE_VERSION, isa_name(), model);
+}
+
+static bool tune_path(const char *cache_path, char *buf, size_t len)
+{
+    const char *dir;
+    int n;
+
+    if (!cache_path || !*cache_path)
+        cache_path = getenv("FASTFILTERS_TUNE_CACHE");
+
+    if (cache_path && *cache_path)
+        n = snprintf(buf, len, "%s", cache_path);
+    else if ((dir = getenv("XDG_CACHE_HOME")) && *dir)
+        n = snprintf(buf, len, "%s/%s", dir, TUNE_FILE_NAME);
+    else if ((dir = getenv("HOME")) && *dir)
+        n = snprintf(buf, len, "%s/.cache/%s", dir, TUNE_FILE_NAME);
+    else if ((dir = getenv("LOCALAPPDATA")) && *dir)
+        n = snprintf(buf, len, "%s\\%s", dir, TUNE_FILE_NAME);
+    else
+        return false;
+
+    return n > 0 && (size_t)n < len;
+}
+
+// splits a cache line into its key and values, returns false for lines that are not entries
+static bool tune_parse(char *line, char **values)
+{
+    char *tab = strchr(line, '\t');
+
+    if (line[0] == '#' || !tab)
+        return false;
+
+    *tab = 0;
+    *values = tab + 1;
+    return true;
+}
+
+static bool tune_load(const char *path, const char *key, fastfilters_tuning_t *tuning)
+{
+    char line[TUNE_LINE_LEN];
+    bool found = false;
+    FILE *f = fopen(path, "r");
+
+    if (!f)
+        return false;
+
+    // later entries override earlier ones
+    while (fgets(line, sizeof(line), f)) {
+        fastfilters_tuning_t entry;
+        char *values;
+
+        if (!tune_parse(line, &values) || strcmp(line, key))
+            continue;
+
+        if (sscanf(values, "%u %u %u %u", &entry.fft_min_len_inner, &entry.fft_min_len_outer,
+                   &entry.reduce_strip_rows, &entry.reduce_strip_planes) == 4) {
+            *tuning = entry;
+            found = true;
+        }
+    }
+
+    fclose(f);
+    return found;
+}
+
+// rewrites the cache with the entries of the other cpus and the new one for key
+static bool tune_save(const char *path, const char *key, const fastfilters_tuning_t *tuning)
+{
+    bool result = false;
+    char *contents = NULL;
+    size_t len = 0;
+    FILE *f = fopen(path, "rb");
+
+    if (f) {
+        long size;
+
+        if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET))
+            goto out;
+
+        contents = fastfilters_memory_alloc(size + 1);
+        if (!contents)
+            goto out;
+
+        len = fread(contents, 1, size, f);
+        contents[len] = 0;
+        fclose(f);
+    }
+
+    f = fopen(path, "wb");
+    if (!f)
+        goto out;
+
+    fprintf(f, "# fastfilters autotuning cache\n");
+
+    for (char *line = contents, *next; line && *line; line = next) {
+        char *values;
+
+        next = strchr(line, '\n');
+        if (next)
+            *next++ = 0;
+
+        if (tune_parse(line, &values) && strcmp(line, key))
+            fprintf(f, "%s\t%s\n", line, values);
+    }
+
+    fprintf(f, "%s\t%u %u %u %u\n", key, tuning->fft_min_len_inner, tuning->fft_min_len_outer,
+            tuning->reduce_strip_rows, tuning->reduce_strip_planes);
+
+    result = !ferror(f);
+
+out:
+    if (f && fclose(f))
+        result = false;
+    if (contents)
+        fastfilters_memory_free(contents);
+    return result;
+}
+
+typedef enum { TUNE_CONVOLVE2D, TUNE_GRADMAG2D, TUNE_GRADMAG3D } tune_bench_t;
+
+// best processor time of TUNE_REPEATS runs, negative if the filter failed
+static double tune_time(tune_bench_t bench, float *in, float *out, fastfilters_kernel_fir_t kx,
+                        fastfilters_kernel_fir_t ky)
+{
+    const fastfilters_array2d_t in2d = {in, TUNE_N_2D, TUNE_N_2D, 1, TUNE_N_2D, 1};
+    const fastfilters_array2d_t out2d = {out, TUNE_N_2D, TUNE_N_2D, 1, TUNE_N_2D, 1};
+    const fastfilters_array3d_t in3d = {in, TUNE_N_3D, TUNE_N_3D, TUNE_N_3D, 1, TUNE_N_3D, TUNE_N_3D * TUNE_N_3D, 1};
+    fastfilters_array3d_t out3d = {out, TUNE_N_3D, TUNE_N_3D, TUNE_N_3D, 1, TUNE_N_3D, TUNE_N_3D * TUNE_N_3D, 1};
+    fastfilters_array2d_t out2d_grad = out2d;
+    double best = -1.0;
+
+    for (unsigned r = 0; r < TUNE_REPEATS; ++r) {
+        const clock_t start = clock();
+        bool ok;
+
+        switch (bench) {
+        case TUNE_CONVOLVE2D:
+            ok = fastfilters_fir_convolve2d(&in2d, kx, ky, &out2d, NULL);
+            break;
+        case TUNE_GRADMAG2D:
+            ok = fastfilters_fir_gradmag2d(&in2d, 1.5, &out2d_grad, NULL);
+            break;
+        default:
+            ok = fastfilters_fir_gradmag3d(&in3d, 1.5, &out3d, NULL);
+            break;
+        }
+
+        const double t = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        if (!ok)
+            return -1.0;
+        if (best < 0 || t < best)
+            best = t;
+    }
+
+    return best;
+}
+
+// shortest kernel length from which on the frequency domain is faster for all longer candidates
+static bool tune_fft_len(bool outer, float *in, float *out, unsigned *min_len)
+{
+    unsigned *field = outer ? &g_tuning.fft_min_len_outer : &g_tuning.fft_min_len_inner;
+    const unsigned previous = *field;
+    bool result = false;
+    fastfilters_kernel_fir_t identity = fastfilters_kernel_fir_gaussian(0, 0.0, 0.0);
+
+    if (!identity)
+        return false;
+
+    *min_len = TUNE_FFT_NEVER;
+
+    for (size_t i = N_ELEMS(tune_fft_lens); i > 0; --i) {
+        const unsigned len = tune_fft_lens[i - 1];
+        fastfilters_kernel_fir_t kernel = fastfilters_kernel_fir_gaussian(0, len / 3.0, 3.0);
+        double t_direct, t_fft;
+
+        if (!kernel)
+            goto out;
+
+        *field = TUNE_FFT_NEVER;
+        t_direct = tune_time(TUNE_CONVOLVE2D, in, out, outer ? identity : kernel, outer ? kernel : identity);
+        *field = 1;
+        t_fft = tune_time(TUNE_CONVOLVE2D, in, out, outer ? identity : kernel, outer ? kernel : identity);
+
+        fastfilters_kernel_fir_free(kernel);
+
+        if (t_direct < 0 || t_fft < 0)
+            goto out;
+
+        if (t_fft >= t_direct)
+            break;
+        *min_len = len;
+    }
+
+    result = true;
+
+out:
+    *field = previous;
+    fastfilters_kernel_fir_free(identity);
+    return result;
+}
+
+static bool tune_strip(bool is3d, float *in, float *out, unsigned *strip)
+{
+    unsigned *field = is3d ? &g_tuning.reduce_strip_planes : &g_tuning.reduce_strip_rows;
+    const unsigned *candidates = is3d ? tune_strip_planes : tune_strip_rows;
+    const size_t n_candidates = is3d ? N_ELEMS(tune_strip_planes) : N_ELEMS(tune_strip_rows);
+    const tune_bench_t bench = is3d ? TUNE_GRADMAG3D : TUNE_GRADMAG2D;
+    double best = tune_time(bench, in, out, NULL, NULL);
+
+    if (best < 0)
+        return false;
+
+    *strip = *field;
+
+    for (size_t i = 0; i < n_candidates; ++i) {
+        const unsigned previous = *field;
+        double t;
+
+        if (candidates[i] == *strip)
+            continue;
+
+        *field = candidates[i];
+        t = tune_time(bench, in, out, NULL, NULL);
+        *field = previous;
+
+        if (t < 0)
+            return false;
+
+        if (t < TUNE_MIN_GAIN * best) {
+            best = t;
+            *strip = candidates[i];
+        }
+    }
+
+    return true;
+}
+
+bool DLL_PUBLIC fastfilters_autotune(const char *cache_path)
+{
+    bool result = false;
+    bool applied = false;
+    const fastfilters_tuning_t previous = g_tuning;
+    fastfilters_tuning_t tuned;
+    char key[TUNE_KEY_LEN];
+    char path[TUNE_PATH_LEN];
+    float *in = NULL;
+    float *out = NULL;
+    unsigned seed = 1;
+
+    // a pinned path ignores the thresholds
+    if (fastfilters_fir_path() != FASTFILTERS_PATH_AUTO)
+        goto out;
+
+    in = fastfilters_memory_align(32, TUNE_N_VALUES * sizeof(float));
+    if (!in)
+        goto out;
+
+    out = fastfilters_memory_align(32, TUNE_N_VALUES * sizeof(float));
+    if (!out)
+        goto out;
+
+    for (size_t i = 0; i < TUNE_N_VALUES; ++i) {
+        seed = seed * 1103515245 + 12345;
+        in[i] = (float)(seed >> 8) / (float)(1 << 24);
+    }
+
+    // every threshold is tuned with the others at their defaults
+    g_tuning = g_default_tuning;
+    if (!tune_fft_len(false, in, out, &tuned.fft_min_len_inner))
+        goto out;
+    if (!tune_fft_len(true, in, out, &tuned.fft_min_len_outer))
+        goto out;
+    if (!tune_strip(false, in, out, &tuned.reduce_strip_rows))
+        goto out;
+    if (!tune_strip(true, in, out, &tuned.reduce_strip_planes))
+        goto out;
+
+    // a failed save keeps the new values
+    g_tuning = tuned;
+    applied = true;
+
+    tune_key(key, sizeof(key));
+    if (!tune_path(cache_path, path, sizeof(path)))
+        goto out;
+
+    result = tune_save(path, key, &tuned);
+
+out:
+    if (!applied)
+        g_tuning = previous;
+    if (in)
+        fastfilters_memory_align_free(in);
+    if (out)
+        fastfilters_memory_align_free(out);
+    return result;
+}
+
+void DLL_LOCAL fastfilters_tune_init(void)
+{
+    const char *autotune = getenv("FASTFILTERS_AUTOTUNE");
+    fastfilters_tuning_t tuning;
+    char key[TUNE_KEY_LEN];
+    char path[TUNE_PATH_LEN];
+
+    g_tuning = g_default_tuning;
+
+    tune_key(key, sizeof(key));
+    if (tune_path(NULL, path, sizeof(path)) && tune_load(path, key, &tuning)) {
+        fastfilters_tuning_set(&tuning);
+        return;
+    }
+
+    if (autotune && strcmp(autotune, "1") == 0)
+        fastfilters_autotune(NULL);
+}
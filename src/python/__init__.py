@@ -1,8 +1,10 @@
 from __future__ import absolute_import
 from . import core
 import numpy as np
+import multiprocessing
+from multiprocessing.pool import ThreadPool
 
-__all__ = ["gaussianSmoothing", "gaussianGradientMagnitude", "hessianOfGaussianEigenvalues", "laplacianOfGaussian", "structureTensorEigenvalues", "gaussianDerivative"]
+__all__ = ["gaussianSmoothing", "gaussianSmoothingMultiscale", "gaussianGradientMagnitude", "hessianOfGaussianEigenvalues", "laplacianOfGaussian", "structureTensorEigenvalues", "gaussianDerivative", "batch", "autotune"]
 __version__ = core.__version__
 
 try:
@@ -21,11 +23,10 @@ def __p_fix_array(func):
 	"""
 	def func_wrapper(array, *args, **kwargs):
 		if hasattr(array, 'axistags'):
-			array = vigra.taggedView( np.ascontiguousarray(array), array.axistags )
 			squeezed = array.squeeze()
 			res = func(squeezed, *args, **kwargs)
 
-			if res.shape == squeezed.shape:
+			if res.ndim == squeezed.ndim:
 				res = vigra.taggedView( res, squeezed.axistags )
 			else:
 				res = vigra.taggedView( res, list(squeezed.axistags) + [vigra.AxisInfo('c')] )
@@ -62,32 +63,116 @@ def __get_fn(array, fn_2d, fn_3d):
 	else:
 		raise NotImplementedError("Invalid array dimensions: {}".format(  array.shape ))
 
+def __axes(value):
+	"""
+	Scales and step sizes are either scalars or one value per spatial axis (in array axis order).
+	"""
+	if value is None:
+		return []
+	if np.isscalar(value):
+		return [float(value)]
+	return [float(v) for v in value]
+
 @__p_fix_array
-def gaussianSmoothing(array, sigma, window_size=0.0):
-	return __get_fn(array, core.gaussian2d, core.gaussian3d)(array, 0, sigma, window_size)
+def gaussianSmoothing(array, sigma, window_size=0.0, step_size=None, out=None, decimation=1, decimated=False,
+                      epsilon=0.0):
+	"""
+	With decimation = 2 or 4, axes with a sigma of at least 2 * decimation pixels are filtered on a grid decimated by
+	that factor and interpolated (within 1e-3 of the input range). decimated=True returns the decimated grid instead.
+
+	Without a window_size, a positive epsilon truncates each kernel where its discarded tails hold at most that
+	fraction of its absolute mass (e.g. 1e-2 gives a radius of about 2.6 sigma instead of 3 sigma).
+	"""
+	return __get_fn(array, core.gaussian2d, core.gaussian3d)(array, 0, __axes(sigma), window_size, __axes(step_size),
+	                                                         out, decimation, decimated, epsilon=epsilon)
+
+def gaussianSmoothingMultiscale(array, scales, window_size=0.0, step_size=None, out=None, precision="full",
+                                epsilon=0.0):
+	"""
+	Smooth the array with every scale in scales. The results are stacked along a new first axis, result[i] is the
+	array smoothed with scales[i].
+
+	With precision="fast", every scale is computed from the previous one where the scales increase, which needs much
+	shorter kernels but is not exactly the same as filtering the input.
+
+	For VigraArrays, singleton dimensions are removed and the scales axis is tagged as a leading channel axis.
+	"""
+	if hasattr(array, 'axistags'):
+		squeezed = array.squeeze()
+	else:
+		assert not any( np.array(array.shape) == 1 ), \
+			"Can't handle arrays with singleton dimensions (unless they are tagged VigraArrays)."
+		squeezed = array
+
+	res = __get_fn(array, core.gaussian_multiscale2d, core.gaussian_multiscale3d)(squeezed, __axes(scales), window_size,
+	                                                                              __axes(step_size), out, precision,
+	                                                                              epsilon=epsilon)
+
+	# __p_fix_array tags extra axes as trailing channels, the scales come first
+	if hasattr(array, 'axistags'):
+		res = vigra.taggedView( res, [vigra.AxisInfo('c')] + list(squeezed.axistags) )
+	return res
 
 @__p_fix_array
-def gaussianGradientMagnitude(array, sigma, window_size=0.0):
-	return __get_fn(array, core.gradmag2d, core.gradmag3d)(array, sigma, window_size)
+def gaussianGradientMagnitude(array, sigma, window_size=0.0, step_size=None, out=None, epsilon=0.0):
+	return __get_fn(array, core.gradmag2d, core.gradmag3d)(array, __axes(sigma), window_size, __axes(step_size), out,
+	                                                       epsilon=epsilon)
 
 @__p_fix_array
-def hessianOfGaussianEigenvalues(image, scale, window_size=0.0):
-	res = __get_fn(image, core.hog2d, core.hog3d)(image, scale, window_size)
-	return np.rollaxis(res, 0, len(res.shape))
+def hessianOfGaussianEigenvalues(image, scale, window_size=0.0, step_size=None, out=None, precision="full",
+                                 epsilon=0.0):
+	return __get_fn(image, core.hog2d, core.hog3d)(image, __axes(scale), window_size, __axes(step_size), out,
+	                                               precision, epsilon=epsilon)
 
 @__p_fix_array
-def laplacianOfGaussian(array, scale=1.0, window_size=0.0):
-	return __get_fn(array, core.laplacian2d, core.laplacian3d)(array, scale, window_size)
+def laplacianOfGaussian(array, scale=1.0, window_size=0.0, step_size=None, out=None, epsilon=0.0):
+	return __get_fn(array, core.laplacian2d, core.laplacian3d)(array, __axes(scale), window_size, __axes(step_size),
+	                                                           out, epsilon=epsilon)
 
 @__p_fix_array
-def structureTensorEigenvalues(image, innerScale, outerScale, window_size=0.0):
-	res = __get_fn(image, core.st2d, core.st3d)(image, innerScale, outerScale, window_size)
-	return np.rollaxis(res, 0, len(res.shape))
+def structureTensorEigenvalues(image, innerScale, outerScale, window_size=0.0, step_size=None, out=None,
+                               precision="full", epsilon=0.0):
+	return __get_fn(image, core.st2d, core.st3d)(image, __axes(innerScale), __axes(outerScale), window_size,
+	                                             __axes(step_size), out, precision, epsilon=epsilon)
 
 @__p_fix_array
-def gaussianDerivative(array, sigma, order, window_size=0.0):
-    if isinstance(order, list):
+def gaussianDerivative(array, sigma, order, window_size=0.0, step_size=None, out=None, decimation=1, decimated=False,
+                       epsilon=0.0):
+    if isinstance(order, (list, tuple)):
         assert(len(order) == len(array.shape))
-        assert(len(np.unique(order)) == 1)
-        order = order[0]
-    return __get_fn(array, core.gaussian2d, core.gaussian3d)(array, order, sigma, window_size)
+        return __get_fn(array, core.derivative2d, core.derivative3d)(array, list(order), __axes(sigma), window_size,
+                                                                     __axes(step_size), out, decimation, decimated,
+                                                                     epsilon=epsilon)
+    return __get_fn(array, core.gaussian2d, core.gaussian3d)(array, order, __axes(sigma), window_size,
+                                                             __axes(step_size), out, decimation, decimated,
+                                                             epsilon=epsilon)
+
+__pool = None
+__pool_size = 0
+
+def batch(fn, arrays, *args, **kwargs):
+	"""
+	Apply fn(array, *args, **kwargs) to every array in arrays and return the list of results.
+
+	The arrays are filtered concurrently on a pool of threads (fastfilters releases the GIL while filtering).
+	The number of threads defaults to the number of CPUs and can be changed with the n_threads keyword.
+	"""
+	global __pool, __pool_size
+
+	n_threads = kwargs.pop('n_threads', None) or multiprocessing.cpu_count()
+	if __pool_size != n_threads:
+		if __pool is not None:
+			__pool.close()
+		__pool = ThreadPool(n_threads)
+		__pool_size = n_threads
+
+	return __pool.map(lambda array: fn(array, *args, **kwargs), arrays, chunksize=1)
+
+def autotune(cache_path=None):
+	"""
+	Time the candidate implementations on this machine, use the fastest ones and store them in the tuning cache
+	(cache_path, $FASTFILTERS_TUNE_CACHE or fastfilters_tune.txt in the user cache directory), from which they are
+	loaded when fastfilters is imported. Takes about a second. Returns False if the cache could not be written.
+	Filters must not run in other threads meanwhile, since the thresholds they use are replaced.
+	"""
+	return core.autotune(cache_path or "")
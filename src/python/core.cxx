@@ -23,7 +23,9 @@
 #include "common.h"
 
 #include <string>
+#include <vector>
 #include <stdlib.h>
+#include <string.h>
 
 namespace py = pybind11;
 
@@ -34,15 +36,34 @@ struct FIRKernel {
     fastfilters_kernel_fir_t kernel;
     const unsigned order;
     const double sigma;
+    const size_t n_coefs; // 0 for gaussian kernels
 
-    FIRKernel(unsigned order, double sigma) : order(order), sigma(sigma)
+    FIRKernel(unsigned order, double sigma, float window_ratio, double epsilon)
+        : order(order), sigma(sigma), n_coefs(0)
     {
-        kernel = fastfilters_kernel_fir_gaussian(order, sigma, 0.0);
+        if (epsilon > 0.0 && window_ratio <= 0.0)
+            kernel = fastfilters_kernel_fir_gaussian_epsilon(order, sigma, epsilon);
+        else
+            kernel = fastfilters_kernel_fir_gaussian(order, sigma, window_ratio);
 
         if (!kernel)
             throw std::runtime_error("fastfilters_kernel_fir_gaussian returned NULL.");
     }
 
+    FIRKernel(py::array_t<float, py::array::c_style | py::array::forcecast> &coefs)
+        : order(0), sigma(0.0), n_coefs(coefs.size())
+    {
+        py::buffer_info info = coefs.request();
+
+        if (info.ndim != 1)
+            throw std::runtime_error("kernel coefficients must have one dimension.");
+
+        kernel = fastfilters_kernel_fir_create((const float *)info.ptr, info.shape[0]);
+
+        if (!kernel)
+            throw std::runtime_error("fastfilters_kernel_fir_create returned NULL.");
+    }
+
     ~FIRKernel()
     {
         fastfilters_kernel_fir_free(kernel);
@@ -57,7 +78,10 @@ struct FIRKernel {
     std::string __repr__()
     {
         std::stringstream oss;
-        oss << "<fastfilters.FIRKernel with sigma = " << sigma << " and order = " << order << ">";
+        if (n_coefs)
+            oss << "<fastfilters.FIRKernel with " << n_coefs << " coefficients>";
+        else
+            oss << "<fastfilters.FIRKernel with sigma = " << sigma << " and order = " << order << ">";
 
         return oss.str();
     }
@@ -88,7 +112,10 @@ py::array_t<float> linalg_ev2d(py::array_t<float> &mtx)
     float *ev_small = outptr;
     float *ev_big = outptr + info_out.strides[0] / sizeof(float);
 
-    fastfilters_linalg_ev2d(xx, xy, yy, ev_small, ev_big, info.shape[1]);
+    {
+        py::gil_scoped_release release;
+        fastfilters_linalg_ev2d(xx, xy, yy, ev_small, ev_big, info.shape[1]);
+    }
 
     return result;
 }
@@ -126,6 +153,20 @@ void convert_py2ff(py::array_t<float, flags> &np, fastfilters_array_t &ff)
     const unsigned int ff_ndim = ff_ndim_t<fastfilters_array_t>::ndim;
     py::buffer_info np_info = np.request();
 
+    // strided views are passed to fastfilters as they are. only layouts its strides cannot describe (negative or
+    // unaligned strides, channels that are not adjacent) are copied first.
+    bool needs_copy = (uintptr_t)np_info.ptr % sizeof(float) != 0;
+    for (int i = 0; i < (int)np_info.ndim; ++i)
+        if (np_info.strides[i] < 0 || np_info.strides[i] % sizeof(float) != 0)
+            needs_copy = true;
+    if (np_info.ndim == ff_ndim + 1 && np_info.strides[ff_ndim] != sizeof(float))
+        needs_copy = true;
+
+    if (needs_copy) {
+        np = py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(np);
+        np_info = np.request();
+    }
+
     if (np_info.ndim >= (int)ff_ndim) {
         ff.ptr = (float *)np_info.ptr;
 
@@ -153,17 +194,99 @@ void convert_py2ff(py::array_t<float, flags> &np, fastfilters_array_t &ff)
     }
 }
 
-py::array_t<float> array_like(py::array_t<float, py::array::c_style | py::array::forcecast> &base)
+template <typename Shape> py::array_t<float> array_c_style(const Shape &shape)
 {
-    py::buffer_info info = base.request();
-    auto result = py::array(py::buffer_info(nullptr, sizeof(float), py::format_descriptor<float>::value, info.ndim,
-                                            info.shape, info.strides));
+    Shape strides = shape;
+    size_t stride = sizeof(float);
+    for (int i = shape.size() - 1; i >= 0; --i) {
+        strides[i] = stride;
+        stride *= shape[i];
+    }
+
+    auto result = py::array(py::buffer_info(nullptr, sizeof(float), py::format_descriptor<float>::value, shape.size(),
+                                            shape, strides));
 
     return result;
 }
 
-py::array_t<float> convolve_2d_fir(py::array_t<float, py::array::c_style | py::array::forcecast> &input, FIRKernel *k0,
-                                   FIRKernel *k1)
+// results are C-contiguous, independent of the layout of the input
+py::array_t<float> array_like(py::array_t<float, py::array::forcecast> &base)
+{
+    return array_c_style(base.request().shape);
+}
+
+// distance in floats between the pixels of an array whose last axis is contiguous, 0 if they are not evenly spaced
+size_t pixel_stride(const py::array_t<float> &array)
+{
+    const ssize_t ndim = array.ndim();
+
+    if (ndim < 2 || array.strides(ndim - 1) != sizeof(float) || array.strides(ndim - 2) % sizeof(float) != 0 ||
+        array.strides(ndim - 2) < array.shape(ndim - 1) * (ssize_t)sizeof(float))
+        return 0;
+
+    ssize_t stride = array.strides(ndim - 2);
+    for (ssize_t i = ndim - 2; i >= 0; --i) {
+        if (array.shape(i) != 1 && array.strides(i) != stride)
+            return 0;
+        stride *= array.shape(i);
+    }
+
+    return array.strides(ndim - 2) / sizeof(float);
+}
+
+// returns the array a result of the given shape is computed in: a user supplied out array if fastfilters can write to
+// it directly, a new array otherwise. results that were not written to out directly are copied by finish_output.
+// if ev_stride is given, out may also be a view with evenly spaced pixels (e.g. columns of a feature matrix) and
+// ev_stride receives the distance between the pixels of the returned array.
+template <typename Shape>
+py::array_t<float> output_array(py::object &out, const Shape &shape, py::array_t<float, py::array::forcecast> &input,
+                                size_t *ev_stride = NULL)
+{
+    if (ev_stride)
+        *ev_stride = shape.back();
+
+    if (out.is_none())
+        return array_c_style(shape);
+
+    if (!py::isinstance<py::array_t<float>>(out))
+        throw std::invalid_argument("out has to be a float32 numpy array.");
+
+    auto out_array = py::reinterpret_borrow<py::array_t<float>>(out);
+    if (!out_array.writeable())
+        throw std::invalid_argument("out is read-only.");
+
+    bool shape_matches = out_array.ndim() == (ssize_t)shape.size();
+    for (size_t i = 0; shape_matches && i < shape.size(); ++i)
+        shape_matches = out_array.shape(i) == (ssize_t)shape[i];
+    if (!shape_matches)
+        throw std::invalid_argument("out does not have the shape of the result.");
+
+    if (py::module::import("numpy").attr("may_share_memory")(out_array, input).cast<bool>())
+        return array_c_style(shape);
+
+    if (out_array.flags() & py::array::c_style)
+        return out_array;
+
+    if (ev_stride && pixel_stride(out_array)) {
+        *ev_stride = pixel_stride(out_array);
+        return out_array;
+    }
+
+    return array_c_style(shape);
+}
+
+py::array_t<float> finish_output(py::object &out, py::array_t<float> &result)
+{
+    if (out.is_none())
+        return result;
+
+    if (!out.is(result))
+        py::module::import("numpy").attr("copyto")(out, result);
+
+    return py::reinterpret_borrow<py::array_t<float>>(out);
+}
+
+py::array_t<float> convolve_2d_fir(py::array_t<float, py::array::forcecast> &input, FIRKernel *k0, FIRKernel *k1)
 {
     fastfilters_array2d_t ff;
     fastfilters_array2d_t ff_out;
@@ -175,13 +298,19 @@ py::array_t<float> convolve_2d_fir(py::array_t<float, py::array::c_style | py::a
     convert_py2ff(input, ff);
     convert_py2ff(result, ff_out);
 
-    if (!fastfilters_fir_convolve2d(&ff, k0->kernel, k1->kernel, &ff_out, NULL))
+    bool ok;
+    {
+        py::gil_scoped_release release;
+        ok = fastfilters_fir_convolve2d(&ff, k0->kernel, k1->kernel, &ff_out, NULL);
+    }
+
+    if (!ok)
         throw std::logic_error("fastfilters_fir_convolve2d returned false.");
 
     return result;
 }
 
-py::array_t<float> convolve_3d_fir(py::array_t<float, py::array::c_style | py::array::forcecast> &input, FIRKernel *k0,
+py::array_t<float> convolve_3d_fir(py::array_t<float, py::array::forcecast> &input, FIRKernel *k0,
                                    FIRKernel *k1, FIRKernel *k2)
 {
     fastfilters_array3d_t ff;
@@ -194,14 +323,19 @@ py::array_t<float> convolve_3d_fir(py::array_t<float, py::array::c_style | py::a
     convert_py2ff(input, ff);
     convert_py2ff(result, ff_out);
 
-    if (!fastfilters_fir_convolve3d(&ff, k0->kernel, k1->kernel, k2->kernel, &ff_out, NULL))
+    bool ok;
+    {
+        py::gil_scoped_release release;
+        ok = fastfilters_fir_convolve3d(&ff, k0->kernel, k1->kernel, k2->kernel, &ff_out, NULL);
+    }
+
+    if (!ok)
         throw std::logic_error("fastfilters_fir_convolve3d returned false.");
 
     return result;
 }
 
-py::array_t<float> convolve_fir(py::array_t<float, py::array::c_style | py::array::forcecast> &input,
-                                std::vector<FIRKernel *> k)
+py::array_t<float> convolve_fir(py::array_t<float, py::array::forcecast> &input, std::vector<FIRKernel *> k)
 {
     if (k.size() == 2)
         return convolve_2d_fir(input, k[0], k[1]);
@@ -211,11 +345,178 @@ py::array_t<float> convolve_fir(py::array_t<float, py::array::c_style | py::arra
         throw std::logic_error("Invalid number of dimensions.");
 }
 
+// out arrays written in place have to be writeable float32 arrays of the shape of input. fastfilters has to address
+// them without a copy, which convert_py2ff_inplace checks.
+py::array_t<float> inplace_array(py::object &out, const py::array &input)
+{
+    if (!py::isinstance<py::array_t<float>>(out))
+        throw std::invalid_argument("out has to be a float32 numpy array.");
+
+    auto out_array = py::reinterpret_borrow<py::array_t<float>>(out);
+    if (!out_array.writeable())
+        throw std::invalid_argument("out is read-only.");
+
+    bool shape_matches = out_array.ndim() == input.ndim();
+    for (ssize_t i = 0; shape_matches && i < input.ndim(); ++i)
+        shape_matches = out_array.shape(i) == input.shape(i);
+    if (!shape_matches)
+        throw std::invalid_argument("out does not have the shape of input.");
+
+    return out_array;
+}
+
+template <typename fastfilters_array_t> void convert_py2ff_inplace(py::array_t<float> &np, fastfilters_array_t &ff)
+{
+    py::array_t<float> view = np;
+    convert_py2ff(view, ff);
+    if (!view.is(np))
+        throw std::invalid_argument("out has a layout fastfilters cannot write to.");
+}
+
+// recomputes the part of out affected by the dirty region of input. kernels and dirty, a (begin, end) pair per axis,
+// start with x like the kernels of convolve_fir. returns the region that was written in the same order.
+py::list convolve_fir_update(py::array_t<float, py::array::forcecast> &input, std::vector<FIRKernel *> k,
+                             py::object out, std::vector<std::pair<size_t, size_t>> dirty)
+{
+    if ((k.size() != 2 && k.size() != 3) || dirty.size() != k.size())
+        throw std::invalid_argument("kernels and dirty need one entry per spatial axis.");
+
+    // out holds the previous result and is updated in place
+    py::array_t<float> out_array = inplace_array(out, input);
+    std::vector<std::pair<size_t, size_t>> updated(k.size());
+    bool ok;
+
+    if (k.size() == 2) {
+        fastfilters_array2d_t ff, ff_out;
+        const fastfilters_roi2d_t roi = {dirty[0].first, dirty[0].second, dirty[1].first, dirty[1].second};
+        fastfilters_roi2d_t res;
+
+        convert_py2ff(input, ff);
+        convert_py2ff_inplace(out_array, ff_out);
+
+        {
+            py::gil_scoped_release release;
+            ok = fastfilters_fir_convolve2d_update(&ff, &roi, k[0]->kernel, k[1]->kernel, &ff_out, &res, NULL);
+        }
+
+        updated[0] = std::make_pair(res.x_begin, res.x_end);
+        updated[1] = std::make_pair(res.y_begin, res.y_end);
+    } else {
+        fastfilters_array3d_t ff, ff_out;
+        const fastfilters_roi3d_t roi = {dirty[0].first, dirty[0].second, dirty[1].first,
+                                         dirty[1].second, dirty[2].first, dirty[2].second};
+        fastfilters_roi3d_t res;
+
+        convert_py2ff(input, ff);
+        convert_py2ff_inplace(out_array, ff_out);
+
+        {
+            py::gil_scoped_release release;
+            ok = fastfilters_fir_convolve3d_update(&ff, &roi, k[0]->kernel, k[1]->kernel, k[2]->kernel, &ff_out,
+                                                   &res, NULL);
+        }
+
+        updated[0] = std::make_pair(res.x_begin, res.x_end);
+        updated[1] = std::make_pair(res.y_begin, res.y_end);
+        updated[2] = std::make_pair(res.z_begin, res.z_end);
+    }
+
+    if (!ok)
+        throw std::logic_error("fastfilters_fir_convolve_update returned false.");
+
+    py::list result;
+    for (size_t i = 0; i < updated.size(); ++i)
+        result.append(py::make_tuple(updated[i].first, updated[i].second));
+    return result;
+}
+
+// number of inputs of the fastfilters_combine_* operation op for arrays with ndim spatial axes
+unsigned combine_n_inputs(const std::string &op, unsigned ndim)
+{
+    if (op == "add" || op == "addsqrt")
+        return ndim;
+    if (op == "mul")
+        return 2;
+    if (op == "muladd")
+        return 3;
+    throw std::invalid_argument("op must be 'add', 'addsqrt', 'mul' or 'muladd'.");
+}
+
+void combine_ff(const std::string &op, std::vector<fastfilters_array2d_t> &in, fastfilters_array2d_t &out)
+{
+    if (op == "add")
+        fastfilters_combine_add2d(&in[0], &in[1], &out);
+    else if (op == "addsqrt")
+        fastfilters_combine_addsqrt2d(&in[0], &in[1], &out);
+    else if (op == "mul")
+        fastfilters_combine_mul2d(&in[0], &in[1], &out);
+    else
+        fastfilters_combine_muladd2d(&in[0], &in[1], &in[2], &out);
+}
+
+void combine_ff(const std::string &op, std::vector<fastfilters_array3d_t> &in, fastfilters_array3d_t &out)
+{
+    if (op == "add")
+        fastfilters_combine_add3d(&in[0], &in[1], &in[2], &out);
+    else if (op == "addsqrt")
+        fastfilters_combine_addsqrt3d(&in[0], &in[1], &in[2], &out);
+    else if (op == "mul")
+        fastfilters_combine_mul3d(&in[0], &in[1], &out);
+    else
+        fastfilters_combine_muladd3d(&in[0], &in[1], &in[2], &out);
+}
+
+// writes the pixel-wise combination of inputs to out in place: the sum, the square root of the sum of squares, the
+// product of two inputs or a * b + c. ndim spatial axes are followed by an optional channel axis, inputs and out may
+// be strided views.
+template <unsigned ndim>
+void combine(const std::string &op, std::vector<py::array_t<float, py::array::forcecast>> inputs, py::object out)
+{
+    typedef typename std::conditional<ndim == 2, fastfilters_array2d_t, fastfilters_array3d_t>::type ff_array_t;
+
+    if (inputs.size() != combine_n_inputs(op, ndim))
+        throw std::invalid_argument("wrong number of inputs for op.");
+
+    std::vector<ff_array_t> ff(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (inputs[i].request().shape != inputs[0].request().shape)
+            throw std::invalid_argument("inputs need to have the same shape.");
+        convert_py2ff(inputs[i], ff[i]);
+    }
+
+    py::array_t<float> out_array = inplace_array(out, inputs[0]);
+    ff_array_t ff_out;
+    convert_py2ff_inplace(out_array, ff_out);
+
+    py::gil_scoped_release release;
+    combine_ff(op, ff, ff_out);
+}
+
+// per-axis parameters are given in numpy order (z, y, x) and either have one entry per spatial axis or a single
+// entry that is used for all of them. fastfilters expects them starting with x.
+template <unsigned ndim, typename T> std::vector<T> axes_py2ff(const std::vector<T> &v, const char *name)
+{
+    std::vector<T> result(ndim);
+
+    if (v.size() == 1) {
+        for (unsigned i = 0; i < ndim; ++i)
+            result[i] = v[0];
+    } else if (v.size() == ndim) {
+        for (unsigned i = 0; i < ndim; ++i)
+            result[i] = v[ndim - 1 - i];
+    } else {
+        throw std::invalid_argument(std::string(name) + " needs either one entry or one entry per spatial axis.");
+    }
+
+    return result;
+}
+
 struct ConvolveBase {
     fastfilters_options_t opt;
 
     ConvolveBase()
     {
+        memset(&opt, 0, sizeof(opt));
         opt.window_ratio = 0.0;
     }
 
@@ -223,118 +524,295 @@ struct ConvolveBase {
     {
         opt.window_ratio = ratio;
     }
+
+    void set_decimation(unsigned decimation)
+    {
+        opt.decimation = decimation;
+    }
+
+    void set_epsilon(double epsilon)
+    {
+        opt.epsilon = epsilon;
+    }
+
+    template <unsigned ndim> void set_voxel_size(const std::vector<double> &voxel_size)
+    {
+        if (voxel_size.empty())
+            return;
+
+        std::vector<double> v = axes_py2ff<ndim>(voxel_size, "voxel_size");
+        for (unsigned i = 0; i < ndim; ++i)
+            opt.voxel_size[i] = v[i];
+    }
 };
 
 struct ConvolveGaussian : ConvolveBase {
     unsigned order;
-    double sigma;
+    std::vector<double> sigma;
+
+    ConvolveGaussian(unsigned order, double sigma) : order(order), sigma(1, sigma)
+    {
+    }
+
+    ConvolveGaussian(unsigned order, std::vector<double> sigma) : order(order), sigma(sigma)
+    {
+    }
 
-    ConvolveGaussian(unsigned order, double sigma) : order(order), sigma(sigma)
+    bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &out)
+    {
+        std::vector<double> s = axes_py2ff<2>(sigma, "sigma");
+        py::gil_scoped_release release;
+        return fastfilters_fir_gaussian2d_aniso(&in, order, s.data(), &out, &opt);
+    }
+
+    bool operator()(fastfilters_array3d_t &in, fastfilters_array3d_t &out)
+    {
+        std::vector<double> s = axes_py2ff<3>(sigma, "sigma");
+        py::gil_scoped_release release;
+        return fastfilters_fir_gaussian3d_aniso(&in, order, s.data(), &out, &opt);
+    }
+};
+
+struct ConvolveDerivative : ConvolveBase {
+    std::vector<unsigned> order;
+    std::vector<double> sigma;
+
+    ConvolveDerivative(std::vector<unsigned> order, double sigma) : order(order), sigma(1, sigma)
+    {
+    }
+
+    ConvolveDerivative(std::vector<unsigned> order, std::vector<double> sigma) : order(order), sigma(sigma)
     {
     }
 
     bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &out)
     {
+        std::vector<unsigned> o = axes_py2ff<2>(order, "order");
+        std::vector<double> s = axes_py2ff<2>(sigma, "sigma");
         py::gil_scoped_release release;
-        return fastfilters_fir_gaussian2d(&in, order, sigma, &out, &opt);
+        return fastfilters_fir_derivative2d(&in, o.data(), s.data(), &out, &opt);
     }
 
     bool operator()(fastfilters_array3d_t &in, fastfilters_array3d_t &out)
     {
+        std::vector<unsigned> o = axes_py2ff<3>(order, "order");
+        std::vector<double> s = axes_py2ff<3>(sigma, "sigma");
         py::gil_scoped_release release;
-        return fastfilters_fir_gaussian3d(&in, order, sigma, &out, &opt);
+        return fastfilters_fir_derivative3d(&in, o.data(), s.data(), &out, &opt);
     }
 };
 
 struct ConvolveGradMag : ConvolveBase {
-    double sigma;
+    std::vector<double> sigma;
 
-    ConvolveGradMag(double sigma) : sigma(sigma)
+    ConvolveGradMag(double sigma) : sigma(1, sigma)
+    {
+    }
+
+    ConvolveGradMag(std::vector<double> sigma) : sigma(sigma)
     {
     }
 
     bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &out)
     {
+        std::vector<double> s = axes_py2ff<2>(sigma, "sigma");
         py::gil_scoped_release release;
-        return fastfilters_fir_gradmag2d(&in, sigma, &out, &opt);
+        return fastfilters_fir_gradmag2d_aniso(&in, s.data(), &out, &opt);
     }
 
     bool operator()(fastfilters_array3d_t &in, fastfilters_array3d_t &out)
     {
+        std::vector<double> s = axes_py2ff<3>(sigma, "sigma");
         py::gil_scoped_release release;
-        return fastfilters_fir_gradmag3d(&in, sigma, &out, &opt);
+        return fastfilters_fir_gradmag3d_aniso(&in, s.data(), &out, &opt);
     }
 };
 
 struct ConvolveLaPlacian : ConvolveBase {
-    double sigma;
+    std::vector<double> sigma;
+
+    ConvolveLaPlacian(double sigma) : sigma(1, sigma)
+    {
+    }
 
-    ConvolveLaPlacian(double sigma) : sigma(sigma)
+    ConvolveLaPlacian(std::vector<double> sigma) : sigma(sigma)
     {
     }
 
     bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &out)
     {
+        std::vector<double> s = axes_py2ff<2>(sigma, "sigma");
         py::gil_scoped_release release;
-        return fastfilters_fir_laplacian2d(&in, sigma, &out, &opt);
+        return fastfilters_fir_laplacian2d_aniso(&in, s.data(), &out, &opt);
     }
 
     bool operator()(fastfilters_array3d_t &in, fastfilters_array3d_t &out)
     {
+        std::vector<double> s = axes_py2ff<3>(sigma, "sigma");
         py::gil_scoped_release release;
-        return fastfilters_fir_laplacian3d(&in, sigma, &out, &opt);
+        return fastfilters_fir_laplacian3d_aniso(&in, s.data(), &out, &opt);
     }
 };
 
 struct ConvolveHessian : ConvolveBase {
-    double sigma;
+    std::vector<double> sigma;
+
+    ConvolveHessian(double sigma) : sigma(1, sigma)
+    {
+    }
 
-    ConvolveHessian(double sigma) : sigma(sigma)
+    ConvolveHessian(std::vector<double> sigma) : sigma(sigma)
     {
     }
 
     bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &xx, fastfilters_array2d_t &xy,
                     fastfilters_array2d_t &yy)
     {
+        std::vector<double> s = axes_py2ff<2>(sigma, "sigma");
         py::gil_scoped_release release;
-        return fastfilters_fir_hog2d(&in, sigma, &xx, &xy, &yy, &opt);
+        return fastfilters_fir_hog2d_aniso(&in, s.data(), &xx, &xy, &yy, &opt);
     }
 
     bool operator()(fastfilters_array3d_t &in, fastfilters_array3d_t &xx, fastfilters_array3d_t &yy,
                     fastfilters_array3d_t &zz, fastfilters_array3d_t &xy, fastfilters_array3d_t &xz,
                     fastfilters_array3d_t &yz)
     {
+        std::vector<double> s = axes_py2ff<3>(sigma, "sigma");
         py::gil_scoped_release release;
-        return fastfilters_fir_hog3d(&in, sigma, &xx, &yy, &zz, &xy, &xz, &yz, &opt);
+        return fastfilters_fir_hog3d_aniso(&in, s.data(), &xx, &yy, &zz, &xy, &xz, &yz, &opt);
     }
 };
 
 struct ConvolveST : ConvolveBase {
-    double sigma_inner, sigma_outer;
+    std::vector<double> sigma_inner, sigma_outer;
+
+    ConvolveST(double sigma_inner, double sigma_outer) : sigma_inner(1, sigma_inner), sigma_outer(1, sigma_outer)
+    {
+    }
 
-    ConvolveST(double sigma_inner, double sigma_outer) : sigma_inner(sigma_inner), sigma_outer(sigma_outer)
+    ConvolveST(std::vector<double> sigma_inner, std::vector<double> sigma_outer)
+        : sigma_inner(sigma_inner), sigma_outer(sigma_outer)
     {
     }
 
     bool operator()(fastfilters_array2d_t &in, fastfilters_array2d_t &xx, fastfilters_array2d_t &xy,
                     fastfilters_array2d_t &yy)
     {
+        std::vector<double> si = axes_py2ff<2>(sigma_inner, "sigma_inner");
+        std::vector<double> so = axes_py2ff<2>(sigma_outer, "sigma_outer");
         py::gil_scoped_release release;
-        return fastfilters_fir_structure_tensor2d(&in, sigma_inner, sigma_outer, &xx, &xy, &yy, &opt);
+        return fastfilters_fir_structure_tensor2d_aniso(&in, si.data(), so.data(), &xx, &xy, &yy, &opt);
     }
 
     bool operator()(fastfilters_array3d_t &in, fastfilters_array3d_t &xx, fastfilters_array3d_t &yy,
                     fastfilters_array3d_t &zz, fastfilters_array3d_t &xy, fastfilters_array3d_t &xz,
                     fastfilters_array3d_t &yz)
     {
+        std::vector<double> si = axes_py2ff<3>(sigma_inner, "sigma_inner");
+        std::vector<double> so = axes_py2ff<3>(sigma_outer, "sigma_outer");
         py::gil_scoped_release release;
-        return fastfilters_fir_structure_tensor3d(&in, sigma_inner, sigma_outer, &xx, &yy, &zz, &xy, &xz, &yz, &opt);
+        return fastfilters_fir_structure_tensor3d_aniso(&in, si.data(), so.data(), &xx, &yy, &zz, &xy, &xz, &yz,
+                                                        &opt);
     }
 };
 
+fastfilters_precision_t parse_precision(const std::string &precision)
+{
+    if (precision == "full")
+        return FASTFILTERS_PRECISION_FULL;
+    if (precision == "fast")
+        return FASTFILTERS_PRECISION_FAST;
+    throw std::invalid_argument("precision must be 'full' or 'fast'.");
+}
+
+const char *const isa_names[] = {"auto", "plain", "avx", "avxfma"};
+const char *const path_names[] = {"auto", "direct", "runtime_len", "fft"};
+const char *const border_names[] = {"mirror", "optimistic", "ptr"};
+const char *const variant_names[FASTFILTERS_STATS_N_VARIANTS] = {"unrolled", "runtime_len", "rgb", "fft", "multi"};
+
+template <typename T, size_t N> T parse_name(const char *const (&names)[N], const std::string &name, const char *error)
+{
+    for (size_t i = 0; i < N; ++i)
+        if (name == names[i])
+            return (T)i;
+    throw std::invalid_argument(error);
+}
+
+struct ConvolveGaussianMultiscale : ConvolveBase {
+    std::vector<double> scales;
+    fastfilters_precision_t precision;
+
+    ConvolveGaussianMultiscale(std::vector<double> scales, fastfilters_precision_t precision)
+        : scales(scales), precision(precision)
+    {
+    }
+
+    bool operator()(fastfilters_array2d_t &in, std::vector<fastfilters_array2d_t *> &out)
+    {
+        return fastfilters_fir_gaussian2d_multiscale(&in, scales.data(), scales.size(), precision, out.data(), &opt);
+    }
+
+    bool operator()(fastfilters_array3d_t &in, std::vector<fastfilters_array3d_t *> &out)
+    {
+        return fastfilters_fir_gaussian3d_multiscale(&in, scales.data(), scales.size(), precision, out.data(), &opt);
+    }
+};
+
+// all scales are returned at once, stacked along a new first axis so that every scale is a contiguous array the
+// cascade writes and reads directly.
+template <unsigned ndim>
+py::array_t<float> gaussian_multiscale(py::array_t<float, py::array::forcecast> &input, std::vector<double> scales,
+                                       float window_ratio, std::vector<double> voxel_size, py::object out,
+                                       std::string precision, double epsilon)
+{
+    typedef typename std::conditional<ndim == 2, fastfilters_array2d_t, fastfilters_array3d_t>::type ff_array_t;
+
+    if (scales.empty())
+        throw std::invalid_argument("scales must not be empty.");
+
+    ConvolveGaussianMultiscale fn(scales, parse_precision(precision));
+    fn.set_window_ratio(window_ratio);
+    fn.set_epsilon(epsilon);
+    fn.template set_voxel_size<ndim>(voxel_size);
+
+    ff_array_t ff;
+    convert_py2ff(input, ff);
+
+    const size_t n_scales = scales.size();
+    const size_t scale_size = input.size();
+
+    std::vector<ssize_t> shape = input.request().shape;
+    shape.insert(shape.begin(), n_scales);
+
+    auto result = output_array(out, shape, input);
+    float *outptr = (float *)result.request().ptr;
+
+    std::vector<ff_array_t> views(n_scales);
+    std::vector<ff_array_t *> view_ptrs(n_scales);
+    for (size_t k = 0; k < n_scales; ++k) {
+        views[k] = ff;
+        views[k].ptr = outptr + k * scale_size;
+        views[k].stride_x = ff.n_channels;
+        views[k].stride_y = ff.n_x * ff.n_channels;
+        ff_ndim_t<ff_array_t>::set_stride_z(ff.n_y * ff.n_x * ff.n_channels, views[k]);
+        view_ptrs[k] = &views[k];
+    }
+
+    bool ok;
+    {
+        py::gil_scoped_release release;
+        ok = fn(ff, view_ptrs);
+    }
+
+    if (!ok)
+        throw std::logic_error("convolution failed.");
+
+    return finish_output(out, result);
+}
+
 template <class ConvolveFunctor>
-py::array_t<float> filter_ev_2d_binding(py::array_t<float, py::array::c_style | py::array::forcecast> &input,
-                                        ConvolveFunctor &fn)
+py::array_t<float> filter_ev_2d_binding(py::array_t<float, py::array::forcecast> &input, ConvolveFunctor &fn,
+                                        py::object &out)
 {
     fastfilters_array2d_t ff;
     fastfilters_array2d_t ff_out_xx, ff_out_yy, ff_out_xy;
@@ -354,55 +832,28 @@ py::array_t<float> filter_ev_2d_binding(py::array_t<float, py::array::c_style |
 
     const size_t n_pixels = ff.n_x * ff.n_y * ff.n_channels;
 
-    std::vector<size_t> shape;
-    std::vector<size_t> strides;
-
-    unsigned int n_dim = 3;
-
-    if (ff.n_channels == 1) {
-        n_dim = 3;
-
-        shape.push_back(2);
-        shape.push_back(ff.n_y);
-        shape.push_back(ff.n_x);
-
-        strides.push_back(sizeof(float) * ff.n_y * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_x);
-        strides.push_back(sizeof(float));
-    } else {
-        n_dim = 4;
-
-        shape.push_back(2);
-        shape.push_back(ff.n_y);
-        shape.push_back(ff.n_x);
+    // eigenvalues are stored per pixel as the last axis
+    std::vector<size_t> shape = {ff.n_y, ff.n_x};
+    if (ff.n_channels != 1)
         shape.push_back(ff.n_channels);
+    shape.push_back(2);
 
-        strides.push_back(sizeof(float) * ff.n_channels * ff.n_y * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_channels * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_channels);
-        strides.push_back(sizeof(float));
-    }
-
-    auto result =
-        py::array(py::buffer_info(nullptr, sizeof(float), py::format_descriptor<float>::value, n_dim, shape, strides));
+    size_t ev_stride;
+    auto result = output_array(out, shape, input, &ev_stride);
     py::buffer_info info_out = result.request();
 
-    float *xx = ff_out_xx.ptr;
-    float *xy = ff_out_xy.ptr;
-    float *yy = ff_out_yy.ptr;
-
-    float *outptr = (float *)info_out.ptr;
-    float *ev_small = outptr;
-    float *ev_big = outptr + n_pixels;
-
-    fastfilters_linalg_ev2d(xx, xy, yy, ev_small, ev_big, n_pixels);
+    {
+        py::gil_scoped_release release;
+        fastfilters_linalg_ev2d_strided(ff_out_xx.ptr, ff_out_xy.ptr, ff_out_yy.ptr, (float *)info_out.ptr, ev_stride,
+                                        n_pixels);
+    }
 
-    return result;
+    return finish_output(out, result);
 }
 
 template <class ConvolveFunctor>
-py::array_t<float> filter_ev_3d_binding(py::array_t<float, py::array::c_style | py::array::forcecast> &input,
-                                        ConvolveFunctor &fn)
+py::array_t<float> filter_ev_3d_binding(py::array_t<float, py::array::forcecast> &input, ConvolveFunctor &fn,
+                                        py::object &out, fastfilters_precision_t precision)
 {
     fastfilters_array3d_t ff;
     fastfilters_array3d_t ff_out_xx, ff_out_yy, ff_out_zz, ff_out_xy, ff_out_xz, ff_out_yz;
@@ -426,80 +877,47 @@ py::array_t<float> filter_ev_3d_binding(py::array_t<float, py::array::c_style |
     if (!fn(ff, ff_out_xx, ff_out_yy, ff_out_zz, ff_out_xy, ff_out_xz, ff_out_yz))
         throw std::logic_error("convolution failed.");
 
-    std::vector<size_t> shape;
-    std::vector<size_t> strides;
-
     const size_t n_pixels = ff.n_z * ff.n_x * ff.n_y * ff.n_channels;
 
-    unsigned int n_dim = 4;
-
-    if (ff.n_channels == 1) {
-        n_dim = 4;
-
-        shape.push_back(3);
-        shape.push_back(ff.n_z);
-        shape.push_back(ff.n_y);
-        shape.push_back(ff.n_x);
-
-        strides.push_back(sizeof(float) * ff.n_z * ff.n_y * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_y * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_x);
-        strides.push_back(sizeof(float));
-    } else {
-        n_dim = 5;
-
-        shape.push_back(3);
-        shape.push_back(ff.n_z);
-        shape.push_back(ff.n_y);
-        shape.push_back(ff.n_x);
+    std::vector<size_t> shape = {ff.n_z, ff.n_y, ff.n_x};
+    if (ff.n_channels != 1)
         shape.push_back(ff.n_channels);
+    shape.push_back(3);
 
-        strides.push_back(sizeof(float) * ff.n_channels * ff.n_x * ff.n_y * ff.n_z);
-        strides.push_back(sizeof(float) * ff.n_channels * ff.n_x * ff.n_y);
-        strides.push_back(sizeof(float) * ff.n_channels * ff.n_x);
-        strides.push_back(sizeof(float) * ff.n_channels);
-        strides.push_back(sizeof(float));
-    }
-
-    auto result =
-        py::array(py::buffer_info(nullptr, sizeof(float), py::format_descriptor<float>::value, n_dim, shape, strides));
+    size_t ev_stride;
+    auto result = output_array(out, shape, input, &ev_stride);
     py::buffer_info info_out = result.request();
 
-    float *xx = ff_out_xx.ptr;
-    float *yy = ff_out_yy.ptr;
-    float *zz = ff_out_zz.ptr;
-    float *xy = ff_out_xy.ptr;
-    float *xz = ff_out_xz.ptr;
-    float *yz = ff_out_yz.ptr;
-
-    float *outptr = (float *)info_out.ptr;
-    float *ev0 = outptr;
-    float *ev1 = outptr + n_pixels;
-    float *ev2 = outptr + 2 * n_pixels;
-
-    fastfilters_linalg_ev3d(zz, yz, xz, yy, xy, xx, ev0, ev1, ev2, n_pixels);
-    // fastfilters_linalg_ev3d(xx, xy, yy, xz, yz, zz, ev0, ev1, ev2, n_pixels);
-    // fastfilters_linalg_ev3d(xx, xy, xz, yy, yz, zz, ev0, ev1, ev2, n_pixels);
+    {
+        py::gil_scoped_release release;
+        fastfilters_linalg_ev3d_strided(ff_out_zz.ptr, ff_out_yz.ptr, ff_out_xz.ptr, ff_out_yy.ptr, ff_out_xy.ptr,
+                                        ff_out_xx.ptr, (float *)info_out.ptr, ev_stride, n_pixels, precision);
+    }
 
-    return result;
+    return finish_output(out, result);
 }
 
+// with decimation > 1, the result only has every decimation-th pixel along the spatial axes
 template <unsigned ndim, typename ConvolveFunctor>
-py::array_t<float> filter_binding(py::array_t<float, py::array::c_style | py::array::forcecast> &input,
-                                  ConvolveFunctor &fn)
+py::array_t<float> filter_binding(py::array_t<float, py::array::forcecast> &input, ConvolveFunctor &fn, py::object &out,
+                                  unsigned decimation = 1)
 {
     typedef typename std::conditional<ndim == 2, fastfilters_array2d_t, fastfilters_array3d_t>::type ff_array_t;
     ff_array_t ff;
     ff_array_t ff_out;
 
-    auto result = array_like(input);
+    std::vector<ssize_t> shape = input.request().shape;
+    for (unsigned i = 0; i < ndim && i < shape.size(); ++i)
+        shape[i] = (shape[i] + decimation - 1) / decimation;
+
+    auto result = output_array(out, shape, input);
     convert_py2ff(input, ff);
     convert_py2ff(result, ff_out);
 
     if (!fn(ff, ff_out))
         throw std::logic_error("convolution failed.");
 
-    return result;
+    return finish_output(out, result);
 }
 
 template <typename T> py::arg arg_wrapper()
@@ -510,38 +928,91 @@ template <typename T> py::arg arg_wrapper()
 template <typename ConvolveFunctor, typename... args> void bind2d3d(py::module &m, const std::string prefix)
 {
     m.def((prefix + "2d").c_str(),
-          [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio) {
+          [](py::array_t<float, py::array::forcecast> &input, args... E, float window_ratio,
+             std::vector<double> voxel_size, py::object out, double epsilon) {
 
               ConvolveFunctor fn(E...);
               fn.set_window_ratio(window_ratio);
-              return filter_binding<2>(input, fn);
+              fn.set_epsilon(epsilon);
+              fn.template set_voxel_size<2>(voxel_size);
+              return filter_binding<2>(input, fn, out);
           },
-          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0);
+          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0,
+          py::arg("voxel_size") = std::vector<double>(), py::arg("out") = py::none(), py::arg("epsilon") = 0.0);
     m.def((prefix + "3d").c_str(),
-          [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio) {
+          [](py::array_t<float, py::array::forcecast> &input, args... E, float window_ratio,
+             std::vector<double> voxel_size, py::object out, double epsilon) {
               ConvolveFunctor fn(E...);
               fn.set_window_ratio(window_ratio);
-              return filter_binding<3>(input, fn);
+              fn.set_epsilon(epsilon);
+              fn.template set_voxel_size<3>(voxel_size);
+              return filter_binding<3>(input, fn, out);
           },
-          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0);
+          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0,
+          py::arg("voxel_size") = std::vector<double>(), py::arg("out") = py::none(), py::arg("epsilon") = 0.0);
+}
+
+// gaussians and derivatives can be evaluated on a decimated grid, see fastfilters_options_t
+template <typename ConvolveFunctor, typename... args> void bind2d3d_decimation(py::module &m, const std::string prefix)
+{
+    m.def((prefix + "2d").c_str(),
+          [](py::array_t<float, py::array::forcecast> &input, args... E, float window_ratio,
+             std::vector<double> voxel_size, py::object out, unsigned decimation, bool decimated,
+             double epsilon) {
+              ConvolveFunctor fn(E...);
+              fn.set_window_ratio(window_ratio);
+              fn.set_epsilon(epsilon);
+              fn.template set_voxel_size<2>(voxel_size);
+              fn.set_decimation(decimation);
+              return filter_binding<2>(input, fn, out, decimated && decimation > 1 ? decimation : 1);
+          },
+          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0,
+          py::arg("voxel_size") = std::vector<double>(), py::arg("out") = py::none(), py::arg("decimation") = 1,
+          py::arg("decimated") = false, py::arg("epsilon") = 0.0);
+    m.def((prefix + "3d").c_str(),
+          [](py::array_t<float, py::array::forcecast> &input, args... E, float window_ratio,
+             std::vector<double> voxel_size, py::object out, unsigned decimation, bool decimated,
+             double epsilon) {
+              ConvolveFunctor fn(E...);
+              fn.set_window_ratio(window_ratio);
+              fn.set_epsilon(epsilon);
+              fn.template set_voxel_size<3>(voxel_size);
+              fn.set_decimation(decimation);
+              return filter_binding<3>(input, fn, out, decimated && decimation > 1 ? decimation : 1);
+          },
+          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0,
+          py::arg("voxel_size") = std::vector<double>(), py::arg("out") = py::none(), py::arg("decimation") = 1,
+          py::arg("decimated") = false, py::arg("epsilon") = 0.0);
 }
 
 template <typename ConvolveFunctor, typename... args> void bind2d3d_ev(py::module &m, const std::string prefix)
 {
+    // there is no approximate 2d kernel, precision is only validated there
     m.def((prefix + "2d").c_str(),
-          [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio) {
+          [](py::array_t<float, py::array::forcecast> &input, args... E, float window_ratio,
+             std::vector<double> voxel_size, py::object out, std::string precision, double epsilon) {
+              parse_precision(precision);
               ConvolveFunctor fn(E...);
               fn.set_window_ratio(window_ratio);
-              return filter_ev_2d_binding(input, fn);
+              fn.set_epsilon(epsilon);
+              fn.template set_voxel_size<2>(voxel_size);
+              return filter_ev_2d_binding(input, fn, out);
           },
-          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0);
+          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0,
+          py::arg("voxel_size") = std::vector<double>(), py::arg("out") = py::none(), py::arg("precision") = "full",
+          py::arg("epsilon") = 0.0);
     m.def((prefix + "3d").c_str(),
-          [](py::array_t<float, py::array::c_style | py::array::forcecast> &input, args... E, float window_ratio) {
+          [](py::array_t<float, py::array::forcecast> &input, args... E, float window_ratio,
+             std::vector<double> voxel_size, py::object out, std::string precision, double epsilon) {
               ConvolveFunctor fn(E...);
               fn.set_window_ratio(window_ratio);
-              return filter_ev_3d_binding(input, fn);
+              fn.set_epsilon(epsilon);
+              fn.template set_voxel_size<3>(voxel_size);
+              return filter_ev_3d_binding(input, fn, out, parse_precision(precision));
           },
-          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0);
+          py::arg("input"), arg_wrapper<args *>()..., py::arg("window_ratio") = 0.0,
+          py::arg("voxel_size") = std::vector<double>(), py::arg("out") = py::none(), py::arg("precision") = "full",
+          py::arg("epsilon") = 0.0);
 }
 };
 
@@ -575,18 +1046,144 @@ PYBIND11_MODULE(core, m_fastfilters)
     m_fastfilters.attr("__version__") = pybind11::str(FF_VERSION_STR);
 
     py::class_<FIRKernel>(m_fastfilters, "FIRKernel")
-        .def(py::init<unsigned, double>())
+        .def(py::init<unsigned, double, float, double>(), py::arg("order"), py::arg("sigma"),
+             py::arg("window_ratio") = 0.0, py::arg("epsilon") = 0.0)
+        .def(py::init<py::array_t<float, py::array::c_style | py::array::forcecast> &>(), py::arg("coefs"))
         .def("len", &FIRKernel::len)
+        .def("__repr__", &FIRKernel::__repr__)
         .def_readonly("sigma", &FIRKernel::sigma)
         .def_readonly("order", &FIRKernel::order);
 
     m_fastfilters.def("linalg_ev2d", &linalg_ev2d);
     m_fastfilters.def("convolve_fir", &convolve_fir, py::arg("input"), py::arg("kernels"));
-
-    bind2d3d<ConvolveGaussian, unsigned, double>(m_fastfilters, "gaussian");
+    m_fastfilters.def("combine2d", &combine<2>, py::arg("op"), py::arg("inputs"), py::arg("out"));
+    m_fastfilters.def("combine3d", &combine<3>, py::arg("op"), py::arg("inputs"), py::arg("out"));
+    m_fastfilters.def("convolve_fir_update", &convolve_fir_update, py::arg("input"), py::arg("kernels"), py::arg("out"),
+                      py::arg("dirty"));
+
+    bind2d3d_decimation<ConvolveGaussian, unsigned, double>(m_fastfilters, "gaussian");
+    bind2d3d_decimation<ConvolveGaussian, unsigned, std::vector<double>>(m_fastfilters, "gaussian");
+    bind2d3d_decimation<ConvolveDerivative, std::vector<unsigned>, double>(m_fastfilters, "derivative");
+    bind2d3d_decimation<ConvolveDerivative, std::vector<unsigned>, std::vector<double>>(m_fastfilters, "derivative");
     bind2d3d<ConvolveGradMag, double>(m_fastfilters, "gradmag");
+    bind2d3d<ConvolveGradMag, std::vector<double>>(m_fastfilters, "gradmag");
     bind2d3d<ConvolveLaPlacian, double>(m_fastfilters, "laplacian");
+    bind2d3d<ConvolveLaPlacian, std::vector<double>>(m_fastfilters, "laplacian");
+
+    m_fastfilters.def("gaussian_multiscale2d", &gaussian_multiscale<2>, py::arg("input"), py::arg("scales"),
+                      py::arg("window_ratio") = 0.0, py::arg("voxel_size") = std::vector<double>(),
+                      py::arg("out") = py::none(), py::arg("precision") = "full", py::arg("epsilon") = 0.0);
+    m_fastfilters.def("gaussian_multiscale3d", &gaussian_multiscale<3>, py::arg("input"), py::arg("scales"),
+                      py::arg("window_ratio") = 0.0, py::arg("voxel_size") = std::vector<double>(),
+                      py::arg("out") = py::none(), py::arg("precision") = "full", py::arg("epsilon") = 0.0);
 
     bind2d3d_ev<ConvolveHessian, double>(m_fastfilters, "hog");
+    bind2d3d_ev<ConvolveHessian, std::vector<double>>(m_fastfilters, "hog");
     bind2d3d_ev<ConvolveST, double, double>(m_fastfilters, "st");
+    bind2d3d_ev<ConvolveST, std::vector<double>, std::vector<double>>(m_fastfilters, "st");
+
+    // autotune keeps the gil: it replaces the thresholds that filters running in other python threads read
+    m_fastfilters.def("autotune",
+                      [](std::string cache_path) {
+                          return fastfilters_autotune(cache_path.empty() ? NULL : cache_path.c_str());
+                      },
+                      py::arg("cache_path") = "");
+    m_fastfilters.def("tuning", []() {
+        fastfilters_tuning_t tuning;
+        fastfilters_tuning_get(&tuning);
+
+        py::dict res;
+        res["fft_min_len_inner"] = tuning.fft_min_len_inner;
+        res["fft_min_len_outer"] = tuning.fft_min_len_outer;
+        res["reduce_strip_rows"] = tuning.reduce_strip_rows;
+        res["reduce_strip_planes"] = tuning.reduce_strip_planes;
+        return res;
+    });
+
+    m_fastfilters.def("stats_enable", &fastfilters_stats_enable, py::arg("enable") = true);
+    m_fastfilters.def("stats_reset", &fastfilters_stats_reset);
+    m_fastfilters.def("stats", []() {
+        static const char *const directions[2] = {"inner", "outer"};
+        fastfilters_stats_t stats;
+        fastfilters_stats_get(&stats);
+
+        // only variants that ran are listed
+        py::dict res;
+        for (unsigned d = 0; d < 2; ++d) {
+            py::dict passes;
+
+            for (unsigned v = 0; v < FASTFILTERS_STATS_N_VARIANTS; ++v) {
+                const fastfilters_stats_pass_t &s = stats.passes[d][v];
+                if (!s.calls)
+                    continue;
+
+                py::dict pass;
+                pass["calls"] = s.calls;
+                pass["time"] = s.time_ns * 1e-9;
+                pass["pixels"] = s.pixels;
+                pass["scalar_fraction"] = s.pixels ? (double)s.scalar_pixels / s.pixels : 0.0;
+                pass["scratch_bytes"] = s.scratch_bytes;
+                passes[variant_names[v]] = pass;
+            }
+
+            res[directions[d]] = passes;
+        }
+        return res;
+    });
+
+    m_fastfilters.def("memory_stats_reset", &fastfilters_memory_stats_reset);
+    m_fastfilters.def("memory_stats", []() {
+        fastfilters_memory_stats_t stats[2];
+        fastfilters_memory_stats_get(&stats[0], &stats[1]);
+
+        // the thread is the calling python thread, which runs the filters
+        py::dict res;
+        for (unsigned i = 0; i < 2; ++i) {
+            py::dict counters;
+            counters["current_bytes"] = stats[i].current_bytes;
+            counters["peak_bytes"] = stats[i].peak_bytes;
+            counters["allocations"] = stats[i].allocations;
+            counters["largest_bytes"] = stats[i].largest_bytes;
+            res[i ? "thread" : "global"] = counters;
+        }
+        return res;
+    });
+
+    m_fastfilters.def("trace_start", [](std::string path) {
+        if (!fastfilters_trace_start(path.c_str()))
+            throw std::runtime_error("fastfilters_trace_start failed.");
+    });
+    m_fastfilters.def("trace_stop", &fastfilters_trace_stop);
+
+    m_fastfilters.def("dispatch_force",
+                      [](std::string isa, std::string path) {
+                          return fastfilters_dispatch_force(
+                              parse_name<fastfilters_isa_t>(isa_names, isa,
+                                                            "isa must be 'auto', 'plain', 'avx' or 'avxfma'."),
+                              parse_name<fastfilters_path_t>(path_names, path,
+                                                             "path must be 'auto', 'direct', 'runtime_len' or 'fft'."));
+                      },
+                      py::arg("isa") = "auto", py::arg("path") = "auto");
+    m_fastfilters.def("dispatch",
+                      [](FIRKernel &kernel, bool outer, size_t n_pixels, size_t n_channels, std::string left_border,
+                         std::string right_border) {
+                          const char *error = "border must be 'mirror', 'optimistic' or 'ptr'.";
+                          const fastfilters_border_treatment_t left =
+                              parse_name<fastfilters_border_treatment_t>(border_names, left_border, error);
+                          const fastfilters_border_treatment_t right =
+                              parse_name<fastfilters_border_treatment_t>(border_names, right_border, error);
+                          fastfilters_dispatch_t dispatch;
+
+                          if (!fastfilters_dispatch_query(kernel.kernel, left, right, outer, n_pixels, n_channels,
+                                                          &dispatch))
+                              throw std::runtime_error("fastfilters_dispatch_query failed.");
+
+                          py::dict res;
+                          res["isa"] = isa_names[dispatch.isa];
+                          res["variant"] = variant_names[dispatch.variant];
+                          res["name"] = std::string(dispatch.name);
+                          return res;
+                      },
+                      py::arg("kernel"), py::arg("outer") = false, py::arg("n_pixels") = 1024,
+                      py::arg("n_channels") = 1, py::arg("left_border") = "mirror", py::arg("right_border") = "mirror");
 }
@@ -0,0 +1,45 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+import vigra
+
+def test_anisotropic():
+    a = np.random.randn(1000000).reshape(100,100,100).astype(np.float32)[:,:90,:80]
+    a = np.ascontiguousarray(a)
+
+    sigmas = [(1.0, 2.0, 3.0), (5.0, 1.5, 1.5)]
+    step_size = (4.0, 1.0, 1.0)
+
+    for sigma in sigmas:
+        res_ff = ff.gaussianSmoothing(a, sigma)
+        res_vigra = vigra.filters.gaussianSmoothing(a, sigma)
+        print("gaussian ", sigma, np.max(np.abs(res_ff - res_vigra)))
+
+        if not np.allclose(res_ff, res_vigra, atol=1e-6):
+            raise Exception("FAIL: gaussian ", sigma, np.max(np.abs(res_ff - res_vigra)))
+
+        res_ff = ff.gaussianGradientMagnitude(a, sigma)
+        res_vigra = vigra.filters.gaussianGradientMagnitude(a, sigma)
+        print("gradmag3d ", sigma, np.max(np.abs(res_ff - res_vigra)))
+
+        if not np.allclose(res_ff, res_vigra, atol=1e-6):
+            raise Exception("FAIL: gradmag3d ", sigma, np.max(np.abs(res_ff - res_vigra)))
+
+    for sigma in [4.0, 8.0]:
+        res_ff = ff.gaussianSmoothing(a, sigma, step_size=step_size)
+        res_vigra = vigra.filters.gaussianSmoothing(a, sigma, step_size=step_size)
+        print("gaussian step_size ", sigma, np.max(np.abs(res_ff - res_vigra)))
+
+        if not np.allclose(res_ff, res_vigra, atol=1e-6):
+            raise Exception("FAIL: gaussian step_size ", sigma, np.max(np.abs(res_ff - res_vigra)))
+
+        res_ff = ff.gaussianGradientMagnitude(a, sigma, step_size=step_size)
+        res_vigra = vigra.filters.gaussianGradientMagnitude(a, sigma, step_size=step_size)
+        print("gradmag3d step_size ", sigma, np.max(np.abs(res_ff - res_vigra)))
+
+        if not np.allclose(res_ff, res_vigra, atol=1e-6):
+            raise Exception("FAIL: gradmag3d step_size ", sigma, np.max(np.abs(res_ff - res_vigra)))
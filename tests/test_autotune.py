@@ -0,0 +1,35 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+import os
+import tempfile
+
+def test_autotune():
+    a = np.random.rand(300, 280).astype(np.float32)
+    sigmas = [1.0, 5.0, 9.0, 20.0]
+    before = [ff.gaussianSmoothing(a, s) for s in sigmas]
+    grad = ff.gaussianGradientMagnitude(a, 1.5)
+
+    path = os.path.join(tempfile.mkdtemp(), "tune.txt")
+    if not ff.autotune(path):
+        raise Exception("FAIL: autotune")
+
+    with open(path) as f:
+        entries = [l for l in f if not l.startswith("#")]
+    if len(entries) != 1 or len(entries[0].split("\t")[1].split()) != 4:
+        raise Exception("FAIL: tuning cache", entries)
+
+    tuning = ff.core.tuning()
+    if min(tuning.values()) < 1:
+        raise Exception("FAIL: tuning", tuning)
+
+    # the tuned thresholds only choose between implementations of the same filter
+    for s, b in zip(sigmas, before):
+        if np.abs(ff.gaussianSmoothing(a, s) - b).max() > 1e-5:
+            raise Exception("FAIL: tuned result", s)
+    if np.abs(ff.gaussianGradientMagnitude(a, 1.5) - grad).max() > 1e-5:
+        raise Exception("FAIL: tuned gradient magnitude")
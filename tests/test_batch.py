@@ -0,0 +1,26 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def test_batch():
+    tiles = [np.random.rand(64 + i, 96).astype(np.float32) for i in range(20)]
+
+    for fn, args in [(ff.gaussianSmoothing, (2.0,)), (ff.hessianOfGaussianEigenvalues, (1.5,)),
+                     (ff.structureTensorEigenvalues, (1.0, 2.0))]:
+        for n_threads in [None, 1, 3]:
+            res = ff.batch(fn, tiles, *args, n_threads=n_threads)
+
+            if len(res) != len(tiles):
+                raise Exception("FAIL: batch returned", len(res), "results for", len(tiles), "arrays")
+
+            for tile, r in zip(tiles, res):
+                if not np.array_equal(r, fn(tile, *args)):
+                    raise Exception("FAIL: batch", fn.__name__, n_threads)
+
+    res = ff.batch(ff.gaussianSmoothing, tiles, sigma=1.0, window_size=3.0)
+    if not np.array_equal(res[5], ff.gaussianSmoothing(tiles[5], 1.0, window_size=3.0)):
+        raise Exception("FAIL: batch with keyword arguments")
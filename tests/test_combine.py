@@ -0,0 +1,71 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def reference(op, inputs):
+    inputs = [i.astype(np.float64) for i in inputs]
+    if op == "add":
+        return sum(inputs)
+    if op == "addsqrt":
+        return np.sqrt(sum(i * i for i in inputs))
+    if op == "mul":
+        return inputs[0] * inputs[1]
+    return inputs[0] * inputs[1] + inputs[2]
+
+def check_combine(combine, op, n_inputs, shape, view):
+    # inputs and out are views into larger buffers, elements outside of out's view must not change
+    bases = [np.random.rand(*shape).astype(np.float32) for i in range(n_inputs)]
+    inputs = [view(b) for b in bases]
+    out_base = np.random.rand(*shape).astype(np.float32)
+    out_before = out_base.copy()
+    out = view(out_base)
+
+    combine(op, inputs, out)
+
+    err = np.max(np.abs(out - reference(op, inputs)))
+    print("combine", op, shape, out.shape, out.strides, err)
+    if err > 1e-5:
+        raise Exception("FAIL: combine", op, shape, out.shape, out.strides, err)
+
+    outside = np.ones(shape, dtype=bool)
+    view(outside)[...] = False
+    if not np.array_equal(out_base[outside], out_before[outside]):
+        raise Exception("FAIL: combine wrote outside of out", op, shape, out.shape, out.strides)
+
+def test_combine2d():
+    views = [((100, 90), lambda a: a[::2, 1::3]),
+             ((100, 90), lambda a: a[3:70, 5:80]),
+             ((60, 70, 3), lambda a: a[:, :, 1]),
+             ((60, 70, 3), lambda a: a[::2, 1:, :2]),
+             ((60, 70, 4), lambda a: a[1::3, ::2, 1:])]
+
+    for shape, view in views:
+        for op, n_inputs in [("add", 2), ("addsqrt", 2), ("mul", 2), ("muladd", 3)]:
+            check_combine(ff.core.combine2d, op, n_inputs, shape, view)
+
+def test_combine3d():
+    views = [((20, 30, 40), lambda a: a[::2, 1::3, :]),
+             ((20, 30, 40), lambda a: a[1:15, 2:28, 3:39]),
+             ((12, 20, 25, 3), lambda a: a[:, ::2, :, 2]),
+             ((12, 20, 25, 3), lambda a: a[1:, :, 1::3, :2])]
+
+    for shape, view in views:
+        for op, n_inputs in [("add", 3), ("addsqrt", 3), ("mul", 2), ("muladd", 3)]:
+            check_combine(ff.core.combine3d, op, n_inputs, shape, view)
+
+def test_combine_errors():
+    a = np.random.rand(30, 40).astype(np.float32)
+    out = np.zeros((30, 40), dtype=np.float32)
+
+    invalid = [("sub", [a, a], out), ("add", [a], out), ("add", [a, a[:, 1:]], out), ("add", [a, a], out[:, 1:]),
+               ("add", [a, a], out[::-1]), ("add", [a, a], out.astype(np.float64))]
+    for op, inputs, o in invalid:
+        try:
+            ff.core.combine2d(op, inputs, o)
+        except ValueError:
+            continue
+        raise Exception("FAIL: combine2d accepted invalid arguments", op, len(inputs), o.shape, o.dtype)
@@ -0,0 +1,50 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def correlate(a, kernel, axis):
+    r = len(kernel) // 2
+    kernel = np.concatenate([kernel, np.zeros(1 - len(kernel) % 2)])
+    pad = [(0, 0)] * a.ndim
+    pad[axis] = (r, r)
+    a = np.pad(a.astype(np.float64), pad, mode='reflect')
+    return np.apply_along_axis(lambda l: np.correlate(l, kernel, mode='valid'), axis, a)
+
+def test_custom_kernel():
+    a = np.random.randn(200 * 150).reshape(150, 200).astype(np.float32)
+
+    kernels = [np.array([1, 4, 6, 4, 1], dtype=np.float32) / 16,
+               np.array([-1, 0, 1], dtype=np.float32),
+               np.array([0.5, -1, 2, 0.25], dtype=np.float32),
+               np.sin(np.arange(31) * 0.7).astype(np.float32)]
+
+    for kx in kernels:
+        for ky in kernels:
+            res_ff = ff.core.convolve_fir(a, [ff.core.FIRKernel(kx), ff.core.FIRKernel(ky)])
+            res_np = correlate(correlate(a, kx, 1), ky, 0)
+            print("custom kernel", len(kx), len(ky), np.max(np.abs(res_ff - res_np)))
+
+            if not np.allclose(res_ff, res_np, atol=1e-4):
+                raise Exception("FAIL: custom kernel", kx, ky, np.max(np.abs(res_ff - res_np)))
+
+def test_long_kernel():
+    # kernels this long are applied in the frequency domain
+    a = np.random.randn(300 * 257).reshape(257, 300).astype(np.float32)
+
+    x = np.arange(-60, 61)
+    kernels = [np.exp(-x**2 / 800.0).astype(np.float32) / 50,
+               (x * np.exp(-x**2 / 800.0)).astype(np.float32) / 1000,
+               np.sin(np.arange(97) * 0.3).astype(np.float32) / 40]
+
+    for kx in kernels:
+        for ky in kernels:
+            res_ff = ff.core.convolve_fir(a, [ff.core.FIRKernel(kx), ff.core.FIRKernel(ky)])
+            res_np = correlate(correlate(a, kx, 1), ky, 0)
+            print("long kernel", len(kx), len(ky), np.max(np.abs(res_ff - res_np)))
+
+            if not np.allclose(res_ff, res_np, atol=1e-4):
+                raise Exception("FAIL: long kernel", len(kx), len(ky), np.max(np.abs(res_ff - res_np)))
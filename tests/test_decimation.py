@@ -0,0 +1,33 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def check_decimation(a, sigma, order):
+    full = ff.gaussianDerivative(a, sigma, order)
+
+    for decimation in [2, 4]:
+        res = ff.gaussianDerivative(a, sigma, order, decimation=decimation)
+        if np.abs(res - full).max() > 1e-3:
+            raise Exception("FAIL: decimated", sigma, order, decimation)
+
+        dec = ff.gaussianDerivative(a, sigma, order, decimation=decimation, decimated=True)
+        ref = full[tuple(slice(None, None, decimation) for _ in a.shape)]
+        if dec.shape != ref.shape or np.abs(dec - ref).max() > 1e-3:
+            raise Exception("FAIL: decimated output", sigma, order, decimation)
+
+def test_decimation():
+    a = np.random.rand(203, 171).astype(np.float32)
+    for sigma in [8.0, 12.5]:
+        for order in [0, 1, 2]:
+            check_decimation(a, sigma, order)
+
+    check_decimation(np.random.rand(53, 61, 70).astype(np.float32), 9.0, 1)
+
+    # small scales are not decimated
+    a = np.random.rand(100, 120).astype(np.float32)
+    if not np.array_equal(ff.gaussianSmoothing(a, 1.5, decimation=4), ff.gaussianSmoothing(a, 1.5)):
+        raise Exception("FAIL: small scale decimated")
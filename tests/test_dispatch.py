@@ -0,0 +1,42 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def test_dispatch():
+    a = np.random.rand(300, 280).astype(np.float32)
+    kernel = ff.core.FIRKernel(0, 1.0)
+
+    ff.core.dispatch_force("plain", "direct")
+    ref = ff.gaussianSmoothing(a, 1.0)
+
+    try:
+        for isa in ["plain", "avx", "avxfma"]:
+            for path in ["direct", "runtime_len", "fft"]:
+                if not ff.core.dispatch_force(isa, path):
+                    continue
+
+                dispatch = ff.core.dispatch(kernel, outer=True, n_pixels=a.shape[0])
+                variant = {"direct": "unrolled"}.get(path, path)
+                if dispatch["isa"] != isa or dispatch["variant"] != variant or not dispatch["name"].startswith(isa + "_outer"):
+                    raise Exception("FAIL: dispatch", isa, path, dispatch)
+
+                res = ff.gaussianSmoothing(a, 1.0)
+                if np.max(np.abs(res - ref)) > 1e-5:
+                    raise Exception("FAIL: result", isa, path, np.max(np.abs(res - ref)))
+    finally:
+        ff.core.dispatch_force()
+
+    # mirrored lines not longer than the kernel are never transformed
+    ff.core.dispatch_force("auto", "fft")
+    try:
+        if ff.core.dispatch(kernel, n_pixels=3)["variant"] == "fft":
+            raise Exception("FAIL: short line")
+    finally:
+        ff.core.dispatch_force()
+
+    if ff.core.dispatch(kernel, n_channels=3, left_border="ptr", right_border="optimistic")["name"].find("_ptr_optimistic_") < 0:
+        raise Exception("FAIL: borders")
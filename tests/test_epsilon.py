@@ -0,0 +1,35 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def test_epsilon_radius():
+    for order in [0, 1, 2]:
+        for sigma in [2.0, 5.0, 10.0]:
+            default = ff.FIRKernel(order, sigma).len()
+            coarse = ff.FIRKernel(order, sigma, epsilon=1e-2).len()
+            fine = ff.FIRKernel(order, sigma, epsilon=1e-6).len()
+
+            if not coarse < default < fine:
+                raise Exception("FAIL: epsilon radius", order, sigma, coarse, default, fine)
+
+    # a window ratio takes precedence
+    if ff.FIRKernel(0, 4.0, window_ratio=2.0, epsilon=1e-2).len() != ff.FIRKernel(0, 4.0, window_ratio=2.0).len():
+        raise Exception("FAIL: epsilon overrides window_ratio")
+
+def test_epsilon_error():
+    # the error is bounded by epsilon times the l1 norm of the impulse response for inputs in [0, 1]
+    a = np.random.rand(150, 170).astype(np.float32)
+    delta = np.zeros(a.shape, dtype=np.float32)
+    delta[75, 85] = 1
+    for sigma in [2.0, 6.5]:
+        for order in [0, 1, 2]:
+            l1 = np.abs(ff.gaussianDerivative(delta, sigma, order, epsilon=1e-7)).sum()
+            ref = ff.gaussianDerivative(a, sigma, order, epsilon=1e-7)
+            for epsilon in [1e-2, 1e-3]:
+                res = ff.gaussianDerivative(a, sigma, order, epsilon=epsilon)
+                if np.abs(res - ref).max() > 2 * epsilon * l1:
+                    raise Exception("FAIL: epsilon error", sigma, order, epsilon)
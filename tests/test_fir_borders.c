@@ -0,0 +1,187 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+// runs the direct convolution passes of every instruction set on lines of len + 1 to 2 * len + 1 pixels with
+// optimistic and ptr borders on the left. the input holds exactly len pixels of real data on both sides of the
+// filtered axis and every buffer is allocated separately, so AddressSanitizer catches accesses outside of them.
+// lines of at least 2 * len pixels are also compared to a direct evaluation of the convolution, shorter ones with a
+// border other than mirror only have to stay within their buffers.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fastfilters.h"
+#include "common.h"
+
+typedef bool (*fir_convolve_fn_t)(const float *, size_t, size_t, size_t, size_t, float *, size_t,
+                                  fastfilters_kernel_fir_t, fastfilters_border_treatment_t,
+                                  fastfilters_border_treatment_t, const float *, const float *, size_t);
+
+typedef struct {
+    const char *name;
+    int feature;
+    fir_convolve_fn_t inner;
+    fir_convolve_fn_t outer;
+} test_isa_t;
+
+static const test_isa_t g_isas[] = {
+    {"plain", -1, &fastfilters_fir_convolve_fir_inner, &fastfilters_fir_convolve_fir_outer},
+    {"avx", FASTFILTERS_CPU_AVX, &fastfilters_fir_convolve_fir_inner_avx, &fastfilters_fir_convolve_fir_outer_avx},
+    {"avxfma", FASTFILTERS_CPU_FMA, &fastfilters_fir_convolve_fir_inner_avxfma,
+     &fastfilters_fir_convolve_fir_outer_avxfma}};
+
+static const char *g_border_names[] = {"mirror", "optimistic", "ptr"};
+
+#define N_ELEMS(a) (sizeof(a) / sizeof((a)[0]))
+
+// coefficients -len to len of a kernel with the given symmetry
+static void test_coefs(unsigned symmetry, size_t len, float *coefs)
+{
+    for (size_t k = 0; k <= len; ++k) {
+        const float c = 1.0f / (float)(k + 1);
+
+        coefs[len + k] = c;
+        coefs[len - k] = symmetry == 0 ? c : symmetry == 1 ? -c : 0.5f * c;
+    }
+
+    if (symmetry == 1)
+        coefs[len] = 0.0f;
+}
+
+// one pass over n_lines lines of n_pixels pixels with n_channels channels. pixel p of line l is
+// l * line_stride + p * pixel_stride + c of the padded input, with p from -len to n_pixels + len - 1.
+static bool test_pass(const test_isa_t *isa, bool outer, const float *coefs, size_t len, size_t n_pixels,
+                      size_t n_lines, size_t n_channels, fastfilters_border_treatment_t left,
+                      fastfilters_border_treatment_t right)
+{
+    bool result = false;
+    const size_t n_padded = n_pixels + 2 * len;
+    const size_t pixel_stride = outer ? n_lines * n_channels : n_channels;
+    const size_t line_stride = outer ? n_channels : n_padded * n_channels;
+    const size_t out_pixel_stride = pixel_stride;
+    const size_t out_line_stride = outer ? n_channels : n_pixels * n_channels;
+    const size_t border_stride = outer ? pixel_stride : len * n_channels;
+    fastfilters_kernel_fir_t kernel = fastfilters_kernel_fir_create(coefs, 2 * len + 1);
+    float *in = malloc(n_padded * n_lines * n_channels * sizeof(float));
+    float *out = malloc(n_pixels * n_lines * n_channels * sizeof(float));
+    float *border_left = malloc(len * n_lines * n_channels * sizeof(float));
+    float *border_right = malloc(len * n_lines * n_channels * sizeof(float));
+
+    if (!kernel || !in || !out || !border_left || !border_right)
+        goto out;
+
+    for (size_t i = 0; i < n_padded * n_lines * n_channels; ++i)
+        in[i] = (float)rand() / (float)RAND_MAX;
+
+    // the ptr borders hold the same pixels as the padding, but in buffers of their own
+    for (size_t l = 0; l < n_lines; ++l)
+        for (size_t j = 0; j < len; ++j)
+            for (size_t c = 0; c < n_channels; ++c) {
+                const size_t b =
+                    outer ? j * border_stride + l * n_channels + c : l * border_stride + j * n_channels + c;
+
+                border_left[b] = in[l * line_stride + j * pixel_stride + c];
+                border_right[b] = in[l * line_stride + (len + n_pixels + j) * pixel_stride + c];
+            }
+
+    const float *inptr = in + len * pixel_stride;
+    fir_convolve_fn_t fn = outer ? isa->outer : isa->inner;
+
+    if (!fn(inptr, n_pixels, outer ? pixel_stride : n_channels, outer ? n_lines * n_channels : n_lines,
+            outer ? 1 : line_stride, out, outer ? out_pixel_stride : out_line_stride, kernel, left, right,
+            left == FASTFILTERS_BORDER_PTR ? border_left : NULL,
+            right == FASTFILTERS_BORDER_PTR ? border_right : NULL, border_stride))
+        goto out;
+
+    result = true;
+    if (n_pixels < 2 * len)
+        goto out;
+
+    for (size_t l = 0; l < n_lines; ++l)
+        for (size_t p = 0; p < n_pixels; ++p)
+            for (size_t c = 0; c < n_channels; ++c) {
+                double sum = 0.0;
+
+                for (long k = -(long)len; k <= (long)len; ++k) {
+                    long q = (long)p + k;
+
+                    if (q >= (long)n_pixels && right == FASTFILTERS_BORDER_MIRROR)
+                        q = 2 * (long)n_pixels - 2 - q;
+                    sum += coefs[len + k] * in[l * line_stride + (size_t)(q + (long)len) * pixel_stride + c];
+                }
+
+                const float value = out[l * out_line_stride + p * out_pixel_stride + c];
+                if (fabs(value - sum) > 1e-4 * (1.0 + fabs(sum))) {
+                    printf("FAIL: %s %s %s/%s len %u pixels %u channels %u: %g instead of %g at %u\n", isa->name,
+                           outer ? "outer" : "inner", g_border_names[left], g_border_names[right], (unsigned)len,
+                           (unsigned)n_pixels, (unsigned)n_channels, value, sum, (unsigned)p);
+                    result = false;
+                    goto out;
+                }
+            }
+
+out:
+    if (kernel)
+        fastfilters_kernel_fir_free(kernel);
+    free(in);
+    free(out);
+    free(border_left);
+    free(border_right);
+    return result;
+}
+
+int main(void)
+{
+    const fastfilters_border_treatment_t lefts[] = {FASTFILTERS_BORDER_OPTIMISTIC, FASTFILTERS_BORDER_PTR};
+    const fastfilters_border_treatment_t rights[] = {FASTFILTERS_BORDER_MIRROR, FASTFILTERS_BORDER_OPTIMISTIC,
+                                                     FASTFILTERS_BORDER_PTR};
+    // one line of interleaved rgb pixels along x, and lines not filling a vector along y
+    const size_t channels[] = {1, 3};
+    float coefs[4 * FF_UNROLL + 1];
+    unsigned n_failed = 0, n_passes = 0;
+
+    fastfilters_init();
+
+    for (size_t i = 0; i < N_ELEMS(g_isas); ++i) {
+        if (g_isas[i].feature >= 0 && !fastfilters_cpu_check((fastfilters_cpu_feature_t)g_isas[i].feature))
+            continue;
+
+        for (unsigned outer = 0; outer <= 1; ++outer)
+            for (unsigned symmetry = 0; symmetry < 3; ++symmetry)
+                // the unrolled lengths and one runtime length
+                for (size_t len = 1; len <= 2 * FF_UNROLL; len = len < FF_UNROLL ? len + 1 : 2 * len) {
+                    test_coefs(symmetry, len, coefs);
+
+                    // the passes need more pixels than the kernel length
+                    for (size_t n_pixels = len + 1; n_pixels <= 2 * len + 1; ++n_pixels)
+                        for (size_t c = 0; c < N_ELEMS(channels); ++c)
+                            for (size_t a = 0; a < N_ELEMS(lefts); ++a)
+                                for (size_t b = 0; b < N_ELEMS(rights); ++b) {
+                                    ++n_passes;
+                                    if (!test_pass(&g_isas[i], outer, coefs, len, n_pixels, outer ? 5 : 3,
+                                                   channels[c], lefts[a], rights[b]))
+                                        ++n_failed;
+                                }
+                }
+    }
+
+    printf("%u of %u passes failed\n", n_failed, n_passes);
+    return n_failed ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+// fastfilters
+// Copyright (c) 2016 Sven Peter
+// sven.peter@iwr.uni-heidelberg.de or mail@svenpeter.me
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+// every 3d eigenvalue entry point has to reach the kernel of the requested precision: planar, interleaved and strided
+// outputs of the same precision are compared bit by bit, and the fast results have to stay within 1e-4 of the
+// eigenvalue spread of the full ones.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fastfilters.h"
+
+#define LEN 5000
+#define STRIDE 5
+
+static float g_a[6][LEN];
+
+static unsigned check_precision(fastfilters_precision_t precision, const float *full, float *max_err)
+{
+    static float ev[3][LEN], interleaved[3 * LEN], strided[STRIDE * LEN];
+    unsigned n_failed = 0;
+
+    fastfilters_linalg_ev3d_ex(g_a[0], g_a[1], g_a[2], g_a[3], g_a[4], g_a[5], ev[0], ev[1], ev[2], LEN, precision);
+    fastfilters_linalg_ev3d_interleaved(g_a[0], g_a[1], g_a[2], g_a[3], g_a[4], g_a[5], interleaved, LEN, precision);
+    fastfilters_linalg_ev3d_strided(g_a[0], g_a[1], g_a[2], g_a[3], g_a[4], g_a[5], strided, STRIDE, LEN,
+                                    precision);
+
+    *max_err = 0;
+    for (size_t i = 0; i < LEN; ++i) {
+        const float spread = fabsf(full[3 * i] - full[3 * i + 2]) + 1e-6f;
+
+        for (size_t k = 0; k < 3; ++k) {
+            const float err = fabsf(ev[k][i] - full[3 * i + k]) / spread;
+
+            if (ev[k][i] != interleaved[3 * i + k] || ev[k][i] != strided[STRIDE * i + k]) {
+                if (n_failed++ < 10)
+                    printf("FAIL: precision %d pixel %zu eigenvalue %zu: planar %g interleaved %g strided %g\n",
+                           (int)precision, i, k, ev[k][i], interleaved[3 * i + k], strided[STRIDE * i + k]);
+            }
+            if (err > *max_err)
+                *max_err = err;
+        }
+    }
+
+    return n_failed;
+}
+
+int main(void)
+{
+    static float full[3 * LEN], ev[3][LEN];
+    float err_full, err_fast;
+    unsigned n_failed = 0;
+
+    fastfilters_init();
+
+    srand(42);
+    for (size_t k = 0; k < 6; ++k)
+        for (size_t i = 0; i < LEN; ++i)
+            g_a[k][i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+
+    // the original planar entry point is the full precision one
+    fastfilters_linalg_ev3d(g_a[0], g_a[1], g_a[2], g_a[3], g_a[4], g_a[5], ev[0], ev[1], ev[2], LEN);
+    for (size_t i = 0; i < LEN; ++i)
+        for (size_t k = 0; k < 3; ++k)
+            full[3 * i + k] = ev[k][i];
+
+    n_failed += check_precision(FASTFILTERS_PRECISION_FULL, full, &err_full);
+    n_failed += check_precision(FASTFILTERS_PRECISION_FAST, full, &err_fast);
+    if (err_full != 0 || err_fast > 1e-4f) {
+        printf("FAIL: error relative to the eigenvalue spread full %g fast %g\n", err_full, err_fast);
+        ++n_failed;
+    }
+
+    printf("%u failures, fast error %g\n", n_failed, err_fast);
+    return n_failed ? 1 : 0;
+}
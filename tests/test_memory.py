@@ -0,0 +1,55 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def test_memory():
+    a = np.random.rand(40, 50, 60).astype(np.float32)
+
+    ff.core.memory_stats_reset()
+    before = ff.core.memory_stats()
+    ff.structureTensorEigenvalues(a, 1.0, 2.0)
+    after = ff.core.memory_stats()
+
+    for scope in ["global", "thread"]:
+        # the three gradient components are held at once
+        if after[scope]["peak_bytes"] < before[scope]["current_bytes"] + 3 * a.nbytes:
+            raise Exception("FAIL: peak", scope, before, after)
+        if after[scope]["largest_bytes"] < a.nbytes or after[scope]["allocations"] < 3:
+            raise Exception("FAIL: allocations", scope, after)
+        if after[scope]["current_bytes"] != before[scope]["current_bytes"]:
+            raise Exception("FAIL: leak", scope, before, after)
+
+    ff.core.memory_stats_reset()
+    stats = ff.core.memory_stats()
+    if stats["thread"]["allocations"] != 0 or stats["thread"]["peak_bytes"] != stats["thread"]["current_bytes"]:
+        raise Exception("FAIL: reset", stats)
+
+def test_memory_reset_concurrent():
+    from multiprocessing.pool import ThreadPool
+    a = np.random.rand(30, 40, 50).astype(np.float32)
+
+    ff.core.memory_stats_reset()
+    before = ff.core.memory_stats()
+
+    # the filters release the GIL, resets race with their allocations
+    pool = ThreadPool(4)
+    jobs = [pool.apply_async(ff.gaussianGradientMagnitude, (a, 2.0)) for i in range(16)]
+    while not all(job.ready() for job in jobs):
+        ff.core.memory_stats_reset()
+        stats = ff.core.memory_stats()
+        if stats["global"]["peak_bytes"] < 0 or stats["global"]["current_bytes"] < 0:
+            raise Exception("FAIL: concurrent reset", stats)
+    for job in jobs:
+        job.get()
+    pool.close()
+
+    ff.core.memory_stats_reset()
+    after = ff.core.memory_stats()
+    if after["global"]["current_bytes"] != before["global"]["current_bytes"]:
+        raise Exception("FAIL: leak", before, after)
+    if after["global"]["peak_bytes"] != after["global"]["current_bytes"] or after["global"]["allocations"] != 0:
+        raise Exception("FAIL: reset", after)
@@ -0,0 +1,35 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def check_multiscale(a, scales):
+    full = ff.gaussianSmoothingMultiscale(a, scales)
+    fast = ff.gaussianSmoothingMultiscale(a, scales, precision="fast")
+
+    if full.shape != (len(scales),) + a.shape:
+        raise Exception("FAIL: multiscale shape", full.shape)
+
+    for i, s in enumerate(scales):
+        ref = ff.gaussianSmoothing(a, s)
+        if not np.array_equal(full[i], ref):
+            raise Exception("FAIL: multiscale full precision", s)
+        if np.abs(fast[i] - ref).max() > 2e-2 * np.abs(ref).max():
+            raise Exception("FAIL: multiscale fast precision", s)
+
+def test_multiscale():
+    check_multiscale(np.random.rand(200, 220).astype(np.float32), [0.7, 1.0, 1.6, 3.5, 5.0, 10.0])
+    check_multiscale(np.random.rand(100, 120, 3).astype(np.float32), [1.0, 2.0, 1.5, 4.0])
+    check_multiscale(np.random.rand(50, 60, 70).astype(np.float32), [1.0, 2.0, 1.5, 4.0])
+
+def test_multiscale_out():
+    a = np.random.rand(80, 90).astype(np.float32)
+    scales = [1.0, 2.5]
+    out = np.zeros((len(scales),) + a.shape, dtype=np.float32)
+
+    res = ff.gaussianSmoothingMultiscale(a, scales, out=out)
+    if res is not out or not np.array_equal(out, ff.gaussianSmoothingMultiscale(a, scales)):
+        raise Exception("FAIL: multiscale out")
@@ -0,0 +1,60 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def check_out(fn, a, *args):
+    ref = fn(a, *args)
+
+    out = np.empty_like(ref)
+    res = fn(a, *args, out=out)
+    if res is not out or not np.array_equal(out, ref):
+        raise Exception("FAIL: out", fn.__name__)
+
+    # views into a feature stack, with the feature axis first and last
+    stack = np.zeros((3,) + ref.shape, dtype=np.float32)
+    fn(a, *args, out=stack[1])
+    if not np.array_equal(stack[1], ref) or np.any(stack[0]) or np.any(stack[2]):
+        raise Exception("FAIL: out in feature stack", fn.__name__)
+
+    stack = np.zeros(ref.shape + (3,), dtype=np.float32)
+    fn(a, *args, out=stack[..., 2])
+    if not np.array_equal(stack[..., 2], ref) or np.any(stack[..., :2]):
+        raise Exception("FAIL: out in interleaved feature stack", fn.__name__)
+
+def test_out():
+    for a in [np.random.rand(200, 150).astype(np.float32), np.random.rand(30, 40, 50).astype(np.float32)]:
+        check_out(ff.gaussianSmoothing, a, 1.5)
+        check_out(ff.gaussianGradientMagnitude, a, 2.0)
+        check_out(ff.laplacianOfGaussian, a, 1.0)
+        check_out(ff.hessianOfGaussianEigenvalues, a, 1.5)
+        check_out(ff.structureTensorEigenvalues, a, 1.0, 2.0)
+        check_out(ff.gaussianDerivative, a, 2.0, [1] + [0] * (a.ndim - 1))
+
+def test_out_invalid():
+    a = np.random.rand(100, 120).astype(np.float32)
+
+    for out in [np.empty((100, 121), dtype=np.float32), np.empty((100, 120), dtype=np.float64)]:
+        try:
+            ff.gaussianSmoothing(a, 1.0, out=out)
+        except ValueError:
+            continue
+        raise Exception("FAIL: invalid out accepted", out.shape, out.dtype)
+
+def test_out_feature_columns():
+    for a in [np.random.rand(120, 90).astype(np.float32), np.random.rand(20, 30, 40).astype(np.float32)]:
+        features = np.zeros(a.shape + (9,), dtype=np.float32)
+        n_ev = a.ndim
+
+        ff.hessianOfGaussianEigenvalues(a, 1.5, out=features[..., 1:1 + n_ev])
+        ff.structureTensorEigenvalues(a, 1.0, 2.0, out=features[..., 5:5 + n_ev])
+
+        if not np.array_equal(features[..., 1:1 + n_ev], ff.hessianOfGaussianEigenvalues(a, 1.5)) or \
+           not np.array_equal(features[..., 5:5 + n_ev], ff.structureTensorEigenvalues(a, 1.0, 2.0)):
+            raise Exception("FAIL: eigenvalues in feature columns", a.shape)
+
+        if np.any(features[..., 0]) or np.any(features[..., 1 + n_ev:5]) or np.any(features[..., 5 + n_ev:]):
+            raise Exception("FAIL: eigenvalues written outside of their feature columns", a.shape)
@@ -0,0 +1,33 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def check_fast(fn, a, *args):
+    full = fn(a, *args)
+    fast = fn(a, *args, precision="fast")
+
+    scale = np.abs(full).max()
+    if np.abs(fast - full).max() > 1e-3 * scale:
+        raise Exception("FAIL: fast precision", fn.__name__)
+
+def test_precision():
+    a = np.random.rand(40, 50, 60).astype(np.float32)
+    check_fast(ff.hessianOfGaussianEigenvalues, a, 1.5)
+    check_fast(ff.structureTensorEigenvalues, a, 1.0, 2.0)
+
+    # 2d has no approximate kernel
+    a = np.random.rand(100, 120).astype(np.float32)
+    if not np.array_equal(ff.hessianOfGaussianEigenvalues(a, 1.5, precision="fast"),
+                          ff.hessianOfGaussianEigenvalues(a, 1.5)):
+        raise Exception("FAIL: fast precision 2d")
+
+    try:
+        ff.hessianOfGaussianEigenvalues(a, 1.5, precision="medium")
+    except ValueError:
+        pass
+    else:
+        raise Exception("FAIL: invalid precision accepted")
@@ -0,0 +1,41 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def test_stats():
+    a = np.random.rand(300, 280).astype(np.float32)
+
+    ff.core.stats_enable()
+    ff.core.stats_reset()
+    ff.gaussianSmoothing(a, 1.0)
+    stats = ff.core.stats()
+
+    # one pass along each axis with a kernel of 4 coefficients per side
+    for direction in ["inner", "outer"]:
+        passes = stats[direction]
+        if list(passes.keys()) != ["unrolled"] or passes["unrolled"]["calls"] != 1:
+            raise Exception("FAIL: variants", direction, passes)
+        if passes["unrolled"]["pixels"] != a.size or not 0.0 <= passes["unrolled"]["scalar_fraction"] <= 1.0:
+            raise Exception("FAIL: pixels", direction, passes)
+    if stats["outer"]["unrolled"]["scratch_bytes"] <= 0:
+        raise Exception("FAIL: scratch", stats)
+
+    # every channel counts, whichever implementation ran
+    rgb = np.random.rand(300, 280, 3).astype(np.float32)
+    ff.core.stats_reset()
+    ff.gaussianSmoothing(rgb, 1.0)
+    stats = ff.core.stats()
+    for direction in ["inner", "outer"]:
+        if sum(p["pixels"] for p in stats[direction].values()) != rgb.size:
+            raise Exception("FAIL: channels", direction, stats)
+
+    ff.core.stats_reset()
+    ff.core.stats_enable(False)
+    ff.gaussianSmoothing(a, 1.0)
+    stats = ff.core.stats()
+    if stats["inner"] or stats["outer"]:
+        raise Exception("FAIL: disabled", stats)
@@ -0,0 +1,47 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+import json
+import os
+import tempfile
+
+def test_trace():
+    a = np.random.rand(300, 280).astype(np.float32)
+    fd, path = tempfile.mkstemp(suffix=".json")
+    os.close(fd)
+
+    try:
+        ff.core.trace_start(path)
+        ff.gaussianSmoothing(a, 1.0)
+        ff.hessianOfGaussianEigenvalues(a, 1.0)
+        ff.core.trace_stop()
+
+        with open(path) as f:
+            events = [e for e in json.load(f)["traceEvents"] if e["ph"] in "BE"]
+    finally:
+        os.remove(path)
+
+    names = set(e["name"] for e in events)
+    if "derivative2d" not in names or "hog2d" not in names or "inner unrolled" not in names:
+        raise Exception("FAIL: events", names)
+
+    # events nest per thread
+    stacks = {}
+    for e in events:
+        stack = stacks.setdefault(e["tid"], [])
+        if e["ph"] == "B":
+            if e["cat"] not in ["filter", "pass"] or e["args"]["bytes"] <= 0:
+                raise Exception("FAIL: begin", e)
+            stack.append(e)
+        elif not stack or stack.pop()["name"] != e["name"]:
+            raise Exception("FAIL: end", e)
+    if any(stacks.values()):
+        raise Exception("FAIL: unterminated", stacks)
+
+    derivative = [e for e in events if e["name"] == "derivative2d" and e["ph"] == "B"][0]
+    if derivative["args"]["bytes"] != 2 * a.size * 4:
+        raise Exception("FAIL: bytes", derivative)
@@ -0,0 +1,65 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+
+def dirty_regions(shape):
+    # regions touching each border along every axis, and a single pixel in the middle
+    regions = []
+    for axis in range(len(shape)):
+        n = shape[axis]
+        for begin, end in [(0, 3), (n - 3, n), (0, n)]:
+            region = [(n_other // 2 - 2, n_other // 2 + 2) for n_other in shape]
+            region[axis] = (begin, end)
+            regions.append(region)
+    regions.append([(n // 2, n // 2 + 1) for n in shape])
+    return regions
+
+def check_update(shape, n_axes, sigma, orders):
+    kernels = [ff.core.FIRKernel(order, sigma) for order in orders]
+    spatial = shape[:n_axes]
+
+    for region in dirty_regions(spatial):
+        a = np.random.rand(*shape).astype(np.float32)
+        out = ff.core.convolve_fir(a, kernels)
+
+        sl = tuple(slice(begin, end) for begin, end in region)
+        a[sl] = np.random.rand(*a[sl].shape).astype(np.float32)
+
+        # kernels and regions are given x first
+        updated = ff.core.convolve_fir_update(a, kernels, out, region[::-1])
+        full = ff.core.convolve_fir(a, kernels)
+
+        err = np.max(np.abs(out - full))
+        print("update", shape, sigma, orders, region, err)
+        if err > 1e-4:
+            raise Exception("FAIL: update differs from a full recompute", shape, sigma, orders, region, err)
+
+        for (begin, end), (ubegin, uend) in zip(region, updated[::-1]):
+            if ubegin > begin or uend < end:
+                raise Exception("FAIL: updated region does not contain the dirty region", region, updated)
+
+def test_update2d():
+    for sigma in [1.0, 5.0]:
+        check_update((60, 70), 2, sigma, [0, 1])
+        check_update((40, 50, 3), 2, sigma, [2, 0])
+
+def test_update3d():
+    for sigma in [1.0, 5.0]:
+        check_update((20, 25, 30), 3, sigma, [0, 1, 2])
+
+def test_update_errors():
+    a = np.random.rand(30, 40).astype(np.float32)
+    kernels = [ff.core.FIRKernel(0, 1.0), ff.core.FIRKernel(0, 1.0)]
+
+    unusable = [np.zeros((30, 41), dtype=np.float32), np.zeros((30, 40)),
+                np.zeros((30, 40), dtype=np.float32)[:, ::-1]]
+    for out in unusable:
+        try:
+            ff.core.convolve_fir_update(a, kernels, out, [(0, 1), (0, 1)])
+        except ValueError:
+            continue
+        raise Exception("FAIL: convolve_fir_update accepted an unusable out", out.shape, out.dtype)
@@ -24,6 +24,16 @@ def test_vigra_compare3d():
                 raise Exception("FAIL: ", order, sigma, np.max(np.abs(res_ff - res_vigra)))
 
 
+    for order in [[1,0,2], [0,2,1], [2,1,0]]:
+        for sigma in sigmas:
+            res_ff = ff.gaussianDerivative(a, sigma, order)
+            res_vigra = vigra.filters.gaussianDerivative(a, sigma, order)
+
+            print("gaussian mixed ", order, sigma, np.max(np.abs(res_ff - res_vigra)), np.sum(np.abs(res_ff-res_vigra))/np.size(res_vigra))
+
+            if not np.allclose(res_ff, res_vigra, atol=1e-6):
+                raise Exception("FAIL: mixed ", order, sigma, np.max(np.abs(res_ff - res_vigra)))
+
     for sigma in sigmas:
         res_ff = ff.gaussianGradientMagnitude(a, sigma)
         res_vigra = vigra.filters.gaussianGradientMagnitude(a, sigma)
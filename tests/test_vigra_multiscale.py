@@ -0,0 +1,35 @@
+from __future__ import print_function
+
+import sys
+print("\nexecuting test file", __file__, file=sys.stderr)
+exec(compile(open('set_paths.py', "rb").read(), 'set_paths.py', 'exec'))
+import fastfilters as ff
+import numpy as np
+import vigra
+
+def check_multiscale_tagged(a, scales):
+    res = ff.gaussianSmoothingMultiscale(a, scales)
+    squeezed = a.squeeze()
+    keys = "".join(tag.key for tag in res.axistags)
+    print("multiscale", a.axistags, a.shape, keys, res.shape)
+
+    if keys != "c" + "".join(tag.key for tag in squeezed.axistags):
+        raise Exception("FAIL: multiscale axistags", a.axistags, keys)
+    if res.shape != (len(scales),) + squeezed.shape:
+        raise Exception("FAIL: multiscale shape", a.axistags, res.shape)
+
+    for i, s in enumerate(scales):
+        ref = ff.gaussianSmoothing(squeezed, s)
+        if not np.array_equal(np.asarray(res)[i], np.asarray(ref)):
+            raise Exception("FAIL: multiscale", a.axistags, s)
+
+def test_vigra_multiscale():
+    scales = [1.0, 2.5, 4.0]
+    a = np.random.rand(60, 70).astype(np.float32)
+    v = np.random.rand(20, 30, 40).astype(np.float32)
+
+    check_multiscale_tagged(vigra.taggedView(a, "yx"), scales)
+    check_multiscale_tagged(vigra.taggedView(a, "xy"), scales)
+    check_multiscale_tagged(vigra.taggedView(a[:, :, np.newaxis], "yxc"), scales)
+    check_multiscale_tagged(vigra.taggedView(v, "zyx"), scales)
+    check_multiscale_tagged(vigra.taggedView(v[np.newaxis], "tzyx"), scales)